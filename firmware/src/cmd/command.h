@@ -8,6 +8,7 @@
 
 #include "cmd/timer.h"
 #include "one_wire/one_wire_address.h"
+#include "util/fixed_string.h"
 
 namespace owif {
 namespace cmd {
@@ -26,11 +27,20 @@ enum class SubAction : std::uint8_t {
   ReadResult = 0x02,       // e.g. DS18B20: Read sampled temperature after sampling time
 };
 
+/*!
+ * \brief Scheduling priority of a command. Interactive commands preempt periodic (subscription triggered) commands.
+ */
+enum class CommandPriority : std::uint8_t {
+  Interactive = 0x00,  // Ad-hoc requests, e.g. received via MQTT
+  Periodic = 0x01,     // Cyclic commands triggered by subscriptions
+};
+
 enum class DeviceAttributeType : std::uint8_t {
   Presence = 0x00,
   Temperature = 0x01,
   VAD = 0x02,
   VDD = 0x03,
+  All = 0xFF,  // Wildcard '*' of subscriptions: All measured attributes (excludes 'presence')
 };
 
 struct TimeIntervalType {
@@ -38,40 +48,176 @@ struct TimeIntervalType {
   type value;
 };
 
-union CommandParamValue {
-  one_wire::OneWireAddress device_id;
-  one_wire::OneWireAddress::FamilyCode family_code;
-  DeviceAttributeType device_attribute;
-  TimeIntervalType interval;
+enum class DeadbandType : std::uint8_t {
+  Absolute = 0x00,  // Deadband in the unit of the attribute
+  Relative = 0x01,  // Deadband in percent of the last published value
 };
 
-struct CommandParam {
-  bool param_available;           // Flag indicating if the optional parameter is available or not
-  CommandParamValue param_value;  // The parameter value
+/*!
+ * \brief Publishing filter of a subscription. Evaluated against the last published value of every device.
+ */
+struct SubscriptionFilter {
+  float deadband;              // Min. change of the value to be published. 0: any change
+  std::uint32_t max_silence;   // Max. time [ms] without publishing an unchanged value. 0: disabled
+  DeadbandType deadband_type;  // Absolute or relative deadband
+  bool on_change;              // Publish changed values only. Implicitly set by a deadband.
 };
 
+/*!
+ * \brief Aggregates of a windowed subscription (bit mask).
+ */
+enum class Aggregate : std::uint8_t {
+  Min = 0x01,
+  Max = 0x02,
+  Mean = 0x04,
+  Last = 0x08,
+  Count = 0x10,
+};
+
+/*!
+ * \brief Windowed aggregation of a subscription. The sampled values are aggregated and published once per window.
+ */
+struct SubscriptionAggregation {
+  std::uint32_t publish_interval;  // Length [ms] of the aggregation window. 0: aggregation disabled
+  std::uint8_t aggregates;         // Bit mask of published aggregates (see Aggregate)
+};
+
+/*!
+ * \brief Adaptive sampling of a subscription. The interval is halved while the values change quickly and doubled while
+ *        they are flat, within [min_interval, max_interval].
+ */
+struct SubscriptionAdaptation {
+  std::uint32_t min_interval;  // Min. interval [ms]
+  std::uint32_t max_interval;  // Max. interval [ms]. 0: adaptive sampling disabled
+  float delta;                 // Change per read above which the interval is shortened. 0: any change
+};
+
+/*!
+ * \brief Options of a subscription. Only used by subscribes and kept by the subscription, not by its cyclic reads.
+ */
+struct SubscriptionOptions {
+  SubscriptionFilter filter;            // Publish all values if filter.on_change is not set
+  SubscriptionAggregation aggregation;  // Publish every value if aggregation.publish_interval is 0
+  SubscriptionAdaptation adaptation;    // Fixed interval if adaptation.max_interval is 0
+};
+
+/*!
+ * \brief Compact parameter storage of a command: addressing (device_id or family_code, exclusive), device_attribute
+ *        (read, subscribe, unsubscribe) and interval (subscribe). The options of a subscribe are passed as attachment
+ *        (see Command::subscription_options).
+ */
+struct CommandParams {
+  union Address {
+    one_wire::OneWireAddress device_id;
+    one_wire::OneWireAddress::FamilyCode family_code;
+  };
+
+  Address address;                       // Valid if has_device_id or has_family_code is set
+  TimeIntervalType interval;             // Valid if has_interval is set
+  DeviceAttributeType device_attribute;  // Valid if has_device_attribute is set
+  bool has_device_id : 1;
+  bool has_family_code : 1;
+  bool has_device_attribute : 1;
+  bool has_interval : 1;
+  bool all_devices : 1;     // Wildcard subscription of all available devices (device_id '*')
+  bool all_attributes : 1;  // Wildcard subscription of all measured attributes. Set on the reads of its read plan.
+};
+
+enum class RequestIdType : std::uint8_t {
+  None = 0x00,    // No request id provided by the requester
+  Number = 0x01,  // Numeric request id
+  String = 0x02,  // String request id
+};
+
+/*!
+ * \brief Optional request id provided by the requester. Echoed in all results and errors of the command.
+ */
+struct RequestId {
+  using NumberType = std::uint32_t;
+  static constexpr std::uint16_t kMaxStringLength{32};
+  using StringType = util::FixedString<kMaxStringLength>;
+
+  RequestIdType type;
+  NumberType number;
+  StringType string;
+};
+
+/*!
+ * \brief Handle of a command attachment, e.g. a reply topic (see CommandAttachments).
+ */
+using AttachmentHandle = std::uint8_t;
+static constexpr AttachmentHandle kNoAttachment{0xFF};
+
+/*!
+ * \brief Request id of a command. A string id is interned in the command attachments, so the commands do not carry
+ *        its characters.
+ */
+struct CommandRequestId {
+  RequestIdType type;
+  std::uint32_t value;  // Number: the request id. String: handle of its attachment.
+};
+
+/*!
+ * \brief Optional response topic provided by the requester. All results and errors of the command, including the
+ *        results of a subscription, are published on this topic instead of the status topic.
+ */
+struct ReplyTo {
+  static constexpr std::uint16_t kMaxLength{64};
+  using StringType = util::FixedString<kMaxLength>;
+
+  StringType topic;  // Empty: Responses are published on the status topic
+};
+
+/*!
+ * \brief Machine-readable classification of error responses.
+ */
+enum class ErrorCode : std::uint8_t {
+  Generic = 0x00,  // Generic failure. Details are described by the error message.
+  Busy = 0x01,     // Command rejected or dropped due to overload. Retry later.
+  Expired = 0x02,  // Command dropped as its deadline was exceeded before execution.
+};
+
+/*!
+ * \brief Payload format of a request. The responses of the command are sent in the same format.
+ */
+enum class PayloadFormat : std::uint8_t {
+  Json = 0x00,     // JSON text
+  MsgPack = 0x01,  // MessagePack (binary)
+};
+
+struct Command;  // forward declaration due to circular dependency
+
 struct CommandResultCallback {
-  void (*func)(void* ctx, JsonDocument& command_result);
+  void (*func)(void* ctx, Command const& cmd, JsonDocument& command_result);
   void* ctx;
 };
 struct ErrorResultCallback {
-  void (*func)(void* ctx, char const* error_message, char const* request_json);
+  void (*func)(void* ctx, Command const& cmd, ErrorCode error_code, char const* error_message,
+               char const* request_json);
   void* ctx;
 };
 
+/*!
+ * \brief Command passed through the command queues. Sized for the pool: Strings and subscription options are not
+ *        stored inline but referenced as attachments (see CommandAttachments).
+ */
 struct Command {
   Timer timer;
-  Action action;
-  SubAction sub_action;
-  CommandParam param1;
-  CommandParam param2;
-  CommandParam param3;
-  CommandParam param4;
+  Timer deadline;      // Optional deadline for the start of the command execution. Disabled if the delay is 0.
+  Timer result_timer;  // Optional earliest start of the result step (SubAction::ReadResult). Disabled if expired.
+  CommandParams params;
   CommandResultCallback result_callback;
   ErrorResultCallback error_result_callback;
+  CommandRequestId request_id;
+  Action action;
+  SubAction sub_action;
+  CommandPriority priority;
+  PayloadFormat payload_format;
+  AttachmentHandle reply_to;              // Topic of the responses. kNoAttachment: status topic
+  AttachmentHandle subscription_options;  // Subscribe only. kNoAttachment: Defaults (all options disabled)
 };
 
-// Check that commands are trivially copyable. Required for command queue.
+// Check that commands are trivially copyable. Required for the command pool and subscriptions.
 static_assert(std::is_trivially_copyable<Command>::value);
 
 }  // namespace cmd
@@ -0,0 +1,140 @@
+// ---- Includes ----
+#include "cmd/command_attachments.h"
+
+#include <cstring>
+
+namespace owif {
+namespace cmd {
+
+static_assert(CommandAttachments::kCapacity < kNoAttachment, "Attachment handles exceed their type");
+
+// ---- Public APIs ----------------------------------------------------------------------------------------------------
+
+/*!
+ * Adds a reference to the entry of the text. An equal text in use is shared. An empty text is not stored.
+ * \param[out] handle Attachment of the text. kNoAttachment for an empty text.
+ * \return False if the text exceeds kMaxTextLength or all entries are in use.
+ */
+auto CommandAttachments::AddText(char const* text, AttachmentHandle& handle) -> bool {
+  bool result{false};
+  handle = kNoAttachment;
+
+  std::size_t const text_length{std::strlen(text)};
+  if (text_length == 0) {
+    result = true;
+  } else if (text_length <= kMaxTextLength) {
+    std::lock_guard<std::mutex> lock_guard{mutex_};
+
+    for (std::size_t i{0}; (i < kCapacity) && (handle == kNoAttachment); ++i) {
+      Entry const& entry{entries_[i]};
+      if ((entry.references > 0) && (entry.type == AttachmentType::Text) && (std::strcmp(entry.text, text) == 0)) {
+        handle = static_cast<AttachmentHandle>(i);
+      }
+    }
+    if (handle == kNoAttachment) {
+      handle = FindUnusedEntry();
+      if (handle != kNoAttachment) {
+        entries_[handle].type = AttachmentType::Text;
+        std::strcpy(entries_[handle].text, text);
+      }
+    }
+    if (handle != kNoAttachment) {
+      ++entries_[handle].references;
+      result = true;
+    }
+  }
+
+  return result;
+}
+
+/*!
+ * \param[out] handle Attachment of the options
+ * \return False if all entries are in use
+ */
+auto CommandAttachments::AddSubscriptionOptions(SubscriptionOptions const& options, AttachmentHandle& handle) -> bool {
+  std::lock_guard<std::mutex> lock_guard{mutex_};
+
+  handle = FindUnusedEntry();
+  if (handle != kNoAttachment) {
+    entries_[handle].type = AttachmentType::SubscriptionOptions;
+    entries_[handle].subscription_options = options;
+    entries_[handle].references = 1;
+  }
+
+  return handle != kNoAttachment;
+}
+
+auto CommandAttachments::Retain(AttachmentHandle handle) -> void {
+  if (handle != kNoAttachment) {
+    std::lock_guard<std::mutex> lock_guard{mutex_};
+    ++entries_[handle].references;
+  }
+}
+
+/*!
+ * The entry becomes unused with its last reference.
+ */
+auto CommandAttachments::Release(AttachmentHandle handle) -> void {
+  if (handle != kNoAttachment) {
+    std::lock_guard<std::mutex> lock_guard{mutex_};
+    if (entries_[handle].references > 0) {
+      --entries_[handle].references;
+    }
+  }
+}
+
+/*!
+ * Adds a reference to every attachment of the command, e.g. when it is copied into the command pool.
+ */
+auto CommandAttachments::Retain(Command const& cmd) -> void {
+  Retain(GetRequestIdAttachment(cmd));
+  Retain(cmd.reply_to);
+  Retain(cmd.subscription_options);
+}
+
+auto CommandAttachments::Release(Command const& cmd) -> void {
+  Release(GetRequestIdAttachment(cmd));
+  Release(cmd.reply_to);
+  Release(cmd.subscription_options);
+}
+
+/*!
+ * The text stays valid as long as the caller holds a reference to the attachment.
+ * \return Text of the attachment or an empty string for kNoAttachment
+ */
+auto CommandAttachments::GetText(AttachmentHandle handle) const -> char const* {
+  return handle != kNoAttachment ? entries_[handle].text : "";
+}
+
+/*!
+ * \return Options of the attachment or the defaults (all options disabled) for kNoAttachment
+ */
+auto CommandAttachments::GetSubscriptionOptions(AttachmentHandle handle) const -> SubscriptionOptions {
+  return handle != kNoAttachment ? entries_[handle].subscription_options : SubscriptionOptions{};
+}
+
+// ---- Private APIs ---------------------------------------------------------------------------------------------------
+
+/*!
+ * \return Unused entry or kNoAttachment if all entries are in use. Called with the mutex locked.
+ */
+auto CommandAttachments::FindUnusedEntry() -> AttachmentHandle {
+  AttachmentHandle handle{kNoAttachment};
+  for (std::size_t i{0}; (i < kCapacity) && (handle == kNoAttachment); ++i) {
+    if (entries_[i].references == 0) {
+      handle = static_cast<AttachmentHandle>(i);
+    }
+  }
+  return handle;
+}
+
+auto CommandAttachments::GetRequestIdAttachment(Command const& cmd) -> AttachmentHandle {
+  return cmd.request_id.type == RequestIdType::String ? static_cast<AttachmentHandle>(cmd.request_id.value)
+                                                      : kNoAttachment;
+}
+
+// ---- Global Instance ----
+CommandAttachments command_attachments_g{};
+
+}  // namespace cmd
+}  // namespace owif
@@ -0,0 +1,78 @@
+#ifndef OWIF_CMD_COMMAND_ATTACHMENTS_H
+#define OWIF_CMD_COMMAND_ATTACHMENTS_H
+
+// ---- Includes ----
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "cmd/command.h"
+
+namespace owif {
+namespace cmd {
+
+/*!
+ * \brief Reference counted side table of the optional, variable-size parts of commands: reply topics, string request
+ *        ids and subscription options. Commands only carry the handles of their attachments, so the command pool and
+ *        the subscriptions are not sized for the longest strings. Texts are interned: The commands of a reply topic
+ *        share one entry.
+ *        References are held by the command pool (per slot), the subscriptions and the request being processed.
+ *        Thread-safe. Attachments are added in the MQTT task and released in the main loop.
+ */
+class CommandAttachments final {
+ public:
+  static constexpr std::size_t kCapacity{96};
+  static constexpr std::size_t kMaxTextLength{ReplyTo::kMaxLength};
+
+  CommandAttachments() = default;
+
+  CommandAttachments(CommandAttachments const&) = delete;
+  auto operator=(CommandAttachments const&) -> CommandAttachments& = delete;
+  CommandAttachments(CommandAttachments&&) = delete;
+  auto operator=(CommandAttachments&&) -> CommandAttachments& = delete;
+
+  ~CommandAttachments() = default;
+
+  // ---- Public APIs --------------------------------------------------------------------------------------------------
+
+  auto AddText(char const* text, AttachmentHandle& handle) -> bool;
+  auto AddSubscriptionOptions(SubscriptionOptions const& options, AttachmentHandle& handle) -> bool;
+
+  auto Retain(AttachmentHandle handle) -> void;
+  auto Release(AttachmentHandle handle) -> void;
+  auto Retain(Command const& cmd) -> void;
+  auto Release(Command const& cmd) -> void;
+
+  auto GetText(AttachmentHandle handle) const -> char const*;
+  auto GetSubscriptionOptions(AttachmentHandle handle) const -> SubscriptionOptions;
+
+ private:
+  enum class AttachmentType : std::uint8_t {
+    Text = 0x00,
+    SubscriptionOptions = 0x01,
+  };
+
+  struct Entry {
+    std::uint16_t references;  // 0: Entry unused
+    AttachmentType type;
+    union {
+      char text[kMaxTextLength + 1];
+      SubscriptionOptions subscription_options;
+    };
+  };
+
+  auto FindUnusedEntry() -> AttachmentHandle;
+  static auto GetRequestIdAttachment(Command const& cmd) -> AttachmentHandle;
+
+  std::mutex mutex_{};
+  std::array<Entry, kCapacity> entries_{};
+};
+
+extern CommandAttachments command_attachments_g;
+
+}  // namespace cmd
+}  // namespace owif
+
+#endif  // OWIF_CMD_COMMAND_ATTACHMENTS_H
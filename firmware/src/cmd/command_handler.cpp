@@ -8,24 +8,43 @@
 #include "cmd/ds2438_command_handler.h"
 #include "cmd/json_builder.h"
 #include "cmd/json_constants.h"
+#include "config/persistency.h"
 #include "logging/status_led.h"
+#include "util/json_allocator.h"
+#include "util/language.h"
 
 namespace owif {
 namespace cmd {
 
 // ---- Public APIs ----------------------------------------------------------------------------------------------------
 
-auto CommandHandler::Begin(one_wire::OneWireSystem* one_wire_system, std::uint32_t command_queue_size) -> bool {
+/*!
+ * \param[in] subscription_result_callback Result callback of the subscriptions restored from persistency
+ * \param[in] subscription_error_result_callback Error callback of the subscriptions restored from persistency
+ */
+auto CommandHandler::Begin(one_wire::OneWireSystem* one_wire_system,
+                           CommandResultCallback const& subscription_result_callback,
+                           ErrorResultCallback const& subscription_error_result_callback,
+                           std::uint16_t command_pool_size, std::uint16_t max_subscriptions) -> bool {
   bool result{true};
 
   logger_.Debug(F("[CmdHandler] Setup..."));
   one_wire_system_ = one_wire_system;
-  command_queue_ = xQueueCreate(command_queue_size, sizeof(cmd::Command));
+
+  result &= command_pool_.Begin(command_pool_size);
+  // Every lane can hold all pooled commands, so queuing a handle of a pooled command never fails.
+  for (QueueHandle_t& command_queue : command_queues_) {
+    command_queue = xQueueCreate(command_pool_size, sizeof(CommandHandle));
+    result &= (command_queue != nullptr);
+  }
 
   presence_command_handler_ = PresenceCommandHandler{this, one_wire_system_};
   ds18b20_command_handler_ = Ds18b20CommandHandler{this, one_wire_system_};
   ds2438_command_handler_ = Ds2438CommandHandler{this, one_wire_system_};
-  subscriptions_manager_ = SubscriptionsManager{this};
+  subscriptions_manager_ = SubscriptionsManager{this, one_wire_system_, max_subscriptions};
+  subscriptions_manager_.Restore(config::persistency_g.LoadSubscriptionsConfig(), subscription_result_callback,
+                                 subscription_error_result_callback);
+  UpdateSubscriptionsStatistics();
 
   return result;
 }
@@ -35,60 +54,146 @@ auto CommandHandler::Loop() -> void {
   subscriptions_manager_.Loop();
 }
 
+/*!
+ * Enqueue a new command. The command is copied into the command pool and rejected with a 'busy' error response if the
+ * pool is exhausted.
+ */
 auto CommandHandler::EnqueueCommand(Command const& cmd) -> bool {
   bool result{false};
 
-  BaseType_t const queue_send_result{xQueueSend(command_queue_, &cmd, /* xTicksToWait= */ 0)};
-  if (queue_send_result == pdPASS) {
-    result = true;
+  CommandHandle handle{0};
+  if (command_pool_.Acquire(cmd, handle)) {
+    result = QueueCommandHandle(cmd.priority, handle);
+    if (not result) {
+      command_pool_.Release(handle);
+    }
+  }
+
+  if (not result) {
+    {
+      std::lock_guard<std::mutex> lock_guard{statistics_mutex_};
+      ++statistics_[ToUnderlying(cmd.priority)].rejected;
+    }
+    logger_.Warn(F("[CmdHandler] Command pool exhausted. Rejecting command [action=%u][priority=%u]"), cmd.action,
+                 cmd.priority);
+    SendErrorResponse(cmd, ErrorCode::Busy, "Command queue full. Request rejected, retry later.");
+  }
+
+  return result;
+}
+
+/*!
+ * Re-enqueue the in-progress command (e.g. next sub-action step or command not yet due). The command keeps its pool
+ * slot, only its handle is queued again. Hence accepted commands are completed also under overload: Every lane holds
+ * all handles of the pool (see Begin()), so the queuing only fails for a command which is not pooled.
+ */
+auto CommandHandler::RequeueCommand(Command const& cmd) -> bool {
+  bool result{false};
+
+  CommandHandle handle{0};
+  if (command_pool_.GetHandle(cmd, handle)) {
+    result = QueueCommandHandle(cmd.priority, handle);
+    current_command_requeued_ = result;
   } else {
-    logger_.Error(F("[CmdHandler] Write to command queue failed!"));
+    logger_.Error(F("[CmdHandler] Re-enqueued command is not a pooled command"));
+  }
+
+  if (not result) {
+    logger_.Error(F("[CmdHandler] Failed to re-enqueue command. Dropping in-progress command [action=%u][priority=%u]"),
+                  cmd.action, cmd.priority);
+    SendErrorResponse(cmd, "Failed to re-enqueue command. In-progress request dropped.");
   }
 
   return result;
 }
 
+/*!
+ * Serves the interactive lane first. After kMaxConsecutiveInteractiveCommands interactive commands in a row the
+ * periodic lane is served first once, so subscriptions cannot be starved by a flood of interactive requests.
+ * A lane whose head command is not yet due is skipped in favor of the next lane.
+ */
 auto CommandHandler::ProcessCommandQueue() -> void {
-  cmd::Command cmd{};
+  bool const periodic_pending{uxQueueMessagesWaiting(command_queues_[ToUnderlying(CommandPriority::Periodic)]) > 0};
+  bool const periodic_first{periodic_pending &&
+                            (consecutive_interactive_commands_ >= kMaxConsecutiveInteractiveCommands)};
+
+  if (periodic_first && ProcessCommandQueue(CommandPriority::Periodic)) {
+    consecutive_interactive_commands_ = 0;
+  } else if (ProcessCommandQueue(CommandPriority::Interactive)) {
+    if (periodic_pending && (consecutive_interactive_commands_ < kMaxConsecutiveInteractiveCommands)) {
+      ++consecutive_interactive_commands_;
+    }
+  } else if (not periodic_first && ProcessCommandQueue(CommandPriority::Periodic)) {
+    consecutive_interactive_commands_ = 0;
+  }
+}
 
-  BaseType_t const queue_receive_result{xQueueReceive(command_queue_, &cmd, /* xTicksToWait= */ 0)};
+auto CommandHandler::ProcessCommandQueue(CommandPriority priority) -> bool {
+  bool processed{false};
+  CommandHandle handle{0};
 
-  if (queue_receive_result == pdTRUE) {
-    if (cmd.timer.IsExpired()) {
-      logging::status_led_g.Off();
-
-      switch (cmd.action) {
-        case cmd::Action::Restart:
-          ProcessActionRestart(cmd);
-          break;
-        case cmd::Action::Scan:
-          ProcessActionScan(cmd);
-          break;
-        case cmd::Action::Read:
-          ProcessActionRead(cmd);
-          break;
-        case cmd::Action::Subscribe:
-          ProcessActionSubscribe(cmd);
-          break;
-        case cmd::Action::Unsubscribe:
-          ProcessActionUnsubscribe(cmd);
-          break;
-        default:
-          logger_.Error(F("[CmdHandler] Unknown/Unsupport command action type: %u"), cmd.action);
-          SendErrorResponse(cmd, "Unknown/Unsupport command action type");
-      }
+  QueueHandle_t const command_queue{command_queues_[ToUnderlying(priority)]};
+  BaseType_t const queue_receive_result{xQueueReceive(command_queue, &handle, /* xTicksToWait= */ 0)};
 
-      logging::status_led_g.On();
+  if (queue_receive_result == pdTRUE) {
+    Command& cmd{command_pool_.Get(handle)};
+    current_command_requeued_ = false;
 
+    // The result step of a read may additionally be held back until a given time, e.g. the tick of a subscription
+    bool const result_step_due{(cmd.sub_action != SubAction::ReadResult) || cmd.result_timer.IsExpired()};
+    if (cmd.timer.IsExpired() && result_step_due) {
+      // Deadline only applies to the start of a command. Started multi-step commands are always completed.
+      bool const deadline_exceeded{(cmd.sub_action == SubAction::None) && (cmd.deadline.GetDelay() > 0) &&
+                                   cmd.deadline.IsExpired()};
+      if (deadline_exceeded) {
+        ProcessExpiredCommand(cmd);
+      } else {
+        ProcessCommand(cmd);
+        processed = true;
+      }
     } else {
-      EnqueueCommand(cmd);
+      RequeueCommand(cmd);
+    }
+
+    // Release the pool slot unless the command (or its next step) was re-enqueued
+    if (not current_command_requeued_) {
+      command_pool_.Release(handle);
     }
   }
+
+  return processed;
+}
+
+auto CommandHandler::ProcessCommand(Command& cmd) -> void {
+  logging::status_led_g.Off();
+
+  switch (cmd.action) {
+    case cmd::Action::Restart:
+      ProcessActionRestart(cmd);
+      break;
+    case cmd::Action::Scan:
+      ProcessActionScan(cmd);
+      break;
+    case cmd::Action::Read:
+      ProcessActionRead(cmd);
+      break;
+    case cmd::Action::Subscribe:
+      ProcessActionSubscribe(cmd);
+      break;
+    case cmd::Action::Unsubscribe:
+      ProcessActionUnsubscribe(cmd);
+      break;
+    default:
+      logger_.Error(F("[CmdHandler] Unknown/Unsupport command action type: %u"), cmd.action);
+      SendErrorResponse(cmd, "Unknown/Unsupport command action type");
+  }
+
+  logging::status_led_g.On();
 }
 
 auto CommandHandler::SendCommandResponse(Command const& cmd, JsonDocument& json) -> void {
   if (cmd.result_callback.func != nullptr && cmd.result_callback.ctx != nullptr) {
-    cmd.result_callback.func(cmd.result_callback.ctx, json);
+    cmd.result_callback.func(cmd.result_callback.ctx, cmd, json);
   } else {
     logger_.Error(F("[CmdHandler] Invalid command result callback / ctx provided"));
   }
@@ -96,20 +201,123 @@ auto CommandHandler::SendCommandResponse(Command const& cmd, JsonDocument& json)
 
 auto CommandHandler::SendErrorResponse(Command const& cmd, char const* error_message, char const* request_json)
     -> void {
+  SendErrorResponse(cmd, ErrorCode::Generic, error_message, request_json);
+}
+
+auto CommandHandler::SendErrorResponse(Command const& cmd, ErrorCode error_code, char const* error_message,
+                                       char const* request_json) -> void {
   if (cmd.error_result_callback.func != nullptr && cmd.error_result_callback.ctx != nullptr) {
-    cmd.error_result_callback.func(cmd.error_result_callback.ctx, error_message, request_json);
+    cmd.error_result_callback.func(cmd.error_result_callback.ctx, cmd, error_code, error_message, request_json);
   } else {
     logger_.Error(F("[CmdHandler] Invalid command result callback / ctx provided"));
   }
 }
 
+auto CommandHandler::AddStatistics(JsonObject& json) -> void {
+  JsonObject json_pool{json[json::kStatisticsCommandPool].to<JsonObject>()};
+  json_pool[json::kStatisticsSize] = command_pool_.GetUsed();
+  json_pool[json::kStatisticsCapacity] = command_pool_.GetCapacity();
+  json_pool[json::kStatisticsHighWaterMark] = command_pool_.GetHighWaterMark();
+
+  JsonObject json_queues{json[json::kStatisticsCommandQueues].to<JsonObject>()};
+
+  JsonObject json_interactive{json_queues[json::kStatisticsInteractive].to<JsonObject>()};
+  AddQueueStatistics(json_interactive, CommandPriority::Interactive);
+
+  JsonObject json_periodic{json_queues[json::kStatisticsPeriodic].to<JsonObject>()};
+  AddQueueStatistics(json_periodic, CommandPriority::Periodic);
+
+  SubscriptionsStatistics subscriptions_statistics{};
+  {
+    std::lock_guard<std::mutex> lock_guard{statistics_mutex_};
+    subscriptions_statistics = subscriptions_statistics_;
+  }
+
+  JsonObject json_subscriptions{json[json::kStatisticsSubscriptions].to<JsonObject>()};
+  json_subscriptions[json::kStatisticsSize] = subscriptions_statistics.size;
+  json_subscriptions[json::kStatisticsCapacity] = subscriptions_statistics.capacity;
+  json_subscriptions[json::kStatisticsMemory] = subscriptions_statistics.memory;
+
+  util::JsonPoolStatistics const json_pool_statistics{util::json_allocator_g.GetStatistics()};
+  JsonObject json_json_pool{json[json::kStatisticsJsonPool].to<JsonObject>()};
+  json_json_pool[json::kStatisticsSize] = json_pool_statistics.size;
+  json_json_pool[json::kStatisticsCapacity] = json_pool_statistics.capacity;
+  json_json_pool[json::kStatisticsHighWaterMark] = json_pool_statistics.high_water_mark;
+  json_json_pool[json::kStatisticsFallbacks] = json_pool_statistics.fallbacks;
+}
+
 // ---- Private APIs ---------------------------------------------------------------------------------------------------
 
+auto CommandHandler::QueueCommandHandle(CommandPriority priority, CommandHandle handle) -> bool {
+  bool result{false};
+
+  QueueHandle_t const command_queue{command_queues_[ToUnderlying(priority)]};
+  BaseType_t const queue_send_result{xQueueSend(command_queue, &handle, /* xTicksToWait= */ 0)};
+  if (queue_send_result == pdPASS) {
+    result = true;
+    UpdateHighWaterMark(priority);
+  }
+
+  return result;
+}
+
+/*!
+ * Periodic commands are dropped silently as the next subscription interval supersedes them. Interactive requesters
+ * are informed with an 'expired' error response.
+ */
+auto CommandHandler::ProcessExpiredCommand(Command& cmd) -> void {
+  {
+    std::lock_guard<std::mutex> lock_guard{statistics_mutex_};
+    ++statistics_[ToUnderlying(cmd.priority)].expired;
+  }
+
+  logger_.Warn(F("[CmdHandler] Deadline of %u ms exceeded. Dropping command [action=%u][priority=%u]"),
+               cmd.deadline.GetDelay(), cmd.action, cmd.priority);
+  if (cmd.priority == CommandPriority::Interactive) {
+    SendErrorResponse(cmd, ErrorCode::Expired, "Command deadline exceeded before execution. Request dropped.");
+  }
+}
+
+auto CommandHandler::UpdateHighWaterMark(CommandPriority priority) -> void {
+  std::uint32_t const queue_size{uxQueueMessagesWaiting(command_queues_[ToUnderlying(priority)])};
+
+  std::lock_guard<std::mutex> lock_guard{statistics_mutex_};
+  CommandQueueStatistics& statistics{statistics_[ToUnderlying(priority)]};
+  if (queue_size > statistics.high_water_mark) {
+    statistics.high_water_mark = queue_size;
+  }
+}
+
+/*!
+ * The subscriptions are only modified in the main loop. Statistics are requested from the MQTT task, so a snapshot is
+ * taken after each change.
+ */
+auto CommandHandler::UpdateSubscriptionsStatistics() -> void {
+  SubscriptionsStatistics const subscriptions_statistics{subscriptions_manager_.GetStatistics()};
+
+  std::lock_guard<std::mutex> lock_guard{statistics_mutex_};
+  subscriptions_statistics_ = subscriptions_statistics;
+}
+
+auto CommandHandler::AddQueueStatistics(JsonObject& json, CommandPriority priority) -> void {
+  CommandQueueStatistics statistics{};
+  {
+    std::lock_guard<std::mutex> lock_guard{statistics_mutex_};
+    statistics = statistics_[ToUnderlying(priority)];
+  }
+
+  json[json::kStatisticsSize] = uxQueueMessagesWaiting(command_queues_[ToUnderlying(priority)]);
+  json[json::kStatisticsCapacity] = command_pool_.GetCapacity();
+  json[json::kStatisticsHighWaterMark] = statistics.high_water_mark;
+  json[json::kStatisticsRejected] = statistics.rejected;
+  json[json::kStatisticsExpired] = statistics.expired;
+}
+
 /*!
  * no parameters
  */
 auto CommandHandler::ProcessActionRestart(Command& cmd) -> void {
-  JsonDocument response_json{};
+  JsonDocument response_json{&util::json_allocator_g};
   response_json[json::kRootAction] = json::kActionRestart;
   response_json[json::kActionRestartAcknowledge] = true;
 
@@ -120,13 +328,12 @@ auto CommandHandler::ProcessActionRestart(Command& cmd) -> void {
 }
 
 /*!
- * param1: [Optional] device_id
- * param2: [Optional] family_code
+ * params: [Optional] device_id or family_code
  */
 auto CommandHandler::ProcessActionScan(Command& cmd) -> void {
-  if (cmd.param1.param_available) {
+  if (cmd.params.has_device_id) {
     presence_command_handler_.ProcessPresenceSingleDevice(cmd, json::kActionScan, /*add_device_attributes=*/true);
-  } else if (cmd.param2.param_available) {
+  } else if (cmd.params.has_family_code) {
     presence_command_handler_.ProcessPresenceDeviceFamily(cmd, json::kActionScan, /*add_device_attributes=*/true);
   } else {
     presence_command_handler_.ProcessPresenceScanAll(cmd);
@@ -134,20 +341,18 @@ auto CommandHandler::ProcessActionScan(Command& cmd) -> void {
 }
 
 /*!
- * param1: [Optional] device_id
- * param2: [Optional] family_code
- * param3: device_attribute
+ * params: [Optional] device_id or family_code, device_attribute
  */
 auto CommandHandler::ProcessActionRead(Command& cmd) -> void {
   logger_.Debug(F("[CmdHandler] Processing command 'read'"));
-  if (cmd.param3.param_available) {
-    if (cmd.param1.param_available) {
+  if (cmd.params.has_device_attribute) {
+    if (cmd.params.has_device_id) {
       // ---- Read a specific device ----
-      if (cmd.param3.param_value.device_attribute == DeviceAttributeType::Presence) {
+      if (cmd.params.device_attribute == DeviceAttributeType::Presence) {
         // Dispatch handling of attribute 'presence' to PresenceHandler instead of device family specific handlers.
         presence_command_handler_.ProcessPresenceSingleDevice(cmd, json::kActionRead, /*add_device_attributes=*/false);
       } else {
-        one_wire::OneWireAddress const& device_addr{cmd.param1.param_value.device_id};
+        one_wire::OneWireAddress const& device_addr{cmd.params.address.device_id};
         one_wire::OneWireAddress::FamilyCode const family_code{device_addr.GetFamilyCode()};
         switch (family_code) {
           case one_wire::Ds2438::kFamilyCode:
@@ -161,13 +366,13 @@ auto CommandHandler::ProcessActionRead(Command& cmd) -> void {
             break;
         }
       }
-    } else if (cmd.param2.param_available) {
+    } else if (cmd.params.has_family_code) {
       // ---- Read a specific device family ----
-      if (cmd.param3.param_value.device_attribute == DeviceAttributeType::Presence) {
+      if (cmd.params.device_attribute == DeviceAttributeType::Presence) {
         // Dispatch handling of attribute 'presence' to PresenceHandler instead of device family specific handlers.
         presence_command_handler_.ProcessPresenceDeviceFamily(cmd, json::kActionRead, /*add_device_attributes=*/false);
       } else {
-        one_wire::OneWireAddress::FamilyCode const& family_code{cmd.param2.param_value.family_code};
+        one_wire::OneWireAddress::FamilyCode const& family_code{cmd.params.address.family_code};
         switch (family_code) {
           case one_wire::Ds2438::kFamilyCode:
             ds2438_command_handler_.ProcessReadDeviceFamily(cmd);
@@ -187,29 +392,26 @@ auto CommandHandler::ProcessActionRead(Command& cmd) -> void {
 }
 
 /*!
- * param1: [Optional] device_id
- * param2: [Optional] family_code
- * param3: device_attribute
- * param4: interval
+ * params: [Optional] device_id or family_code, device_attribute, interval
  */
 auto CommandHandler::ProcessActionSubscribe(Command& cmd) -> void {
   logger_.Debug(F("[CmdHandler] Processing command 'subscribe'"));
-  if (cmd.param3.param_available && cmd.param4.param_available) {
+  if (cmd.params.has_device_attribute && cmd.params.has_interval) {
     subscriptions_manager_.ProcessActionSubscribe(cmd);
+    UpdateSubscriptionsStatistics();
   } else {
     SendErrorResponse(cmd, "Missing device_attribute or interval parameter");
   }
 }
 
 /*!
- * param1: [Optional] device_id
- * param2: [Optional] family_code
- * param3: device_attribute
+ * params: [Optional] device_id or family_code, device_attribute
  */
 auto CommandHandler::ProcessActionUnsubscribe(Command& cmd) -> void {
   logger_.Debug(F("[CmdHandler] Processing command 'unsubscribe'"));
-  if (cmd.param3.param_available) {
+  if (cmd.params.has_device_attribute) {
     subscriptions_manager_.ProcessActionUnsubscribe(cmd);
+    UpdateSubscriptionsStatistics();
   } else {
     SendErrorResponse(cmd, "Missing device_attribute parameter");
   }
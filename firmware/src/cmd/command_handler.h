@@ -6,7 +6,11 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 
+#include <array>
+#include <mutex>
+
 #include "cmd/command.h"
+#include "cmd/command_pool.h"
 #include "cmd/ds18b20_command_handler.h"
 #include "cmd/ds2438_command_handler.h"
 #include "cmd/presence_command_handler.h"
@@ -19,6 +23,15 @@ namespace cmd {
 
 class CommandHandler {
  public:
+  /*!
+   * \brief Load statistics of a single command queue lane.
+   */
+  struct CommandQueueStatistics {
+    std::uint32_t high_water_mark;  // Max. number of queued commands since startup
+    std::uint32_t rejected;         // New commands rejected with a 'busy' error due to an exhausted command pool
+    std::uint32_t expired;          // Commands dropped as their deadline was exceeded before execution
+  };
+
   CommandHandler() = default;
 
   CommandHandler(CommandHandler const&) = delete;
@@ -28,20 +41,43 @@ class CommandHandler {
 
   // ---- Public APIs --------------------------------------------------------------------------------------------------
 
-  auto Begin(one_wire::OneWireSystem* one_wire_system, std::uint32_t command_queue_size = kDefaultCommandQueueSize)
-      -> bool;
+  auto Begin(one_wire::OneWireSystem* one_wire_system, CommandResultCallback const& subscription_result_callback,
+             ErrorResultCallback const& subscription_error_result_callback,
+             std::uint16_t command_pool_size = kDefaultCommandPoolSize,
+             std::uint16_t max_subscriptions = SubscriptionsManager::kDefaultMaxSubscriptions) -> bool;
   auto Loop() -> void;
 
   auto EnqueueCommand(Command const& cmd) -> bool;
+  auto RequeueCommand(Command const& cmd) -> bool;
 
   auto SendCommandResponse(Command const& cmd, JsonDocument& json) -> void;
   auto SendErrorResponse(Command const& cmd, char const* error_message, char const* request_json = "") -> void;
+  auto SendErrorResponse(Command const& cmd, ErrorCode error_code, char const* error_message,
+                         char const* request_json = "") -> void;
+
+  auto AddStatistics(JsonObject& json) -> void;
 
  private:
   using DeviceMap = one_wire::OneWireSystem::DeviceMap;
-  static constexpr std::uint32_t kDefaultCommandQueueSize{100};
+  // Commands are stored in a pool shared by all lanes. The lanes only queue handles and are sized to the pool.
+  static constexpr std::uint16_t kDefaultCommandPoolSize{200};
+
+  // Number of priority lanes (see CommandPriority). Index of a lane equals the underlying priority value.
+  static constexpr std::size_t kCommandPriorities{2};
+
+  // Max. number of consecutive interactive commands executed while periodic commands are pending (starvation
+  // protection of the periodic lane).
+  static constexpr std::uint8_t kMaxConsecutiveInteractiveCommands{8};
 
   auto ProcessCommandQueue() -> void;
+  auto ProcessCommandQueue(CommandPriority priority) -> bool;
+  auto QueueCommandHandle(CommandPriority priority, CommandHandle handle) -> bool;
+  auto ProcessCommand(Command& cmd) -> void;
+  auto ProcessExpiredCommand(Command& cmd) -> void;
+
+  auto UpdateHighWaterMark(CommandPriority priority) -> void;
+  auto AddQueueStatistics(JsonObject& json, CommandPriority priority) -> void;
+  auto UpdateSubscriptionsStatistics() -> void;
 
   auto ProcessActionRestart(Command& cmd) -> void;
   auto ProcessActionScan(Command& cmd) -> void;
@@ -52,12 +88,19 @@ class CommandHandler {
   logging::Logger& logger_{logging::logger_g};
 
   one_wire::OneWireSystem* one_wire_system_;
-  QueueHandle_t command_queue_{};
+  CommandPool command_pool_{};
+  std::array<QueueHandle_t, kCommandPriorities> command_queues_{};  // Queues of CommandHandle
+  bool current_command_requeued_{false};                            // Command currently processed was re-enqueued
+  std::uint8_t consecutive_interactive_commands_{0};
+
+  std::mutex statistics_mutex_{};  // Commands are enqueued from the MQTT task and the main loop
+  std::array<CommandQueueStatistics, kCommandPriorities> statistics_{};
+  SubscriptionsStatistics subscriptions_statistics_{};  // Snapshot taken in the main loop after each change
 
   PresenceCommandHandler presence_command_handler_{nullptr, nullptr};  // valid init in Begin()
   Ds18b20CommandHandler ds18b20_command_handler_{nullptr, nullptr};    // valid init in Begin()
   Ds2438CommandHandler ds2438_command_handler_{nullptr, nullptr};      // valid init in Begin()
-  SubscriptionsManager subscriptions_manager_{nullptr};
+  SubscriptionsManager subscriptions_manager_{nullptr, nullptr};       // valid init in Begin()
 };
 
 extern CommandHandler command_handler_g;
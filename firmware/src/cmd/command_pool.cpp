@@ -0,0 +1,87 @@
+// ---- Includes ----
+#include "cmd/command_pool.h"
+
+#include <cstdint>
+
+#include "cmd/command_attachments.h"
+
+namespace owif {
+namespace cmd {
+
+// ---- Public APIs ----------------------------------------------------------------------------------------------------
+
+auto CommandPool::Begin(std::uint16_t capacity) -> bool {
+  std::lock_guard<std::mutex> lock_guard{mutex_};
+
+  slots_.resize(capacity);
+  free_handles_.clear();
+  free_handles_.reserve(capacity);
+  // Push in reverse order to hand out the lowest slots first
+  for (std::uint16_t i{capacity}; i > 0; --i) {
+    free_handles_.push_back(static_cast<CommandHandle>(i - 1));
+  }
+  high_water_mark_ = 0;
+
+  return capacity > 0;
+}
+
+/*!
+ * Copies the command into a free slot. The slot holds a reference to the attachments of the command until released.
+ * Fails if the pool is exhausted.
+ */
+auto CommandPool::Acquire(Command const& cmd, CommandHandle& handle) -> bool {
+  bool result{false};
+
+  std::lock_guard<std::mutex> lock_guard{mutex_};
+  if (not free_handles_.empty()) {
+    handle = free_handles_.back();
+    free_handles_.pop_back();
+    slots_[handle] = cmd;
+    command_attachments_g.Retain(cmd);
+
+    std::uint16_t const used{static_cast<std::uint16_t>(slots_.size() - free_handles_.size())};
+    if (used > high_water_mark_) {
+      high_water_mark_ = used;
+    }
+    result = true;
+  }
+
+  return result;
+}
+
+auto CommandPool::Release(CommandHandle handle) -> void {
+  std::lock_guard<std::mutex> lock_guard{mutex_};
+  command_attachments_g.Release(slots_[handle]);
+  free_handles_.push_back(handle);
+}
+
+auto CommandPool::Get(CommandHandle handle) -> Command& { return slots_[handle]; }
+
+/*!
+ * Determine the handle of a command residing in the pool. Fails if the command is not a pooled command.
+ */
+auto CommandPool::GetHandle(Command const& cmd, CommandHandle& handle) const -> bool {
+  bool result{false};
+
+  if (not slots_.empty() && (&cmd >= slots_.data()) && (&cmd < slots_.data() + slots_.size())) {
+    handle = static_cast<CommandHandle>(&cmd - slots_.data());
+    result = true;
+  }
+
+  return result;
+}
+
+auto CommandPool::GetCapacity() const -> std::uint16_t { return static_cast<std::uint16_t>(slots_.size()); }
+
+auto CommandPool::GetUsed() -> std::uint16_t {
+  std::lock_guard<std::mutex> lock_guard{mutex_};
+  return static_cast<std::uint16_t>(slots_.size() - free_handles_.size());
+}
+
+auto CommandPool::GetHighWaterMark() -> std::uint16_t {
+  std::lock_guard<std::mutex> lock_guard{mutex_};
+  return high_water_mark_;
+}
+
+}  // namespace cmd
+}  // namespace owif
@@ -0,0 +1,58 @@
+#ifndef OWIF_CMD_COMMAND_POOL_H
+#define OWIF_CMD_COMMAND_POOL_H
+
+// ---- Includes ----
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "cmd/command.h"
+
+namespace owif {
+namespace cmd {
+
+/*!
+ * \brief Handle of a pooled command. Only the handle is passed through the command queues.
+ */
+using CommandHandle = std::uint16_t;
+
+/*!
+ * \brief Fixed-size pool of commands. Commands are copied once into a free slot when enqueued and stay in the slot
+ *        until processing finished, including re-enqueued steps of multi-step commands.
+ */
+class CommandPool final {
+ public:
+  CommandPool() = default;
+
+  CommandPool(CommandPool const&) = delete;
+  auto operator=(CommandPool const&) -> CommandPool& = delete;
+  CommandPool(CommandPool&&) = delete;
+  auto operator=(CommandPool&&) -> CommandPool& = delete;
+
+  // ---- Public APIs --------------------------------------------------------------------------------------------------
+
+  auto Begin(std::uint16_t capacity) -> bool;
+
+  auto Acquire(Command const& cmd, CommandHandle& handle) -> bool;
+  auto Release(CommandHandle handle) -> void;
+
+  auto Get(CommandHandle handle) -> Command&;
+  auto GetHandle(Command const& cmd, CommandHandle& handle) const -> bool;
+
+  auto GetCapacity() const -> std::uint16_t;
+  auto GetUsed() -> std::uint16_t;
+  auto GetHighWaterMark() -> std::uint16_t;
+
+ private:
+  std::vector<Command> slots_{};
+  std::vector<CommandHandle> free_handles_{};  // Stack of free slots
+
+  std::mutex mutex_{};  // Commands are acquired from the MQTT task and the main loop
+  std::uint16_t high_water_mark_{0};
+};
+
+}  // namespace cmd
+}  // namespace owif
+
+#endif  // OWIF_CMD_COMMAND_POOL_H
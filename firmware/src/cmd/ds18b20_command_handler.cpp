@@ -5,11 +5,14 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 
+#include <algorithm>
+
 #include "cmd/command.h"
 #include "cmd/command_handler.h"
 #include "cmd/json_constants.h"
 #include "one_wire/ds18b20.h"
 #include "one_wire/one_wire_subsystem.h"
+#include "util/json_allocator.h"
 
 namespace owif {
 namespace cmd {
@@ -19,10 +22,10 @@ Ds18b20CommandHandler::Ds18b20CommandHandler(CommandHandler* command_handler, on
 
 // ---- Public APIs --------------------------------------------------------------------------------------------------
 auto Ds18b20CommandHandler::ProcessReadSingleDevice(Command& cmd) -> void {
-  one_wire::OneWireAddress const& device_addr{cmd.param1.param_value.device_id};
+  one_wire::OneWireAddress const& device_addr{cmd.params.address.device_id};
 
-  if (cmd.param3.param_value.device_attribute == DeviceAttributeType::Presence) {
-    JsonDocument response_json{};
+  if (cmd.params.device_attribute == DeviceAttributeType::Presence) {
+    JsonDocument response_json{&util::json_allocator_g};
     response_json[json::kRootAction] = json::kActionRead;
     JsonObject json_device{response_json[json::kDevice].to<JsonObject>()};
 
@@ -37,7 +40,7 @@ auto Ds18b20CommandHandler::ProcessReadSingleDevice(Command& cmd) -> void {
     json_device[json::kAttributePresence] = is_present;
 
     command_handler_->SendCommandResponse(cmd, response_json);
-  } else if (cmd.param3.param_value.device_attribute == DeviceAttributeType::Temperature) {
+  } else if (cmd.params.device_attribute == DeviceAttributeType::Temperature) {
     logger_.Debug(F("[DS18B20 CmdHandler] Processing command 'read' [sub_action=%u][device_id=%s]"), cmd.sub_action,
                   device_addr.Format().c_str());
 
@@ -48,11 +51,14 @@ auto Ds18b20CommandHandler::ProcessReadSingleDevice(Command& cmd) -> void {
 
         // Sub-Action Handling
         if (cmd.sub_action == SubAction::None || cmd.sub_action == SubAction::TriggerSampling) {
-          bool const sample_result{ds18b20->SampleTemperature()};
+          one_wire::OneWireBus* ow_bus{FindBus(ow_device->GetBusId())};
+          std::uint32_t conversion_age{0};
+          bool const sample_result{(ow_bus != nullptr) && StartSharedConversion(*ow_bus, conversion_age)};
           if (sample_result) {
-            cmd.timer.Reset(ds18b20->GetSamplingTime());
+            std::uint32_t const sampling_time{ds18b20->GetSamplingTime()};
+            cmd.timer.Reset((conversion_age < sampling_time) ? (sampling_time - conversion_age) : 0);
             cmd.sub_action = SubAction::ReadResult;
-            command_handler_->EnqueueCommand(cmd);
+            command_handler_->RequeueCommand(cmd);
           } else {
             command_handler_->SendErrorResponse(cmd, "Failed to start DS18B20 temperature sampling.");
           }
@@ -60,7 +66,7 @@ auto Ds18b20CommandHandler::ProcessReadSingleDevice(Command& cmd) -> void {
           float sampled_temperature{0};
           bool const get_temp_result{ds18b20->GetTemperature(sampled_temperature)};
           if (get_temp_result) {
-            JsonDocument response_json{};
+            JsonDocument response_json{&util::json_allocator_g};
             response_json[json::kRootAction] = json::kActionRead;
 
             JsonObject json_device{response_json[json::kDevice].to<JsonObject>()};
@@ -87,32 +93,32 @@ auto Ds18b20CommandHandler::ProcessReadSingleDevice(Command& cmd) -> void {
 }
 
 auto Ds18b20CommandHandler::ProcessReadDeviceFamily(Command& cmd) -> void {
-  if (cmd.param3.param_value.device_attribute == DeviceAttributeType::Temperature) {
-    one_wire::OneWireAddress::FamilyCode const& family_code{cmd.param2.param_value.family_code};
+  if (cmd.params.device_attribute == DeviceAttributeType::Temperature) {
+    one_wire::OneWireAddress::FamilyCode const& family_code{cmd.params.address.family_code};
     logger_.Debug(F("[DS18B20 CmdHandler] Processing command 'read' [sub_action=%u][family_code=%X]"), cmd.sub_action,
                   family_code);
 
     DeviceMap const ow_devices{one_wire_system_->GetAvailableDevices(family_code)};
 
     if (not ow_devices.empty()) {
-      JsonDocument response_json{};
+      JsonDocument response_json{&util::json_allocator_g};
       response_json[json::kRootAction] = json::kActionRead;
       response_json[json::kFamilyCode] = family_code;
       JsonArray json_devices{response_json[json::kDevices].to<JsonArray>()};
 
       if (cmd.sub_action == SubAction::None || cmd.sub_action == SubAction::TriggerSampling) {
         bool sample_result{true};
+        std::uint32_t min_conversion_age{one_wire::Ds18b20::kWorstCaseSamplingTime};
         for (std::reference_wrapper<one_wire::OneWireBus> ow_bus : one_wire_system_->GetAvailableBuses()) {
-          logger_.Verbose(F("[DS18B20 CmdHandler] Trigger temperature sampling on 1-wire bus %u"),
-                          ow_bus.get().GetId());
-          one_wire::Ds18b20 dummy_ds18b20{ow_bus.get(), one_wire::OneWireAddress{0}};
-          sample_result &= dummy_ds18b20.SampleTemperature(/* skip_rom_select= */ true);
+          std::uint32_t conversion_age{0};
+          sample_result &= StartSharedConversion(ow_bus.get(), conversion_age);
+          min_conversion_age = std::min(min_conversion_age, conversion_age);
         }
 
         if (sample_result) {
-          cmd.timer.Reset(one_wire::Ds18b20::kWorstCaseSamplingTime);
+          cmd.timer.Reset(one_wire::Ds18b20::kWorstCaseSamplingTime - min_conversion_age);
           cmd.sub_action = SubAction::ReadResult;
-          command_handler_->EnqueueCommand(cmd);
+          command_handler_->RequeueCommand(cmd);
         } else {
           command_handler_->SendErrorResponse(cmd, "Failed to start DS18B20 temperature sampling.");
         }
@@ -144,5 +150,52 @@ auto Ds18b20CommandHandler::ProcessReadDeviceFamily(Command& cmd) -> void {
   }
 }
 
+// ---- Private APIs ---------------------------------------------------------------------------------------------------
+
+/*!
+ * Start a Skip-ROM temperature conversion on the 1-wire bus unless a conversion is already in progress. All DS18B20
+ * devices of a bus are served by the same conversion, so reads triggered in the same subscription tick share one
+ * conversion per bus instead of converting every device separately.
+ * \param[in] ow_bus 1-wire bus to convert
+ * \param[out] conversion_age Elapsed time [ms] since the start of the (shared) conversion
+ */
+auto Ds18b20CommandHandler::StartSharedConversion(one_wire::OneWireBus& ow_bus, std::uint32_t& conversion_age)
+    -> bool {
+  bool result{true};
+
+  time::TimeStampMs const now{time::TimeUtil::TimeSinceStartup()};
+  std::map<one_wire::OneWireBus::BusId, time::TimeStampMs>::iterator const conversion{
+      conversion_start_times_.find(ow_bus.GetId())};
+
+  if ((conversion != conversion_start_times_.end()) &&
+      ((now - conversion->second) < one_wire::Ds18b20::kWorstCaseSamplingTime)) {
+    conversion_age = static_cast<std::uint32_t>(now - conversion->second);
+    logger_.Verbose(F("[DS18B20 CmdHandler] Join temperature sampling on 1-wire bus %u started %u ms ago"),
+                    ow_bus.GetId(), conversion_age);
+  } else {
+    logger_.Verbose(F("[DS18B20 CmdHandler] Trigger temperature sampling on 1-wire bus %u"), ow_bus.GetId());
+    one_wire::Ds18b20 dummy_ds18b20{ow_bus, one_wire::OneWireAddress{0}};
+    result = dummy_ds18b20.SampleTemperature(/* skip_rom_select= */ true);
+    if (result) {
+      conversion_start_times_[ow_bus.GetId()] = now;
+    }
+    conversion_age = 0;
+  }
+
+  return result;
+}
+
+auto Ds18b20CommandHandler::FindBus(one_wire::OneWireBus::BusId bus_id) -> one_wire::OneWireBus* {
+  one_wire::OneWireBus* result{nullptr};
+
+  for (std::reference_wrapper<one_wire::OneWireBus> ow_bus : one_wire_system_->GetAvailableBuses()) {
+    if (ow_bus.get().GetId() == bus_id) {
+      result = &ow_bus.get();
+    }
+  }
+
+  return result;
+}
+
 }  // namespace cmd
 }  // namespace owif
@@ -3,10 +3,14 @@
 
 // ---- Includes ----
 
+#include <cstdint>
+#include <map>
+
 #include "cmd/command.h"
 #include "logging/logger.h"
 #include "one_wire/ds18b20.h"
 #include "one_wire/one_wire_subsystem.h"
+#include "time/time_util.h"
 
 namespace owif {
 namespace cmd {
@@ -32,10 +36,16 @@ class Ds18b20CommandHandler final {
  private:
   using DeviceMap = one_wire::OneWireSystem::DeviceMap;
 
+  auto StartSharedConversion(one_wire::OneWireBus& ow_bus, std::uint32_t& conversion_age) -> bool;
+  auto FindBus(one_wire::OneWireBus::BusId bus_id) -> one_wire::OneWireBus*;
+
   logging::Logger logger_{logging::logger_g};
 
   CommandHandler* command_handler_;
   one_wire::OneWireSystem* one_wire_system_;
+
+  // Start time of the last Skip-ROM temperature conversion per 1-Wire bus
+  std::map<one_wire::OneWireBus::BusId, time::TimeStampMs> conversion_start_times_{};
 };
 
 }  // namespace cmd
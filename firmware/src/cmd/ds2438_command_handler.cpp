@@ -11,6 +11,7 @@
 #include "one_wire/ds2438.h"
 #include "one_wire/one_wire_address.h"
 #include "one_wire/one_wire_subsystem.h"
+#include "util/json_allocator.h"
 
 namespace owif {
 namespace cmd {
@@ -20,7 +21,7 @@ Ds2438CommandHandler::Ds2438CommandHandler(CommandHandler* command_handler, one_
 
 // ---- Public APIs --------------------------------------------------------------------------------------------------
 auto Ds2438CommandHandler::ProcessReadSingleDevice(Command& cmd) -> void {
-  one_wire::OneWireAddress const& device_addr{cmd.param1.param_value.device_id};
+  one_wire::OneWireAddress const& device_addr{cmd.params.address.device_id};
   logger_.Debug(F("[DS2438 CmdHandler] Processing command 'read' [sub_action=%u][device_id=%s]"), cmd.sub_action,
                 device_addr.Format().c_str());
   std::shared_ptr<one_wire::OneWireDevice> ow_device{one_wire_system_->GetAvailableDevice(device_addr)};
@@ -29,11 +30,11 @@ auto Ds2438CommandHandler::ProcessReadSingleDevice(Command& cmd) -> void {
     if (one_wire::Ds2438::MatchesFamily(*ow_device)) {
       one_wire::Ds2438* ds2438{one_wire::Ds2438::FromDevice(*ow_device)};
 
-      if (cmd.param3.param_value.device_attribute == DeviceAttributeType::Temperature) {
+      if (cmd.params.device_attribute == DeviceAttributeType::Temperature) {
         ProcessDeviceTemperature(cmd, *ds2438);
-      } else if (cmd.param3.param_value.device_attribute == DeviceAttributeType::VAD) {
+      } else if (cmd.params.device_attribute == DeviceAttributeType::VAD) {
         ProcessDeviceVAD(cmd, *ds2438);
-      } else if (cmd.param3.param_value.device_attribute == DeviceAttributeType::VDD) {
+      } else if (cmd.params.device_attribute == DeviceAttributeType::VDD) {
         ProcessDeviceVDD(cmd, *ds2438);
       } else {
         command_handler_->SendErrorResponse(cmd, "Unsupported device attribute for DS2438.");
@@ -48,17 +49,17 @@ auto Ds2438CommandHandler::ProcessReadSingleDevice(Command& cmd) -> void {
 }
 
 auto Ds2438CommandHandler::ProcessReadDeviceFamily(Command& cmd) -> void {
-  one_wire::OneWireAddress::FamilyCode const& family_code{cmd.param2.param_value.family_code};
+  one_wire::OneWireAddress::FamilyCode const& family_code{cmd.params.address.family_code};
   logger_.Debug(F("[DS2438 CmdHandler] Processing command 'read' [sub_action=%u][family_code=%X]"), cmd.sub_action,
                 family_code);
   DeviceMap const ow_devices{one_wire_system_->GetAvailableDevices(family_code)};
 
   if (not ow_devices.empty()) {
-    if (cmd.param3.param_value.device_attribute == DeviceAttributeType::Temperature) {
+    if (cmd.params.device_attribute == DeviceAttributeType::Temperature) {
       ProcessFamilyTemperature(cmd, family_code, ow_devices);
-    } else if (cmd.param3.param_value.device_attribute == DeviceAttributeType::VAD) {
+    } else if (cmd.params.device_attribute == DeviceAttributeType::VAD) {
       ProcessFamilyVAD(cmd, family_code, ow_devices);
-    } else if (cmd.param3.param_value.device_attribute == DeviceAttributeType::VDD) {
+    } else if (cmd.params.device_attribute == DeviceAttributeType::VDD) {
       ProcessFamilyVDD(cmd, family_code, ow_devices);
     } else {
       command_handler_->SendErrorResponse(cmd, "Unsupported device attribute for DS2438.");
@@ -75,7 +76,7 @@ auto Ds2438CommandHandler::ProcessDeviceTemperature(Command& cmd, one_wire::Ds24
     if (sample_result) {
       cmd.timer.Reset(one_wire::Ds2438::kSamplingTime);
       cmd.sub_action = SubAction::ReadResult;
-      command_handler_->EnqueueCommand(cmd);
+      command_handler_->RequeueCommand(cmd);
     } else {
       command_handler_->SendErrorResponse(cmd, "Failed to start DS2438 temperature sampling.");
     }
@@ -83,7 +84,7 @@ auto Ds2438CommandHandler::ProcessDeviceTemperature(Command& cmd, one_wire::Ds24
     float sampled_temperature{0};
     bool const get_temperature_result{ds2438.GetTemperature(sampled_temperature)};
     if (get_temperature_result) {
-      JsonDocument response_json{};
+      JsonDocument response_json{&util::json_allocator_g};
       response_json[json::kRootAction] = json::kActionRead;
       AddJsonDeviceWithAttribute(response_json, ds2438, json::kActionReadAttributeTemperature, sampled_temperature);
       command_handler_->SendCommandResponse(cmd, response_json);
@@ -108,12 +109,12 @@ auto Ds2438CommandHandler::ProcessFamilyTemperature(Command& cmd, one_wire::OneW
     if (sample_result) {
       cmd.timer.Reset(one_wire::Ds2438::kSamplingTime);
       cmd.sub_action = SubAction::ReadResult;
-      command_handler_->EnqueueCommand(cmd);
+      command_handler_->RequeueCommand(cmd);
     } else {
       command_handler_->SendErrorResponse(cmd, "Failed to start DS2438 temperature sampling.");
     }
   } else if (cmd.sub_action == SubAction::ReadResult) {
-    JsonDocument response_json{};
+    JsonDocument response_json{&util::json_allocator_g};
     response_json[json::kRootAction] = json::kActionRead;
     response_json[json::kFamilyCode] = family_code;
     JsonArray json_devices{response_json[json::kDevices].to<JsonArray>()};
@@ -143,7 +144,7 @@ auto Ds2438CommandHandler::ProcessDeviceVAD(Command& cmd, one_wire::Ds2438& ds24
     if (sample_result) {
       cmd.timer.Reset(one_wire::Ds2438::kSamplingTime);
       cmd.sub_action = SubAction::ReadResult;
-      command_handler_->EnqueueCommand(cmd);
+      command_handler_->RequeueCommand(cmd);
     } else {
       command_handler_->SendErrorResponse(cmd, "Failed to start DS2438 VAD sampling.");
     }
@@ -151,7 +152,7 @@ auto Ds2438CommandHandler::ProcessDeviceVAD(Command& cmd, one_wire::Ds2438& ds24
     float sampled_vad{0};
     bool const get_vad_result{ds2438.GetVAD(sampled_vad)};
     if (get_vad_result) {
-      JsonDocument response_json{};
+      JsonDocument response_json{&util::json_allocator_g};
       response_json[json::kRootAction] = json::kActionRead;
       AddJsonDeviceWithAttribute(response_json, ds2438, json::kActionReadAttributeVAD, sampled_vad);
       command_handler_->SendCommandResponse(cmd, response_json);
@@ -177,12 +178,12 @@ auto Ds2438CommandHandler::ProcessFamilyVAD(Command& cmd, one_wire::OneWireAddre
     if (sample_result) {
       cmd.timer.Reset(one_wire::Ds2438::kSamplingTime);
       cmd.sub_action = SubAction::ReadResult;
-      command_handler_->EnqueueCommand(cmd);
+      command_handler_->RequeueCommand(cmd);
     } else {
       command_handler_->SendErrorResponse(cmd, "Failed to start DS2438 VAD sampling.");
     }
   } else if (cmd.sub_action == SubAction::ReadResult) {
-    JsonDocument response_json{};
+    JsonDocument response_json{&util::json_allocator_g};
     response_json[json::kRootAction] = json::kActionRead;
     response_json[json::kFamilyCode] = family_code;
     JsonArray json_devices{response_json[json::kDevices].to<JsonArray>()};
@@ -212,7 +213,7 @@ auto Ds2438CommandHandler::ProcessDeviceVDD(Command& cmd, one_wire::Ds2438& ds24
     if (sample_result) {
       cmd.timer.Reset(one_wire::Ds2438::kSamplingTime);
       cmd.sub_action = SubAction::ReadResult;
-      command_handler_->EnqueueCommand(cmd);
+      command_handler_->RequeueCommand(cmd);
     } else {
       command_handler_->SendErrorResponse(cmd, "Failed to start DS2438 VDD sampling.");
     }
@@ -220,7 +221,7 @@ auto Ds2438CommandHandler::ProcessDeviceVDD(Command& cmd, one_wire::Ds2438& ds24
     float sampled_vdd{0};
     bool const get_vdd_result{ds2438.GetVDD(sampled_vdd)};
     if (get_vdd_result) {
-      JsonDocument response_json{};
+      JsonDocument response_json{&util::json_allocator_g};
       response_json[json::kRootAction] = json::kActionRead;
       AddJsonDeviceWithAttribute(response_json, ds2438, json::kActionReadAttributeVDD, sampled_vdd);
       command_handler_->SendCommandResponse(cmd, response_json);
@@ -246,12 +247,12 @@ auto Ds2438CommandHandler::ProcessFamilyVDD(Command& cmd, one_wire::OneWireAddre
     if (sample_result) {
       cmd.timer.Reset(one_wire::Ds2438::kSamplingTime);
       cmd.sub_action = SubAction::ReadResult;
-      command_handler_->EnqueueCommand(cmd);
+      command_handler_->RequeueCommand(cmd);
     } else {
       command_handler_->SendErrorResponse(cmd, "Failed to start DS2438 VDD sampling.");
     }
   } else if (cmd.sub_action == SubAction::ReadResult) {
-    JsonDocument response_json{};
+    JsonDocument response_json{&util::json_allocator_g};
     response_json[json::kRootAction] = json::kActionRead;
     response_json[json::kFamilyCode] = family_code;
     JsonArray json_devices{response_json[json::kDevices].to<JsonArray>()};
@@ -21,6 +21,14 @@ auto JsonBuilder::AddTimestamp(JsonDocument& json) -> void {
   json[cmd::json::kTime] = formatted_timestamp;
 }
 
+auto JsonBuilder::AddRequestId(JsonDocument& json, RequestId const& request_id) -> void {
+  if (request_id.type == RequestIdType::Number) {
+    json[cmd::json::kRequestId] = request_id.number;
+  } else if (request_id.type == RequestIdType::String) {
+    json[cmd::json::kRequestId] = request_id.string.c_str();
+  }
+}
+
 auto JsonBuilder::AddDeviceAttributes(one_wire::OneWireSystem* one_wire_system, JsonObject& json,
                                       one_wire::OneWireAddress const& ow_address) -> void {
   JsonArray json_device_attributes{json[json::kAttributes].to<JsonArray>()};
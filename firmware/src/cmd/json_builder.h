@@ -4,6 +4,7 @@
 // ---- Includes ----
 
 #include "ArduinoJson.h"
+#include "cmd/command.h"
 #include "one_wire/one_wire_address.h"
 #include "one_wire/one_wire_subsystem.h"
 
@@ -23,6 +24,8 @@ class JsonBuilder final {
 
   static auto AddTimestamp(JsonDocument& json) -> void;
 
+  static auto AddRequestId(JsonDocument& json, RequestId const& request_id) -> void;
+
   static auto AddDeviceAttributes(one_wire::OneWireSystem* one_wire_system, JsonObject& json,
                                   one_wire::OneWireAddress const& ow_address) -> void;
 };
@@ -21,6 +21,14 @@ static constexpr char const* kStateOffline{"offline"};
 static constexpr char const* kRootError{"error"};
 static constexpr char const* kErrorMessage{"message"};
 static constexpr char const* kErrorRequest{"request"};
+static constexpr char const* kErrorCode{"code"};
+static constexpr char const* kErrorCodeBusy{"busy"};
+static constexpr char const* kErrorCodeExpired{"expired"};
+
+// Common Command Attributes
+static constexpr char const* kRequestId{"id"};
+static constexpr char const* kReplyTo{"reply_to"};
+static constexpr char const* kDeadline{"deadline"};
 
 // Actions
 static constexpr char const* kRootAction{"action"};
@@ -30,6 +38,9 @@ static constexpr char const* kActionRestartAcknowledge{"acknowledge"};
 
 static constexpr char const* kActionScan{"scan"};
 static constexpr char const* kAttributePresence{"presence"};
+static constexpr char const* kEvent{"event"};
+static constexpr char const* kEventArrived{"arrived"};
+static constexpr char const* kEventDeparted{"departed"};
 
 static constexpr char const* kActionRead{"read"};
 static constexpr char const* kActionReadAttributeTemperature{"temperature"};
@@ -38,15 +49,62 @@ static constexpr char const* kActionReadAttributeVDD{"VDD"};
 
 static constexpr char const* kActionSubscribe{"subscribe"};
 static constexpr char const* kActionSubscribeInterval{"interval"};
+static constexpr char const* kActionSubscribeOnChange{"on_change"};
+static constexpr char const* kActionSubscribeDeadband{"deadband"};
+static constexpr char const* kActionSubscribeDeadbandType{"deadband_type"};
+static constexpr char const* kActionSubscribeDeadbandAbsolute{"absolute"};
+static constexpr char const* kActionSubscribeDeadbandRelative{"relative"};
+static constexpr char const* kActionSubscribeMaxSilence{"max_silence"};
+static constexpr char const* kActionSubscribeSampleInterval{"sample_interval"};
+static constexpr char const* kActionSubscribePublishInterval{"publish_interval"};
+static constexpr char const* kActionSubscribeAggregates{"aggregates"};
+static constexpr char const* kAggregateMin{"min"};
+static constexpr char const* kAggregateMax{"max"};
+static constexpr char const* kAggregateMean{"mean"};
+static constexpr char const* kAggregateLast{"last"};
+static constexpr char const* kAggregateCount{"count"};
+static constexpr char const* kAggregateWindow{"window"};
+static constexpr char const* kActionSubscribeMinInterval{"min_interval"};
+static constexpr char const* kActionSubscribeMaxInterval{"max_interval"};
+static constexpr char const* kActionSubscribeAdaptiveDelta{"adaptive_delta"};
 static constexpr char const* kActionSubscribeAcknowledge{"acknowledge"};
 static constexpr char const* kActionUnsubscribe{"unsubscribe"};
 
+static constexpr char const* kActionStatistics{"statistics"};
+static constexpr char const* kStatisticsCommandQueues{"command_queues"};
+static constexpr char const* kStatisticsCommandPool{"command_pool"};
+static constexpr char const* kStatisticsSubscriptions{"subscriptions"};
+static constexpr char const* kStatisticsPublishQueue{"publish_queue"};
+static constexpr char const* kStatisticsOfflineStore{"offline_store"};
+static constexpr char const* kStatisticsMqttConnection{"mqtt_connection"};
+static constexpr char const* kStatisticsJsonPool{"json_pool"};
+static constexpr char const* kStatisticsInteractive{"interactive"};
+static constexpr char const* kStatisticsPeriodic{"periodic"};
+static constexpr char const* kStatisticsSize{"size"};
+static constexpr char const* kStatisticsCapacity{"capacity"};
+static constexpr char const* kStatisticsHighWaterMark{"high_water_mark"};
+static constexpr char const* kStatisticsRejected{"rejected"};
+static constexpr char const* kStatisticsDropped{"dropped"};
+static constexpr char const* kStatisticsExpired{"expired"};
+static constexpr char const* kStatisticsMemory{"memory"};
+static constexpr char const* kStatisticsInFlight{"in_flight"};
+static constexpr char const* kStatisticsRetried{"retried"};
+static constexpr char const* kStatisticsSpilled{"spilled"};
+static constexpr char const* kStatisticsReplayed{"replayed"};
+static constexpr char const* kStatisticsReconnects{"reconnects"};
+static constexpr char const* kStatisticsAttempts{"attempts"};
+static constexpr char const* kStatisticsLastDelay{"last_delay"};
+static constexpr char const* kStatisticsLastDowntime{"last_downtime"};
+static constexpr char const* kStatisticsMaxDowntime{"max_downtime"};
+static constexpr char const* kStatisticsFallbacks{"fallbacks"};
+
 // General attributes
 static constexpr char const* kTime{"time"};
 static constexpr char const* kDevice{"device"};
 static constexpr char const* kDevices{"devices"};
 static constexpr char const* kDeviceId{"device_id"};
 static constexpr char const* kChannel{"channel"};
+static constexpr char const* kWildcard{"*"};
 static constexpr char const* kFamilyCode{"family_code"};
 static constexpr char const* kAttribute{"attribute"};
 static constexpr char const* kAttributes{"attributes"};
@@ -2,6 +2,7 @@
 
 #include "cmd/json_constants.h"
 #include "logging/logger.h"
+#include "util/language.h"
 
 namespace owif {
 namespace cmd {
@@ -9,8 +10,11 @@ namespace json {
 
 // ---- Public APIs ----------------------------------------------------------------------------------------------------
 
-auto JsonParser::ParseAddressing(JsonDocument const& json, CommandParam& device_id_param,
-                                 CommandParam& family_code_param, bool any_attribute_required) -> bool {
+/*!
+ * \param[in] wildcard_allowed Accept device_id '*' addressing all available devices
+ */
+auto JsonParser::ParseAddressing(JsonDocument const& json, CommandParams& params, bool any_attribute_required,
+                                 bool wildcard_allowed) -> bool {
   bool result{false};
   logging::Logger& logger{logging::logger_g};
 
@@ -25,9 +29,13 @@ auto JsonParser::ParseAddressing(JsonDocument const& json, CommandParam& device_
         String device_id{json[cmd::json::kDeviceId].as<String>()};
 
         std::unique_ptr<one_wire::OneWireAddress> ow_address{one_wire::OneWireAddress::FromOwfsFormat(device_id)};
-        if (ow_address != nullptr) {
-          device_id_param.param_available = true;
-          device_id_param.param_value = cmd::CommandParamValue{.device_id = *ow_address};
+        if (wildcard_allowed && (device_id == kWildcard)) {
+          params.all_devices = true;
+
+          result = true;
+        } else if (ow_address != nullptr) {
+          params.has_device_id = true;
+          params.address.device_id = *ow_address;
 
           result = true;
         } else {
@@ -38,8 +46,8 @@ auto JsonParser::ParseAddressing(JsonDocument const& json, CommandParam& device_
         one_wire::OneWireAddress::FamilyCode const family_code{
             json[cmd::json::kFamilyCode].as<one_wire::OneWireAddress::FamilyCode>()};
 
-        family_code_param.param_available = true;
-        family_code_param.param_value = cmd::CommandParamValue{.family_code = family_code};
+        params.has_family_code = true;
+        params.address.family_code = family_code;
 
         result = true;
       } else {
@@ -59,7 +67,11 @@ auto JsonParser::ParseAddressing(JsonDocument const& json, CommandParam& device_
   return result;
 }
 
-auto JsonParser::ParseDeviceAttribute(JsonDocument const& json, CommandParam& cmd_param) -> bool {
+/*!
+ * \param[in] wildcard_allowed Accept attribute '*' selecting all measured attributes
+ */
+auto JsonParser::ParseDeviceAttribute(JsonDocument const& json, CommandParams& params, bool wildcard_allowed)
+    -> bool {
   bool result{true};
 
   bool const has_attribute_param{json[cmd::json::kAttribute].is<String>()};
@@ -68,17 +80,20 @@ auto JsonParser::ParseDeviceAttribute(JsonDocument const& json, CommandParam& cm
     String const attribute_string{json[cmd::json::kAttribute].as<String>()};
 
     if (attribute_string == kAttributePresence) {
-      cmd_param.param_available = true;
-      cmd_param.param_value.device_attribute = DeviceAttributeType::Presence;
+      params.has_device_attribute = true;
+      params.device_attribute = DeviceAttributeType::Presence;
     } else if (attribute_string == kActionReadAttributeTemperature) {
-      cmd_param.param_available = true;
-      cmd_param.param_value.device_attribute = DeviceAttributeType::Temperature;
+      params.has_device_attribute = true;
+      params.device_attribute = DeviceAttributeType::Temperature;
     } else if (attribute_string == kActionReadAttributeVAD) {
-      cmd_param.param_available = true;
-      cmd_param.param_value.device_attribute = DeviceAttributeType::VAD;
+      params.has_device_attribute = true;
+      params.device_attribute = DeviceAttributeType::VAD;
     } else if (attribute_string == kActionReadAttributeVDD) {
-      cmd_param.param_available = true;
-      cmd_param.param_value.device_attribute = DeviceAttributeType::VDD;
+      params.has_device_attribute = true;
+      params.device_attribute = DeviceAttributeType::VDD;
+    } else if (wildcard_allowed && (attribute_string == kWildcard)) {
+      params.has_device_attribute = true;
+      params.device_attribute = DeviceAttributeType::All;
     } else {
       result = false;
     }
@@ -88,6 +103,215 @@ auto JsonParser::ParseDeviceAttribute(JsonDocument const& json, CommandParam& cm
   return result;
 }
 
+/*!
+ * All filter attributes are optional. A deadband implies publishing on change only.
+ */
+auto JsonParser::ParseSubscriptionFilter(JsonDocument const& json, SubscriptionOptions& options) -> bool {
+  bool result{true};
+  logging::Logger& logger{logging::logger_g};
+
+  SubscriptionFilter& filter{options.filter};
+  filter = SubscriptionFilter{0.0F, 0, DeadbandType::Absolute, false};
+
+  if (json[cmd::json::kActionSubscribeOnChange].is<bool>()) {
+    filter.on_change = json[cmd::json::kActionSubscribeOnChange].as<bool>();
+  } else if (not json[cmd::json::kActionSubscribeOnChange].isNull()) {
+    logger.Error(F("[JsonParser] on_change must be a boolean"));
+    result = false;
+  }
+
+  bool const has_deadband{json[cmd::json::kActionSubscribeDeadband].is<float>()};
+  if (has_deadband && (json[cmd::json::kActionSubscribeDeadband].as<float>() >= 0.0F)) {
+    filter.deadband = json[cmd::json::kActionSubscribeDeadband].as<float>();
+    filter.on_change = true;
+  } else if (has_deadband || not json[cmd::json::kActionSubscribeDeadband].isNull()) {
+    logger.Error(F("[JsonParser] deadband must be a non-negative number"));
+    result = false;
+  }
+
+  if (json[cmd::json::kActionSubscribeDeadbandType].is<String>()) {
+    String const deadband_type{json[cmd::json::kActionSubscribeDeadbandType].as<String>()};
+    if (deadband_type == kActionSubscribeDeadbandAbsolute) {
+      filter.deadband_type = DeadbandType::Absolute;
+    } else if (deadband_type == kActionSubscribeDeadbandRelative) {
+      filter.deadband_type = DeadbandType::Relative;
+    } else {
+      logger.Error(F("[JsonParser] Unknown deadband_type: %s"), deadband_type.c_str());
+      result = false;
+    }
+  } else if (not json[cmd::json::kActionSubscribeDeadbandType].isNull()) {
+    logger.Error(F("[JsonParser] deadband_type must be a string"));
+    result = false;
+  }
+
+  if (json[cmd::json::kActionSubscribeMaxSilence].is<std::uint32_t>()) {
+    filter.max_silence = json[cmd::json::kActionSubscribeMaxSilence].as<std::uint32_t>();
+  } else if (not json[cmd::json::kActionSubscribeMaxSilence].isNull()) {
+    logger.Error(F("[JsonParser] max_silence must be an unsigned integer (milliseconds)"));
+    result = false;
+  }
+
+  return result;
+}
+
+/*!
+ * Aggregation is enabled by 'publish_interval'. Publishes all aggregates if 'aggregates' is not set.
+ */
+auto JsonParser::ParseSubscriptionAggregation(JsonDocument const& json, SubscriptionOptions& options) -> bool {
+  bool result{true};
+  logging::Logger& logger{logging::logger_g};
+
+  constexpr std::uint8_t kAllAggregates{ToUnderlying(Aggregate::Min) | ToUnderlying(Aggregate::Max) |
+                                        ToUnderlying(Aggregate::Mean) | ToUnderlying(Aggregate::Last) |
+                                        ToUnderlying(Aggregate::Count)};
+
+  SubscriptionAggregation& aggregation{options.aggregation};
+  aggregation = SubscriptionAggregation{0, kAllAggregates};
+
+  if (json[cmd::json::kActionSubscribePublishInterval].is<std::uint32_t>()) {
+    aggregation.publish_interval = json[cmd::json::kActionSubscribePublishInterval].as<std::uint32_t>();
+  } else if (not json[cmd::json::kActionSubscribePublishInterval].isNull()) {
+    logger.Error(F("[JsonParser] publish_interval must be an unsigned integer (milliseconds)"));
+    result = false;
+  }
+
+  if (json[cmd::json::kActionSubscribeAggregates].is<JsonArrayConst>()) {
+    aggregation.aggregates = 0;
+    for (JsonVariantConst json_aggregate : json[cmd::json::kActionSubscribeAggregates].as<JsonArrayConst>()) {
+      String const aggregate{json_aggregate.as<String>()};
+      if (aggregate == kAggregateMin) {
+        aggregation.aggregates |= ToUnderlying(Aggregate::Min);
+      } else if (aggregate == kAggregateMax) {
+        aggregation.aggregates |= ToUnderlying(Aggregate::Max);
+      } else if (aggregate == kAggregateMean) {
+        aggregation.aggregates |= ToUnderlying(Aggregate::Mean);
+      } else if (aggregate == kAggregateLast) {
+        aggregation.aggregates |= ToUnderlying(Aggregate::Last);
+      } else if (aggregate == kAggregateCount) {
+        aggregation.aggregates |= ToUnderlying(Aggregate::Count);
+      } else {
+        logger.Error(F("[JsonParser] Unknown aggregate: %s"), aggregate.c_str());
+        result = false;
+      }
+    }
+  } else if (not json[cmd::json::kActionSubscribeAggregates].isNull()) {
+    logger.Error(F("[JsonParser] aggregates must be an array of strings"));
+    result = false;
+  }
+
+  if (result && (aggregation.aggregates == 0)) {
+    logger.Error(F("[JsonParser] aggregates must not be empty"));
+    result = false;
+  }
+
+  return result;
+}
+
+/*!
+ * Adaptive sampling is enabled by 'min_interval' and 'max_interval' (both required). 'adaptive_delta' defaults to the
+ * deadband of the filter.
+ */
+auto JsonParser::ParseSubscriptionAdaptation(JsonDocument const& json, SubscriptionOptions& options) -> bool {
+  bool result{true};
+  logging::Logger& logger{logging::logger_g};
+
+  SubscriptionAdaptation& adaptation{options.adaptation};
+  adaptation = SubscriptionAdaptation{0, 0, options.filter.deadband};
+
+  bool const has_min_interval{json[cmd::json::kActionSubscribeMinInterval].is<std::uint32_t>()};
+  bool const has_max_interval{json[cmd::json::kActionSubscribeMaxInterval].is<std::uint32_t>()};
+  if (has_min_interval && has_max_interval) {
+    adaptation.min_interval = json[cmd::json::kActionSubscribeMinInterval].as<std::uint32_t>();
+    adaptation.max_interval = json[cmd::json::kActionSubscribeMaxInterval].as<std::uint32_t>();
+    if ((adaptation.min_interval == 0) || (adaptation.min_interval > adaptation.max_interval)) {
+      logger.Error(F("[JsonParser] min_interval must be > 0 and <= max_interval"));
+      result = false;
+    }
+  } else if (has_min_interval || has_max_interval || not json[cmd::json::kActionSubscribeMinInterval].isNull() ||
+             not json[cmd::json::kActionSubscribeMaxInterval].isNull()) {
+    logger.Error(F("[JsonParser] min_interval and max_interval must both be unsigned integers (milliseconds)"));
+    result = false;
+  }
+
+  bool const has_delta{json[cmd::json::kActionSubscribeAdaptiveDelta].is<float>()};
+  if (has_delta && (json[cmd::json::kActionSubscribeAdaptiveDelta].as<float>() >= 0.0F)) {
+    adaptation.delta = json[cmd::json::kActionSubscribeAdaptiveDelta].as<float>();
+  } else if (has_delta || not json[cmd::json::kActionSubscribeAdaptiveDelta].isNull()) {
+    logger.Error(F("[JsonParser] adaptive_delta must be a non-negative number"));
+    result = false;
+  }
+
+  return result;
+}
+
+auto JsonParser::ParseRequestId(JsonDocument const& json, RequestId& request_id) -> bool {
+  bool result{true};
+  logging::Logger& logger{logging::logger_g};
+
+  request_id.type = RequestIdType::None;
+
+  if (json[cmd::json::kRequestId].is<RequestId::NumberType>()) {
+    request_id.type = RequestIdType::Number;
+    request_id.number = json[cmd::json::kRequestId].as<RequestId::NumberType>();
+  } else if (json[cmd::json::kRequestId].is<String>()) {
+    String const request_id_string{json[cmd::json::kRequestId].as<String>()};
+    if (request_id_string.length() <= RequestId::kMaxStringLength) {
+      request_id.type = RequestIdType::String;
+      request_id.string = RequestId::StringType{request_id_string.c_str()};
+    } else {
+      logger.Error(F("[JsonParser] Request id exceeds max. length of %u characters"), RequestId::kMaxStringLength);
+      result = false;
+    }
+  } else if (not json[cmd::json::kRequestId].isNull()) {
+    logger.Error(F("[JsonParser] Request id must be an unsigned integer or a string"));
+    result = false;
+  }
+
+  return result;
+}
+
+auto JsonParser::ParseDeadline(JsonDocument const& json, Timer& deadline) -> bool {
+  bool result{true};
+
+  if (json[cmd::json::kDeadline].is<std::uint32_t>()) {
+    deadline = Timer{json[cmd::json::kDeadline].as<std::uint32_t>()};
+  } else if (not json[cmd::json::kDeadline].isNull()) {
+    logging::logger_g.Error(F("[JsonParser] Deadline must be an unsigned integer (milliseconds)"));
+    result = false;
+  }
+
+  return result;
+}
+
+/*!
+ * Optional topic to publish the responses on. Must be a valid MQTT topic name without wildcards.
+ */
+auto JsonParser::ParseReplyTo(JsonDocument const& json, ReplyTo& reply_to) -> bool {
+  bool result{true};
+  logging::Logger& logger{logging::logger_g};
+
+  reply_to.topic = ReplyTo::StringType{};
+
+  if (json[cmd::json::kReplyTo].is<char const*>()) {
+    char const* const topic{json[cmd::json::kReplyTo].as<char const*>()};
+    std::size_t const topic_length{strlen(topic)};
+    if (topic_length == 0 || topic_length > ReplyTo::kMaxLength) {
+      logger.Error(F("[JsonParser] reply_to must have 1 to %u characters"), ReplyTo::kMaxLength);
+      result = false;
+    } else if (strpbrk(topic, "+#") != nullptr) {
+      logger.Error(F("[JsonParser] reply_to must not contain wildcards"));
+      result = false;
+    } else {
+      reply_to.topic = ReplyTo::StringType{topic};
+    }
+  } else if (not json[cmd::json::kReplyTo].isNull()) {
+    logger.Error(F("[JsonParser] reply_to must be a string"));
+    result = false;
+  }
+
+  return result;
+}
+
 }  // namespace json
 }  // namespace cmd
 }  // namespace owif
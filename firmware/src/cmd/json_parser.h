@@ -22,10 +22,23 @@ class JsonParser final {
 
   ~JsonParser() = delete;
 
-  static auto ParseAddressing(JsonDocument const& json, CommandParam& device_id_param, CommandParam& family_code_param,
-                              bool any_attribute_required) -> bool;
+  static auto ParseAddressing(JsonDocument const& json, CommandParams& params, bool any_attribute_required,
+                              bool wildcard_allowed = false) -> bool;
 
-  static auto ParseDeviceAttribute(JsonDocument const& json, CommandParam& cmd_param) -> bool;
+  static auto ParseDeviceAttribute(JsonDocument const& json, CommandParams& params, bool wildcard_allowed = false)
+      -> bool;
+
+  static auto ParseSubscriptionFilter(JsonDocument const& json, SubscriptionOptions& options) -> bool;
+
+  static auto ParseSubscriptionAggregation(JsonDocument const& json, SubscriptionOptions& options) -> bool;
+
+  static auto ParseSubscriptionAdaptation(JsonDocument const& json, SubscriptionOptions& options) -> bool;
+
+  static auto ParseRequestId(JsonDocument const& json, RequestId& request_id) -> bool;
+
+  static auto ParseDeadline(JsonDocument const& json, Timer& deadline) -> bool;
+
+  static auto ParseReplyTo(JsonDocument const& json, ReplyTo& reply_to) -> bool;
 };
 
 }  // namespace json
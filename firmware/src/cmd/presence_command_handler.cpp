@@ -10,6 +10,7 @@
 #include "cmd/json_builder.h"
 #include "cmd/json_constants.h"
 #include "one_wire/one_wire_subsystem.h"
+#include "util/json_allocator.h"
 
 namespace owif {
 namespace cmd {
@@ -22,7 +23,7 @@ PresenceCommandHandler::PresenceCommandHandler(CommandHandler* command_handler,
 auto PresenceCommandHandler::ProcessPresenceSingleDevice(Command& cmd, char const* action, bool add_device_attributes)
     -> void {
   // ---- Scan for specific device ----
-  one_wire::OneWireAddress const& searched_device{cmd.param1.param_value.device_id};
+  one_wire::OneWireAddress const& searched_device{cmd.params.address.device_id};
 
   logger_.Debug(F("[CmdHandler] Processing command 'Scan' [device_id=%s]"), searched_device.Format().c_str());
 
@@ -31,7 +32,7 @@ auto PresenceCommandHandler::ProcessPresenceSingleDevice(Command& cmd, char cons
   bool const scan_result{one_wire_system_->Scan(searched_device, is_present, bus_id)};
   if (scan_result) {
     // Add values in the document
-    JsonDocument response_json{};
+    JsonDocument response_json{&util::json_allocator_g};
     response_json[json::kRootAction] = action;
     JsonObject json_device{response_json[json::kDevice].to<JsonObject>()};
     if (is_present) {
@@ -51,7 +52,7 @@ auto PresenceCommandHandler::ProcessPresenceSingleDevice(Command& cmd, char cons
 auto PresenceCommandHandler::ProcessPresenceDeviceFamily(Command& cmd, char const* action, bool add_device_attributes)
     -> void {
   // ---- Scan for specific device family ----
-  one_wire::OneWireAddress::FamilyCode const& searched_family_code{cmd.param2.param_value.family_code};
+  one_wire::OneWireAddress::FamilyCode const& searched_family_code{cmd.params.address.family_code};
   logger_.Debug(F("[CmdHandler] Processing command 'Scan' [family_code=%X]"), searched_family_code);
 
   // Scan bus for specific device family
@@ -59,7 +60,7 @@ auto PresenceCommandHandler::ProcessPresenceDeviceFamily(Command& cmd, char cons
   if (scan_result) {
     DeviceMap const ow_devices{one_wire_system_->GetAvailableDevices(searched_family_code)};
 
-    JsonDocument response_json{};
+    JsonDocument response_json{&util::json_allocator_g};
     response_json[json::kRootAction] = action;
     response_json[json::kFamilyCode] = searched_family_code;
     // Add values in the document
@@ -88,7 +89,7 @@ auto PresenceCommandHandler::ProcessPresenceScanAll(Command& cmd) -> void {
     DeviceMap const& ow_devices{one_wire_system_->GetAvailableDevices()};
 
     // Add values in the document
-    JsonDocument response_json{};
+    JsonDocument response_json{&util::json_allocator_g};
     response_json[json::kRootAction] = json::kActionScan;
     JsonArray json_devices{response_json[json::kDevices].to<JsonArray>()};
     for (DeviceMap::value_type const& ow_device : ow_devices) {
@@ -3,59 +3,107 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <tuple>
+#include <vector>
 
 #include "cmd/command.h"
+#include "cmd/command_attachments.h"
 #include "cmd/command_handler.h"
 #include "cmd/json_constants.h"
+#include "config/persistency.h"
+#include "one_wire/ds18b20.h"
+#include "one_wire/ds2438.h"
 #include "one_wire/one_wire_address.h"
+#include "util/json_allocator.h"
+#include "util/language.h"
 
 namespace owif {
 namespace cmd {
 
-SubscriptionsManager::SubscriptionsManager(CommandHandler* command_handler) : command_handler_{command_handler} {}
+// Persisted reply topics must hold every reply topic of a command
+static_assert(ReplyTo::kMaxLength == config::SubscriptionsConfig::kMaxReplyTopicLength, "Reply topic length mismatch");
+
+constexpr std::array<DeviceAttributeType, SubscriptionsManager::kCollectedAttributeCount>
+    SubscriptionsManager::kCollectedAttributes;
+
+SubscriptionsManager::SubscriptionsManager(CommandHandler* command_handler, one_wire::OneWireSystem* one_wire_system,
+                                           std::uint16_t max_subscriptions)
+    : command_handler_{command_handler}, one_wire_system_{one_wire_system}, max_subscriptions_{max_subscriptions} {}
 
 // ---- Public APIs --------------------------------------------------------------------------------------------------
 auto SubscriptionsManager::Loop() -> void {
-  for (SubscriptionsMapDevice::value_type& device_subscription : subscriptions_device_) {
-    if (device_subscription.second.timer.IsExpired()) {
-      logger_.Verbose("[SubscriptionsManager] Trigger command [action=%u] after interval:%u ms",
-                      device_subscription.second.command.action, device_subscription.second.timer.GetDelay());
-      command_handler_->EnqueueCommand(device_subscription.second.command);
-      device_subscription.second.timer.Reset();
+  time::TimeStampMs const now{time::TimeUtil::TimeSinceStartup()};
+
+  // Subscriptions with interval 0 are due again immediately. Bound the processed entries to end the Loop().
+  std::size_t remaining{schedule_.size()};
+  while ((remaining > 0) && (schedule_.front().due_time <= now)) {
+    std::pop_heap(schedule_.begin(), schedule_.end(), &SubscriptionsManager::IsDueLater);
+    ScheduleEntry const entry{schedule_.back()};
+    schedule_.pop_back();
+
+    if (entry.generation != generations_[entry.slot]) {
+      --stale_entries_;  // Unscheduled or rescheduled meanwhile
+    } else {
+      subscriptions_[entry.slot].scheduled = false;
+      ProcessSubscription(subscriptions_[entry.slot]);
+      Schedule(entry.slot);
     }
+    --remaining;
   }
 
-  for (SubscriptionsMapFamily::value_type& family_subscription : subscriptions_family_) {
-    if (family_subscription.second.timer.IsExpired()) {
-      logger_.Verbose("[SubscriptionsManager] Trigger command [action=%u] after interval:%u ms\n",
-                      family_subscription.second.command.action, family_subscription.second.timer.GetDelay());
-      command_handler_->EnqueueCommand(family_subscription.second.command);
-      family_subscription.second.timer.Reset();
-    }
+  if (presence_search_pending_) {
+    EnqueuePresenceSearch();
+  }
+
+  if (store_pending_ && store_timer_.IsExpired()) {
+    Store();
   }
 }
 
 auto SubscriptionsManager::ProcessActionSubscribe(Command& cmd) -> void {
   logger_.Verbose("[SubscriptionsManager] process 'subscribe'");
-  DeviceAttributeType const device_attribute{cmd.param3.param_value.device_attribute};
-  TimeIntervalType const subscription_interval{cmd.param4.param_value.interval};
+  DeviceAttributeType const device_attribute{cmd.params.device_attribute};
+  TimeIntervalType const subscription_interval{cmd.params.interval};
+  SubscriptionOptions const options{command_attachments_g.GetSubscriptionOptions(cmd.subscription_options)};
+
+  if ((device_attribute == DeviceAttributeType::All) &&
+      (options.filter.on_change || (options.aggregation.publish_interval > 0) ||
+       (options.adaptation.max_interval > 0))) {
+    // Filter, aggregation and adaptation track a single value per device
+    command_handler_->SendErrorResponse(
+        cmd, "Filter, aggregation and adaptive sampling are not supported for attribute '*'.");
+
+  } else if (options.filter.on_change && (options.aggregation.publish_interval > 0)) {
+    // A window result is published once per window, the change filter would not apply to it
+    command_handler_->SendErrorResponse(cmd, "Filter ('on_change', 'deadband') and aggregation cannot be combined.");
+
+  } else if (HasReplyTopicConflict(cmd)) {
+    // An update must not redirect the results of another requester
+    command_handler_->SendErrorResponse(cmd, "Already subscribed with a different reply topic. Unsubscribe first.");
 
-  if (cmd.param1.param_available) {
+  } else if (not IsReplyTopicPersistable(cmd)) {
+    command_handler_->SendErrorResponse(cmd, "Max. number of reply topics of subscriptions reached.");
+
+  } else if (cmd.params.has_device_id) {
     // ---- Subscribe to a specific device ----
-    one_wire::OneWireAddress const& device_addr{cmd.param1.param_value.device_id};
+    one_wire::OneWireAddress const& device_addr{cmd.params.address.device_id};
 
     logger_.Debug(F("[SubscriptionsManager] Subscribing to device: %s, attribute: %u, interval: %u ms"),
                   device_addr.Format().c_str(), device_attribute, subscription_interval);
 
     ConvertSubscribeToReadCommand(cmd);
 
-    std::pair<SubscriptionsMapDevice::iterator, bool> const emplace_result{
-        subscriptions_device_.emplace(SubscriptionKeyDevice{device_addr, device_attribute},
-                                      SubscriptionInfo{Timer{subscription_interval.value}, cmd})};
-    if (emplace_result.second) {
+    bool is_new{false};
+    SubscriptionInfo* const subscription{
+        AddSubscription(CreateSubscriptionInfo(cmd, options, subscription_interval), is_new)};
+    if (subscription == nullptr) {
+      command_handler_->SendErrorResponse(cmd, "Max. number of subscriptions reached.");
+    } else if (is_new) {
       // Acknowledge subscription
-      JsonDocument json{};
+      JsonDocument json{&util::json_allocator_g};
       json[json::kRootAction] = json::kActionSubscribe;
       json[json::kActionSubscribeAcknowledge] = true;
       JsonObject json_device{json[json::kDevice].to<JsonObject>()};
@@ -63,10 +111,10 @@ auto SubscriptionsManager::ProcessActionSubscribe(Command& cmd) -> void {
       command_handler_->SendCommandResponse(cmd, json);
 
       // New subscription: Trigger command immediately
-      command_handler_->EnqueueCommand(cmd);
+      TriggerRead(*subscription);
+      Store();
     } else {
-      emplace_result.first->second.timer = Timer{subscription_interval.value};
-      emplace_result.first->second.command = cmd;
+      Store();
 
       logger_.Warn(F("[SubscriptionsManager] Already subscribed to device: %s, attribute: %u. Updating subscription."),
                    device_addr.Format().c_str(), device_attribute);
@@ -74,31 +122,33 @@ auto SubscriptionsManager::ProcessActionSubscribe(Command& cmd) -> void {
                                           "WARN: Already subscribed to device / attribute. Updating subscription.");
     }
 
-  } else if (cmd.param2.param_available) {
+  } else if (cmd.params.has_family_code) {
     // ---- Subscribe to a specific device family ----
-    one_wire::OneWireAddress::FamilyCode const& family_code{cmd.param2.param_value.family_code};
+    one_wire::OneWireAddress::FamilyCode const& family_code{cmd.params.address.family_code};
 
     logger_.Debug(F("[SubscriptionsManager] Subscribing to device family: 0x%X, attribute: %u, interval: %u ms"),
                   family_code, device_attribute, subscription_interval);
 
     ConvertSubscribeToReadCommand(cmd);
 
-    std::pair<SubscriptionsMapFamily::iterator, bool> const emplace_result{
-        subscriptions_family_.emplace(SubscriptionKeyFamily{family_code, device_attribute},
-                                      SubscriptionInfo{Timer{subscription_interval.value}, cmd})};
-    if (emplace_result.second) {
+    bool is_new{false};
+    SubscriptionInfo* const subscription{
+        AddSubscription(CreateSubscriptionInfo(cmd, options, subscription_interval), is_new)};
+    if (subscription == nullptr) {
+      command_handler_->SendErrorResponse(cmd, "Max. number of subscriptions reached.");
+    } else if (is_new) {
       // Acknowledge subscription
-      JsonDocument json{};
+      JsonDocument json{&util::json_allocator_g};
       json[json::kRootAction] = json::kActionSubscribe;
       json[json::kFamilyCode] = family_code;
       json[json::kActionSubscribeAcknowledge] = true;
       command_handler_->SendCommandResponse(cmd, json);
 
       // New subscription: Trigger command immediately
-      command_handler_->EnqueueCommand(cmd);
+      TriggerRead(*subscription);
+      Store();
     } else {
-      emplace_result.first->second.timer = Timer{subscription_interval.value};
-      emplace_result.first->second.command = cmd;
+      Store();
 
       logger_.Warn(F("[SubscriptionsManager] Already subscribed to device family: 0x%X, attribute: %u. Updating "
                      "subscription."),
@@ -106,28 +156,59 @@ auto SubscriptionsManager::ProcessActionSubscribe(Command& cmd) -> void {
       command_handler_->SendErrorResponse(
           cmd, "WARN: Already subscribed to device family / attribute. Updating subscription.");
     }
+
+  } else if (cmd.params.all_devices) {
+    // ---- Subscribe to all available devices ----
+    logger_.Debug(F("[SubscriptionsManager] Subscribing to all devices, attribute: %u, interval: %u ms"),
+                  device_attribute, subscription_interval);
+
+    ConvertSubscribeToReadCommand(cmd);
+
+    bool is_new{false};
+    SubscriptionInfo* const subscription{
+        AddSubscription(CreateSubscriptionInfo(cmd, options, subscription_interval), is_new)};
+    if (subscription == nullptr) {
+      command_handler_->SendErrorResponse(cmd, "Max. number of subscriptions reached.");
+    } else if (is_new) {
+      // Acknowledge subscription
+      JsonDocument json{&util::json_allocator_g};
+      json[json::kRootAction] = json::kActionSubscribe;
+      json[json::kActionSubscribeAcknowledge] = true;
+      JsonObject json_device{json[json::kDevice].to<JsonObject>()};
+      json_device[json::kDeviceId] = json::kWildcard;
+      command_handler_->SendCommandResponse(cmd, json);
+
+      // New subscription: Trigger read plan immediately
+      TriggerRead(*subscription);
+      Store();
+    } else {
+      Store();
+
+      logger_.Warn(F("[SubscriptionsManager] Already subscribed to all devices, attribute: %u. Updating subscription."),
+                   device_attribute);
+      command_handler_->SendErrorResponse(
+          cmd, "WARN: Already subscribed to all devices / attribute. Updating subscription.");
+    }
   }
 }
 
 auto SubscriptionsManager::ProcessActionUnsubscribe(Command& cmd) -> void {
   logger_.Verbose("[SubscriptionsManager] process 'unsubscribe'");
 
-  DeviceAttributeType const& device_attribute{cmd.param3.param_value.device_attribute};
+  DeviceAttributeType const& device_attribute{cmd.params.device_attribute};
 
-  if (cmd.param1.param_available) {
+  if (cmd.params.has_device_id) {
     // ---- Unsubscribe a specific device ----
-    one_wire::OneWireAddress const& device_addr{cmd.param1.param_value.device_id};
+    one_wire::OneWireAddress const& device_addr{cmd.params.address.device_id};
 
     logger_.Debug(F("[SubscriptionsManager] Unsubscribing from device: %s, attribute: %u"),
                   device_addr.Format().c_str(), device_attribute);
 
-    SubscriptionsMapDevice::iterator found_subscription(
-        subscriptions_device_.find(SubscriptionKeyDevice{device_addr, device_attribute}));
-    if (found_subscription != subscriptions_device_.end()) {
-      subscriptions_device_.erase(found_subscription);
+    if (RemoveSubscription(GetSubscriptionKey(cmd))) {
+      Store();
 
       // Acknowledge unsubscribe
-      JsonDocument json{};
+      JsonDocument json{&util::json_allocator_g};
       json[json::kRootAction] = json::kActionUnsubscribe;
       json[json::kActionSubscribeAcknowledge] = true;
       JsonObject json_device{json[json::kDevice].to<JsonObject>()};
@@ -139,20 +220,18 @@ auto SubscriptionsManager::ProcessActionUnsubscribe(Command& cmd) -> void {
       command_handler_->SendErrorResponse(cmd, "WARN: No subscription for requested device / attribute found.");
     }
 
-  } else if (cmd.param2.param_available) {
+  } else if (cmd.params.has_family_code) {
     // ---- Unsubscribe a specific device family ----
-    one_wire::OneWireAddress::FamilyCode const& family_code{cmd.param2.param_value.family_code};
+    one_wire::OneWireAddress::FamilyCode const& family_code{cmd.params.address.family_code};
 
     logger_.Debug(F("[SubscriptionsManager] Unsubscribing from device family: 0x%X, attribute: %u"), family_code,
                   device_attribute);
 
-    SubscriptionsMapFamily::iterator found_subscription(
-        subscriptions_family_.find(SubscriptionKeyFamily{family_code, device_attribute}));
-    if (found_subscription != subscriptions_family_.end()) {
-      subscriptions_family_.erase(found_subscription);
+    if (RemoveSubscription(GetSubscriptionKey(cmd))) {
+      Store();
 
       // Acknowledge unsubscribe
-      JsonDocument json{};
+      JsonDocument json{&util::json_allocator_g};
       json[json::kRootAction] = json::kActionUnsubscribe;
       json[json::kFamilyCode] = family_code;
       json[json::kActionSubscribeAcknowledge] = true;
@@ -162,33 +241,1300 @@ auto SubscriptionsManager::ProcessActionUnsubscribe(Command& cmd) -> void {
                     family_code, device_attribute);
       command_handler_->SendErrorResponse(cmd, "WARN: No subscription for requested device family found.");
     }
+
+  } else if (cmd.params.all_devices) {
+    // ---- Unsubscribe all devices ----
+    logger_.Debug(F("[SubscriptionsManager] Unsubscribing from all devices, attribute: %u"), device_attribute);
+
+    if (RemoveSubscription(GetSubscriptionKey(cmd))) {
+      Store();
+
+      // Acknowledge unsubscribe
+      JsonDocument json{&util::json_allocator_g};
+      json[json::kRootAction] = json::kActionUnsubscribe;
+      json[json::kActionSubscribeAcknowledge] = true;
+      JsonObject json_device{json[json::kDevice].to<JsonObject>()};
+      json_device[json::kDeviceId] = json::kWildcard;
+      command_handler_->SendCommandResponse(cmd, json);
+    } else {
+      logger_.Error(F("[SubscriptionsManager] No subscription found for all devices, attribute: %u"), device_attribute);
+      command_handler_->SendErrorResponse(cmd, "WARN: No subscription for all devices / attribute found.");
+    }
+  }
+}
+
+/*!
+ * Restore persisted subscriptions. Unlike new subscriptions the restored ones are not read immediately. Their first
+ * reads are spread evenly across their interval, so a restart does not cause a burst of reads. Afterwards they return
+ * to their aligned ticks.
+ * \param[in] result_callback Callback receiving the results of the restored subscriptions
+ * \param[in] error_result_callback Callback receiving the errors of the restored subscriptions
+ */
+auto SubscriptionsManager::Restore(config::SubscriptionsConfig const& subscriptions_config,
+                                   CommandResultCallback const& result_callback,
+                                   ErrorResultCallback const& error_result_callback) -> void {
+  std::vector<config::SubscriptionsConfig::Subscription> const& subscriptions{subscriptions_config.GetSubscriptions()};
+  std::size_t position{0};
+
+  for (config::SubscriptionsConfig::Subscription const& subscription : subscriptions) {
+    TimeIntervalType const interval{subscription.interval};
+
+    AttachmentHandle reply_to{kNoAttachment};
+    if (not command_attachments_g.AddText(subscriptions_config.GetReplyTopic(subscription.reply_topic), reply_to)) {
+      logger_.Warn(F("[SubscriptionsManager] Reply topic not restored. Results are published on the status topic."));
+    }
+
+    Command cmd{Timer{},
+                Timer{subscription.deadline},
+                Timer{},
+                CommandParams{},
+                result_callback,
+                error_result_callback,
+                CommandRequestId{RequestIdType::None, 0},
+                Action::Subscribe,
+                SubAction::None,
+                CommandPriority::Periodic,
+                static_cast<PayloadFormat>(subscription.payload_format),
+                reply_to,
+                kNoAttachment};
+    cmd.params.has_device_attribute = true;
+    cmd.params.device_attribute = static_cast<DeviceAttributeType>(subscription.attribute);
+    cmd.params.has_interval = true;
+    cmd.params.interval = interval;
+    SubscriptionOptions const options{
+        SubscriptionFilter{subscription.deadband, subscription.max_silence,
+                           static_cast<DeadbandType>(subscription.deadband_type), subscription.on_change},
+        SubscriptionAggregation{subscription.publish_interval, subscription.aggregates},
+        SubscriptionAdaptation{subscription.min_interval, subscription.max_interval, subscription.adaptive_delta}};
+    ConvertSubscribeToReadCommand(cmd);
+
+    if (subscription.all_devices) {
+      cmd.params.all_devices = true;
+    } else if (subscription.is_family) {
+      cmd.params.has_family_code = true;
+      cmd.params.address.family_code = subscription.family_code;
+    } else {
+      cmd.params.has_device_id = true;
+      cmd.params.address.device_id = one_wire::OneWireAddress{subscription.device_id};
+    }
+
+    bool is_new{false};
+    SubscriptionInfo* const restored{AddSubscription(CreateSubscriptionInfo(cmd, options, interval), is_new)};
+    command_attachments_g.Release(reply_to);  // Held by the subscription
+    if (restored == nullptr) {
+      break;
+    }
+
+    // Re-phase the first read by the position of the subscription within the restored ones
+    std::uint64_t const delay{restored->timer.GetDelay()};
+    restored->timer.Postpone(static_cast<std::uint32_t>(delay * position / subscriptions.size()));
+    Reschedule(*restored);
+    ++position;
   }
+
+  logger_.Info(F("[SubscriptionsManager] Restored %u subscriptions"), index_.size());
+}
+
+/*!
+ * The memory covers every allocation of the subscriptions: the tables and the per device values of every slot.
+ */
+auto SubscriptionsManager::GetStatistics() const -> SubscriptionsStatistics {
+  std::size_t memory{subscriptions_.capacity() * sizeof(SubscriptionInfo) +
+                     free_slots_.capacity() * sizeof(SubscriptionSlot) + index_.capacity() * sizeof(IndexEntry) +
+                     schedule_.capacity() * sizeof(ScheduleEntry) + generations_.capacity() * sizeof(std::uint16_t)};
+  for (SubscriptionInfo const& subscription : subscriptions_) {
+    memory += subscription.published_values.capacity() * sizeof(PublishedValue) +
+              subscription.aggregated_values.capacity() * sizeof(AggregatedValue) +
+              subscription.sampled_values.capacity() * sizeof(SampledValue) +
+              subscription.collected_values.capacity() * sizeof(CollectedValue);
+  }
+
+  return SubscriptionsStatistics{static_cast<std::uint16_t>(index_.size()), max_subscriptions_,
+                                 static_cast<std::uint32_t>(memory)};
 }
 
 // ---- Private APIs ---------------------------------------------------------------------------------------------------
 
-auto SubscriptionsManager::ConvertSubscribeToReadCommand(Command& cmd) -> void {
-  cmd.action = Action::Read;
+auto SubscriptionsManager::Store() -> void {
+  store_pending_ = false;
 
-  // Unset the 'interval' parameter
-  cmd.param4.param_available = false;
-  cmd.param4.param_value.interval = TimeIntervalType{0};
+  config::SubscriptionsConfig subscriptions_config{};
+  bool complete{true};
+
+  for (IndexEntry const& index_entry : index_) {
+    complete &= subscriptions_config.AddSubscription(
+        ToPersistedSubscription(subscriptions_[index_entry.slot], subscriptions_config));
+  }
+
+  if (not complete) {
+    logger_.Warn(F("[SubscriptionsManager] Only the first %u subscriptions are persisted"),
+                 config::SubscriptionsConfig::kMaxSubscriptions);
+  }
+  config::persistency_g.StoreSubscriptionsConfig(subscriptions_config);
+}
+
+/*!
+ * \param[in,out] subscriptions_config Receives the reply topic of the subscription.
+ */
+auto SubscriptionsManager::ToPersistedSubscription(SubscriptionInfo const& subscription,
+                                                   config::SubscriptionsConfig& subscriptions_config)
+    -> config::SubscriptionsConfig::Subscription {
+  CommandParams const& params{subscription.command.params};
+  SubscriptionOptions const& options{subscription.options};
+
+  std::uint8_t reply_topic{config::SubscriptionsConfig::kNoReplyTopic};
+  char const* const reply_to{command_attachments_g.GetText(subscription.command.reply_to)};
+  if (reply_to[0] != '\0') {
+    reply_topic = subscriptions_config.AddReplyTopic(reply_to);
+    if (reply_topic == config::SubscriptionsConfig::kNoReplyTopic) {
+      // Not expected: Subscribes with a further reply topic are rejected (see IsReplyTopicPersistable())
+      logging::logger_g.Warn(F("[SubscriptionsManager] Too many reply topics. '%s' is not persisted."), reply_to);
+    }
+  }
+
+  return config::SubscriptionsConfig::Subscription{
+      params.has_device_id ? params.address.device_id.GetFullAddress() : 0,
+      subscription.interval.value,
+      subscription.command.deadline.GetDelay(),
+      options.filter.deadband,
+      options.filter.max_silence,
+      options.aggregation.publish_interval,
+      options.adaptation.min_interval,
+      options.adaptation.max_interval,
+      options.adaptation.delta,
+      params.has_family_code ? params.address.family_code : static_cast<std::uint8_t>(0),
+      ToUnderlying(params.device_attribute),
+      ToUnderlying(options.filter.deadband_type),
+      options.aggregation.aggregates,
+      ToUnderlying(subscription.command.payload_format),
+      reply_topic,
+      params.has_family_code,
+      options.filter.on_change,
+      params.all_devices};
+}
+
+auto SubscriptionsManager::CreateSubscriptionInfo(Command const& cmd, SubscriptionOptions const& options,
+                                                  TimeIntervalType interval) -> SubscriptionInfo {
+  SubscriptionAdaptation const& adaptation{options.adaptation};
+  std::uint32_t const requested_interval{interval.value};
+  if (adaptation.max_interval > 0) {
+    // Start adaptive sampling within its bounds
+    interval.value = std::min(std::max(interval.value, adaptation.min_interval), adaptation.max_interval);
+  }
+
+  SubscriptionInfo subscription{Timer::Aligned(interval.value),
+                                interval,
+                                GetConversionTime(cmd.params),
+                                cmd,
+                                options,
+                                cmd.result_callback,
+                                PublishedValues{},
+                                Timer{},
+                                AggregatedValues{},
+                                0,
+                                CollectedValues{},
+                                0,
+                                SampledValues{},
+                                0.0F,
+                                false,
+                                false};
+  std::size_t const tracked_devices{cmd.params.has_device_id ? 1 : static_cast<std::size_t>(kMaxTrackedDevices)};
+  if (options.filter.on_change) {
+    subscription.published_values.resize(tracked_devices);
+  }
+  if (options.aggregation.publish_interval > 0) {
+    subscription.publish_timer = Timer::Aligned(options.aggregation.publish_interval);
+    subscription.aggregated_values.resize(tracked_devices);
+  }
+  if (adaptation.max_interval > 0) {
+    subscription.sampled_values.resize(tracked_devices);
+  }
+  // The options are kept by the subscription. Its cyclic reads do not reference them.
+  subscription.command.subscription_options = kNoAttachment;
+  AdaptDeadline(subscription.command, requested_interval, interval.value);
+  if (options.filter.on_change || (options.aggregation.publish_interval > 0) || (adaptation.max_interval > 0)) {
+    // Route the results of the cyclic reads through the adaptation, the filter or the aggregation
+    subscription.command.result_callback = CommandResultCallback{&SubscriptionsManager::HandleReadResult, this};
+  }
+  return subscription;
+}
+
+/*!
+ * \return True if a subscription with the same key publishes its results to a different reply topic.
+ */
+auto SubscriptionsManager::HasReplyTopicConflict(Command const& cmd) -> bool {
+  SubscriptionInfo const* const subscription{FindSubscription(cmd)};
+  // Reply topics are interned: Equal topics share their attachment
+  return (subscription != nullptr) && (subscription->command.reply_to != cmd.reply_to);
+}
+
+/*!
+ * The number of distinct persisted reply topics is limited. A subscription with a further reply topic is rejected, as
+ * its results would be published on the status topic after a restart.
+ * \return True if the reply topic of the subscribe command can be persisted along with the existing ones.
+ */
+auto SubscriptionsManager::IsReplyTopicPersistable(Command const& cmd) const -> bool {
+  if (cmd.reply_to == kNoAttachment) {
+    return true;
+  }
+
+  config::SubscriptionsConfig subscriptions_config{};
+  for (IndexEntry const& index_entry : index_) {
+    char const* const reply_to{command_attachments_g.GetText(subscriptions_[index_entry.slot].command.reply_to)};
+    if (reply_to[0] != '\0') {
+      subscriptions_config.AddReplyTopic(reply_to);
+    }
+  }
+
+  return subscriptions_config.AddReplyTopic(command_attachments_g.GetText(cmd.reply_to)) !=
+         config::SubscriptionsConfig::kNoReplyTopic;
+}
+
+auto SubscriptionsManager::FindSubscription(Command const& cmd) -> SubscriptionInfo* {
+  SubscriptionInfo* result{nullptr};
+
+  SubscriptionKey const key{GetSubscriptionKey(cmd)};
+  std::vector<IndexEntry>::iterator const index_entry{FindIndexEntry(key)};
+  if ((index_entry != index_.end()) && (index_entry->key == key)) {
+    result = &subscriptions_[index_entry->slot];
+  }
+
+  return result;
+}
+
+/*!
+ * Add a new subscription or update the existing subscription with the same key.
+ * \param[out] is_new True if the subscription was added
+ * \return Subscription in the table. nullptr if the max. number of subscriptions is reached.
+ */
+auto SubscriptionsManager::AddSubscription(SubscriptionInfo const& subscription, bool& is_new) -> SubscriptionInfo* {
+  SubscriptionInfo* result{nullptr};
+
+  SubscriptionKey const key{GetSubscriptionKey(subscription.command)};
+  std::vector<IndexEntry>::iterator const index_entry{FindIndexEntry(key)};
+  if ((index_entry != index_.end()) && (index_entry->key == key)) {
+    SubscriptionSlot const slot{index_entry->slot};
+    Unschedule(slot);
+    command_attachments_g.Retain(subscription.command);
+    command_attachments_g.Release(subscriptions_[slot].command);
+    subscriptions_[slot] = subscription;
+    Schedule(slot);
+    is_new = false;
+    result = &subscriptions_[slot];
+  } else if (index_.size() < max_subscriptions_) {
+    SubscriptionSlot slot{0};
+    if (free_slots_.empty()) {
+      slot = static_cast<SubscriptionSlot>(subscriptions_.size());
+      subscriptions_.push_back(subscription);
+      generations_.push_back(0);
+    } else {
+      slot = free_slots_.back();
+      free_slots_.pop_back();
+      subscriptions_[slot] = subscription;
+    }
+    command_attachments_g.Retain(subscription.command);
+    index_.insert(index_entry, IndexEntry{key, slot});
+    Schedule(slot);
+    is_new = true;
+    result = &subscriptions_[slot];
+  } else {
+    logger_.Warn(F("[SubscriptionsManager] Max. number of subscriptions (%u) reached"), max_subscriptions_);
+  }
+
+  return result;
+}
+
+auto SubscriptionsManager::RemoveSubscription(SubscriptionKey const& key) -> bool {
+  bool result{false};
+
+  std::vector<IndexEntry>::iterator const index_entry{FindIndexEntry(key)};
+  if ((index_entry != index_.end()) && (index_entry->key == key)) {
+    SubscriptionSlot const slot{index_entry->slot};
+    index_.erase(index_entry);
+    Unschedule(slot);
+    command_attachments_g.Release(subscriptions_[slot].command);
+    subscriptions_[slot] = SubscriptionInfo{};  // Release the per device values
+    free_slots_.push_back(slot);
+    result = true;
+  }
+
+  return result;
+}
+
+/*!
+ * \return First index entry not less than the key
+ */
+auto SubscriptionsManager::FindIndexEntry(SubscriptionKey const& key) -> std::vector<IndexEntry>::iterator {
+  return std::lower_bound(index_.begin(), index_.end(), key,
+                          [](IndexEntry const& entry, SubscriptionKey const& other) { return entry.key < other; });
+}
+
+/*!
+ * Add the slot to the schedule. Due time is the start of the next read (see GetLeadTime()) or, if earlier, the next
+ * expiry of the publish timer.
+ */
+auto SubscriptionsManager::Schedule(SubscriptionSlot slot) -> void {
+  SubscriptionInfo const& subscription{subscriptions_[slot]};
+
+  time::TimeStampMs const expiry_time{subscription.timer.GetExpiryTime()};
+  std::uint32_t const lead_time{GetLeadTime(subscription)};
+  time::TimeStampMs due_time{(expiry_time > lead_time) ? (expiry_time - lead_time) : 0};
+  if (subscription.options.aggregation.publish_interval > 0) {
+    due_time = std::min(due_time, subscription.publish_timer.GetExpiryTime());
+  }
+
+  schedule_.push_back(ScheduleEntry{due_time, slot, generations_[slot]});
+  std::push_heap(schedule_.begin(), schedule_.end(), &SubscriptionsManager::IsDueLater);
+  subscriptions_[slot].scheduled = true;
+}
+
+/*!
+ * Invalidates the schedule entry of the slot by advancing the generation of the slot. The stale entry is dropped when
+ * it reaches the front of the heap or by the compaction, once the stale entries outnumber the subscriptions. The
+ * compaction also bounds the generations a stale entry lives, so the 16 bit generation does not wrap meanwhile.
+ */
+auto SubscriptionsManager::Unschedule(SubscriptionSlot slot) -> void {
+  if (subscriptions_[slot].scheduled) {
+    ++generations_[slot];
+    subscriptions_[slot].scheduled = false;
+    ++stale_entries_;
+    if (stale_entries_ > index_.size()) {
+      CompactSchedule();
+    }
+  }
+}
+
+/*!
+ * Update the due time after a timer of the subscription changed. A subscription currently processed by Loop() is not
+ * scheduled and gets scheduled by Loop() afterwards.
+ */
+auto SubscriptionsManager::Reschedule(SubscriptionInfo& subscription) -> void {
+  if (subscription.scheduled) {
+    SubscriptionSlot const slot{static_cast<SubscriptionSlot>(&subscription - subscriptions_.data())};
+    Unschedule(slot);
+    Schedule(slot);
+  }
+}
+
+auto SubscriptionsManager::CompactSchedule() -> void {
+  schedule_.erase(std::remove_if(schedule_.begin(), schedule_.end(),
+                                 [this](ScheduleEntry const& entry) {
+                                   return entry.generation != generations_[entry.slot];
+                                 }),
+                  schedule_.end());
+  std::make_heap(schedule_.begin(), schedule_.end(), &SubscriptionsManager::IsDueLater);
+  stale_entries_ = 0;
+}
+
+/*!
+ * The reads of a wildcard read plan carry the wildcard bits, so their results map to the wildcard subscription.
+ */
+auto SubscriptionsManager::GetSubscriptionKey(Command const& cmd) -> SubscriptionKey {
+  CommandParams const& params{cmd.params};
+
+  SubscriptionKey key{AddressScope::Device, 0,
+                      params.all_attributes ? DeviceAttributeType::All : params.device_attribute};
+  if (params.all_devices) {
+    key.scope = AddressScope::AllDevices;
+  } else if (params.has_family_code) {
+    key.scope = AddressScope::Family;
+    key.address = params.address.family_code;
+  } else if (params.has_device_id) {
+    key.address = params.address.device_id.GetFullAddress();
+  }
+  return key;
+}
+
+/*!
+ * Heap order of the schedule: The entry due first is at the front.
+ */
+auto SubscriptionsManager::IsDueLater(ScheduleEntry const& lhs, ScheduleEntry const& rhs) -> bool {
+  return lhs.due_time > rhs.due_time;
+}
+
+/*!
+ * Triggers the cyclic read and, for windowed subscriptions, publishes the aggregates at the end of the window.
+ */
+auto SubscriptionsManager::ProcessSubscription(SubscriptionInfo& subscription) -> void {
+  if (subscription.timer.ExpiresWithin(GetLeadTime(subscription))) {
+    logger_.Verbose("[SubscriptionsManager] Trigger command [action=%u] after interval:%u ms",
+                    subscription.command.action, subscription.interval.value);
+    TriggerRead(subscription, subscription.timer);
+    subscription.timer.Advance();
+  }
+
+  if ((subscription.options.aggregation.publish_interval > 0) && subscription.publish_timer.IsExpired()) {
+    PublishAggregates(subscription);
+    subscription.publish_timer.Advance();
+  }
+}
+
+/*!
+ * Starts the read of a subscription. The conversion starts immediately, the result is read when the result timer
+ * expires (the tick of a cyclic read), so the published time stays on the interval grid.
+ */
+auto SubscriptionsManager::TriggerRead(SubscriptionInfo& subscription, Timer const& result_timer) -> void {
+  subscription.command.result_timer = result_timer;
+
+  if (IsPresence(subscription.command.params)) {
+    // Served by the shared presence search enqueued at the end of the Loop()
+    subscription.presence_pending = true;
+    presence_search_pending_ = true;
+    std::uint32_t const deadline{subscription.command.deadline.GetDelay()};
+    if ((presence_search_deadline_ == 0) || ((deadline > 0) && (deadline < presence_search_deadline_))) {
+      presence_search_deadline_ = deadline;
+    }
+  } else if (IsWildcard(subscription.command.params)) {
+    ExecuteReadPlan(subscription);
+  } else {
+    subscription.command.deadline.Reset();
+    command_handler_->EnqueueCommand(subscription.command);
+  }
+}
+
+/*!
+ * Time [ms] from the start of a read until its result is available. Presence reads are immediate. Temperature reads of
+ * DS18B20 devices wait for the conversion of the configured resolution (worst case if unknown).
+ */
+auto SubscriptionsManager::GetConversionTime(CommandParams const& params) -> std::uint32_t {
+  std::uint32_t result{0};
+
+  if (params.all_devices) {
+    result = std::max(GetFamilyConversionTime(one_wire::Ds18b20::kFamilyCode, params.device_attribute),
+                      GetFamilyConversionTime(one_wire::Ds2438::kFamilyCode, params.device_attribute));
+  } else if (params.has_family_code) {
+    result = GetFamilyConversionTime(params.address.family_code, params.device_attribute);
+  } else if (params.has_device_id) {
+    result = GetFamilyConversionTime(params.address.device_id.GetFamilyCode(), params.device_attribute);
+
+    std::shared_ptr<one_wire::OneWireDevice> const ow_device{
+        (one_wire_system_ != nullptr) ? one_wire_system_->GetAvailableDevice(params.address.device_id) : nullptr};
+    if ((result > 0) && ow_device && one_wire::Ds18b20::MatchesFamily(*ow_device)) {
+      result = one_wire::Ds18b20::FromDevice(*ow_device)->GetSamplingTime();
+    }
+  }
+
+  return result;
+}
+
+auto SubscriptionsManager::GetFamilyConversionTime(one_wire::OneWireAddress::FamilyCode family_code,
+                                                   DeviceAttributeType attribute) -> std::uint32_t {
+  std::uint32_t result{0};
+
+  if (attribute != DeviceAttributeType::Presence) {
+    switch (family_code) {
+      case one_wire::Ds18b20::kFamilyCode:
+        if ((attribute == DeviceAttributeType::Temperature) || (attribute == DeviceAttributeType::All)) {
+          result = one_wire::Ds18b20::kWorstCaseSamplingTime;
+        }
+        break;
+      case one_wire::Ds2438::kFamilyCode:
+        result = one_wire::Ds2438::kSamplingTime;
+        break;
+      default:
+        break;
+    }
+  }
+
+  return result;
+}
+
+/*!
+ * Conversions are started ahead of the tick by the conversion time, so the result is read and published at the tick.
+ * Limited to the interval, so a read is triggered at most once per interval.
+ */
+auto SubscriptionsManager::GetLeadTime(SubscriptionInfo const& subscription) -> std::uint32_t {
+  return std::min(subscription.conversion_time, subscription.timer.GetDelay());
+}
+
+/*!
+ * Enqueues one search of all 1-wire channels for all presence subscriptions due in this tick as periodic scan command.
+ * Its deadline is the shortest deadline of the due subscriptions. While a search is still queued, the subscriptions
+ * due meanwhile are served by that search.
+ */
+auto SubscriptionsManager::EnqueuePresenceSearch() -> void {
+  presence_search_pending_ = false;
+
+  if (not presence_search_enqueued_) {
+    Command search_cmd{Timer{},
+                       Timer{presence_search_deadline_},
+                       Timer{},
+                       CommandParams{},
+                       CommandResultCallback{&SubscriptionsManager::HandlePresenceSearchResult, this},
+                       ErrorResultCallback{&SubscriptionsManager::HandlePresenceSearchError, this},
+                       CommandRequestId{RequestIdType::None, 0},
+                       Action::Scan,
+                       SubAction::None,
+                       CommandPriority::Periodic,
+                       PayloadFormat::Json,
+                       kNoAttachment,
+                       kNoAttachment};
+    search_cmd.params.all_devices = true;
+    presence_search_deadline_ = 0;
+
+    // Set before enqueuing: A rejected search completes immediately via the error callback.
+    presence_search_enqueued_ = true;
+    command_handler_->EnqueueCommand(search_cmd);
+  }
+}
+
+auto SubscriptionsManager::HandlePresenceSearchResult(void* ctx, Command const& cmd, JsonDocument& command_result)
+    -> void {
+  static_cast<SubscriptionsManager*>(ctx)->CompletePresenceSearch(true, ErrorCode::Generic, nullptr);
+}
+
+auto SubscriptionsManager::HandlePresenceSearchError(void* ctx, Command const& cmd, ErrorCode error_code,
+                                                     char const* error_message, char const* request_json) -> void {
+  static_cast<SubscriptionsManager*>(ctx)->CompletePresenceSearch(false, error_code, error_message);
+}
+
+/*!
+ * The search is diffed against the known devices: Arrivals and departures are published immediately to every presence
+ * subscription covering the device, due or not. The due subscriptions are then served from the updated list of
+ * available devices, or receive the error of the search (e.g. busy or expired).
+ */
+auto SubscriptionsManager::CompletePresenceSearch(bool search_result, ErrorCode error_code, char const* error_message)
+    -> void {
+  presence_search_enqueued_ = false;
+
+  one_wire::OneWireSystem::PresenceChanges const changes{one_wire_system_->TakePresenceChanges()};
+  logger_.Verbose(F("[SubscriptionsManager] Presence search: %u devices arrived / departed"), changes.size());
+
+  for (IndexEntry const& index_entry : index_) {
+    SubscriptionInfo& subscription{subscriptions_[index_entry.slot]};
+    CommandParams const& params{subscription.command.params};
+
+    if (IsPresence(params)) {
+      for (one_wire::OneWireSystem::PresenceChange const& change : changes) {
+        if (CoversDevice(params, change.address)) {
+          PublishPresenceChange(subscription, change);
+        }
+      }
+
+      if (subscription.presence_pending) {
+        subscription.presence_pending = false;
+        if (search_result) {
+          PublishPresence(subscription);
+        } else {
+          command_handler_->SendErrorResponse(subscription.command, error_code, error_message);
+        }
+      }
+    }
+  }
+}
+
+/*!
+ * Publishes the periodic presence result in the layout of a presence read: The addressed device (present or not) or
+ * the present devices of the family / of all families.
+ */
+auto SubscriptionsManager::PublishPresence(SubscriptionInfo& subscription) -> void {
+  CommandParams const& params{subscription.command.params};
+  one_wire::OneWireSystem::DeviceMap const& ow_devices{one_wire_system_->GetAvailableDevices()};
+
+  JsonDocument json{&util::json_allocator_g};
+  json[json::kRootAction] = json::kActionRead;
+
+  if (params.has_device_id) {
+    one_wire::OneWireSystem::DeviceMap::const_iterator const ow_device{ow_devices.find(params.address.device_id)};
+    bool const is_present{ow_device != ow_devices.end()};
+
+    JsonObject json_device{json[json::kDevice].to<JsonObject>()};
+    if (is_present && ow_device->second) {
+      json_device[json::kChannel] = ow_device->second->GetBusId();
+    }
+    json_device[json::kDeviceId] = params.address.device_id.Format().c_str();
+    json_device[json::kAttributePresence] = is_present;
+  } else {
+    if (params.has_family_code) {
+      json[json::kFamilyCode] = params.address.family_code;
+    }
+    JsonArray json_devices{json[json::kDevices].to<JsonArray>()};
+    for (one_wire::OneWireSystem::DeviceMap::value_type const& ow_device : ow_devices) {
+      if (CoversDevice(params, ow_device.first)) {
+        JsonObject json_device{json_devices.add<JsonObject>()};
+        if (ow_device.second) {
+          json_device[json::kChannel] = ow_device.second->GetBusId();
+        }
+        json_device[json::kDeviceId] = ow_device.first.Format().c_str();
+        json_device[json::kAttributePresence] = true;
+      }
+    }
+  }
+
+  PublishReadResult(subscription, json);
+}
+
+/*!
+ * Events bypass the aggregation and the filter. The filter still tracks the published state, so the next periodic
+ * result does not repeat the event.
+ */
+auto SubscriptionsManager::PublishPresenceChange(SubscriptionInfo& subscription,
+                                                 one_wire::OneWireSystem::PresenceChange const& change) -> void {
+  Command const& cmd{subscription.command};
+  CommandResultCallback const& result_callback{subscription.result_callback};
+
+  JsonDocument json{&util::json_allocator_g};
+  json[json::kRootAction] = json::kActionRead;
+  json[json::kEvent] = change.is_present ? json::kEventArrived : json::kEventDeparted;
+  if (cmd.params.has_family_code) {
+    json[json::kFamilyCode] = cmd.params.address.family_code;
+  }
+  JsonObject json_device{json[json::kDevice].to<JsonObject>()};
+  if (change.is_present) {
+    json_device[json::kChannel] = change.bus_id;
+  }
+  json_device[json::kDeviceId] = change.address.Format().c_str();
+  json_device[json::kAttributePresence] = change.is_present;
+
+  if (subscription.options.filter.on_change) {
+    FilterDeviceValue(subscription, json_device, json::kAttributePresence);
+  }
+
+  if (result_callback.func != nullptr && result_callback.ctx != nullptr) {
+    result_callback.func(result_callback.ctx, cmd, json);
+  }
+}
+
+auto SubscriptionsManager::IsPresence(CommandParams const& params) -> bool {
+  return params.device_attribute == DeviceAttributeType::Presence;
+}
+
+/*!
+ * \return True if the device is addressed by the subscription (device, family or all devices)
+ */
+auto SubscriptionsManager::CoversDevice(CommandParams const& params, one_wire::OneWireAddress const& address) -> bool {
+  bool result{params.all_devices};
+  if (params.has_device_id) {
+    result = (params.address.device_id == address);
+  } else if (params.has_family_code) {
+    result = (params.address.family_code == address.GetFamilyCode());
+  }
+  return result;
+}
+
+/*!
+ * Enqueues one read per device family and attribute of a wildcard subscription. The results are merged per device and
+ * published as a single result once all reads completed. Reads still pending at the next tick (e.g. expired reads)
+ * are given up and the results received so far are published.
+ */
+auto SubscriptionsManager::ExecuteReadPlan(SubscriptionInfo& subscription) -> void {
+  if (subscription.pending_reads > 0) {
+    logger_.Warn(F("[SubscriptionsManager] %u reads of the previous tick still pending"), subscription.pending_reads);
+    PublishCollectedResult(subscription);
+  }
+
+  CommandParams const& params{subscription.command.params};
+  std::vector<CommandParams> const read_plan{CreateReadPlan(params)};
+
+  // One entry per available device. The table only grows with the number of devices on the bus.
+  CollectedValues& collected_values{subscription.collected_values};
+  std::size_t const devices{params.has_device_id ? 1 : one_wire_system_->GetAvailableDevices().size()};
+  if (collected_values.size() < devices) {
+    collected_values.resize(devices);
+  }
+  for (CollectedValue& collected_value : collected_values) {
+    collected_value.address = one_wire::OneWireAddress{0};
+  }
+
+  // Set before enqueuing: Reads rejected by EnqueueCommand() complete immediately via the error callback.
+  subscription.pending_reads = static_cast<std::uint16_t>(read_plan.size());
+
+  Command read_cmd{subscription.command};
+  read_cmd.deadline.Reset();
+  read_cmd.result_callback = CommandResultCallback{&SubscriptionsManager::HandleReadResult, this};
+  read_cmd.error_result_callback = ErrorResultCallback{&SubscriptionsManager::HandleReadError, this};
+  for (CommandParams const& read_params : read_plan) {
+    read_cmd.params = read_params;
+    command_handler_->EnqueueCommand(read_cmd);
+  }
+}
+
+/*!
+ * Reads of a wildcard subscription: One read per device family (all devices) or of the addressed device / family.
+ * Attribute '*' reads every measured attribute of the family.
+ */
+auto SubscriptionsManager::CreateReadPlan(CommandParams const& params) -> std::vector<CommandParams> {
+  std::vector<CommandParams> read_plan{};
+
+  std::vector<one_wire::OneWireAddress::FamilyCode> family_codes{};
+  if (params.has_device_id) {
+    family_codes.push_back(params.address.device_id.GetFamilyCode());
+  } else if (params.has_family_code) {
+    family_codes.push_back(params.address.family_code);
+  } else {
+    for (one_wire::OneWireSystem::DeviceMap::value_type const& ow_device : one_wire_system_->GetAvailableDevices()) {
+      one_wire::OneWireAddress::FamilyCode const family_code{ow_device.first.GetFamilyCode()};
+      if (std::find(family_codes.begin(), family_codes.end(), family_code) == family_codes.end()) {
+        family_codes.push_back(family_code);
+      }
+    }
+  }
+
+  for (one_wire::OneWireAddress::FamilyCode const family_code : family_codes) {
+    std::vector<DeviceAttributeType> const measured_attributes{GetMeasuredAttributes(family_code)};
+    std::vector<DeviceAttributeType> attributes{};
+    if (params.device_attribute == DeviceAttributeType::All) {
+      attributes = measured_attributes;
+    } else if ((params.device_attribute == DeviceAttributeType::Presence) ||
+               (std::find(measured_attributes.begin(), measured_attributes.end(), params.device_attribute) !=
+                measured_attributes.end())) {
+      attributes.push_back(params.device_attribute);
+    }
+
+    for (DeviceAttributeType const attribute : attributes) {
+      CommandParams read_params{params};
+      read_params.device_attribute = attribute;
+      read_params.all_attributes = (params.device_attribute == DeviceAttributeType::All);
+      if (not params.has_device_id) {
+        read_params.has_family_code = true;
+        read_params.address.family_code = family_code;
+      }
+      read_plan.push_back(read_params);
+    }
+  }
+
+  return read_plan;
+}
+
+auto SubscriptionsManager::GetMeasuredAttributes(one_wire::OneWireAddress::FamilyCode family_code)
+    -> std::vector<DeviceAttributeType> {
+  std::vector<DeviceAttributeType> result{};
+
+  switch (family_code) {
+    case one_wire::Ds18b20::kFamilyCode:
+      result = {DeviceAttributeType::Temperature};
+      break;
+    case one_wire::Ds2438::kFamilyCode:
+      result = {DeviceAttributeType::Temperature, DeviceAttributeType::VAD, DeviceAttributeType::VDD};
+      break;
+    default:
+      break;
+  }
+
+  return result;
+}
+
+/*!
+ * Error callback of the reads of a wildcard read plan. The error is forwarded to the subscriber and the read counts
+ * as completed.
+ */
+auto SubscriptionsManager::HandleReadError(void* ctx, Command const& cmd, ErrorCode error_code,
+                                           char const* error_message, char const* request_json) -> void {
+  SubscriptionsManager* const subscriptions_manager{static_cast<SubscriptionsManager*>(ctx)};
+  SubscriptionInfo* const subscription{subscriptions_manager->FindSubscription(cmd)};
+
+  if (subscription != nullptr) {
+    ErrorResultCallback const& error_result_callback{subscription->command.error_result_callback};
+    if (error_result_callback.func != nullptr && error_result_callback.ctx != nullptr) {
+      error_result_callback.func(error_result_callback.ctx, cmd, error_code, error_message, request_json);
+    }
+    subscriptions_manager->CompletePlannedRead(*subscription);
+  }
+}
+
+/*!
+ * Merges the devices of a read result into the collected values. Attributes of a device read by different reads of
+ * the plan are merged into a single entry. Results arriving after the tick was published are dropped.
+ */
+auto SubscriptionsManager::CollectReadResult(SubscriptionInfo& subscription, JsonDocument const& command_result)
+    -> void {
+  if (subscription.pending_reads > 0) {
+    if (command_result[json::kDevice].is<JsonObjectConst>()) {
+      CollectDeviceValues(subscription, command_result[json::kDevice].as<JsonObjectConst>());
+    } else if (command_result[json::kDevices].is<JsonArrayConst>()) {
+      for (JsonVariantConst json_device : command_result[json::kDevices].as<JsonArrayConst>()) {
+        CollectDeviceValues(subscription, json_device.as<JsonObjectConst>());
+      }
+    }
+  }
+
+  CompletePlannedRead(subscription);
+}
+
+/*!
+ * A device takes the first unused entry of the tick. Devices exceeding the table (plugged in during the tick) are
+ * collected in the next tick.
+ */
+auto SubscriptionsManager::CollectDeviceValues(SubscriptionInfo& subscription, JsonObjectConst json_device) -> void {
+  one_wire::OneWireAddress address{};
+  CollectedValue* const collected_value{
+      one_wire::OneWireAddress::FromOwfsFormat(json_device[json::kDeviceId].as<char const*>(), address)
+          ? FindDeviceEntry(subscription.collected_values, address)
+          : nullptr};
+
+  if (collected_value != nullptr) {
+    if (collected_value->address == 0) {
+      *collected_value = CollectedValue{address, {}, 0, 0, false};
+    }
+    if (json_device[json::kChannel].is<std::uint8_t>()) {
+      collected_value->channel = json_device[json::kChannel].as<std::uint8_t>();
+      collected_value->has_channel = true;
+    }
+    for (std::size_t index{0}; index < kCollectedAttributeCount; ++index) {
+      float value{0.0F};
+      if (GetDeviceValue(json_device, GetAttributeKey(kCollectedAttributes[index]), value)) {
+        collected_value->values[index] = value;
+        collected_value->attributes |= static_cast<std::uint8_t>(1U << index);
+      }
+    }
+  }
+}
+
+auto SubscriptionsManager::CompletePlannedRead(SubscriptionInfo& subscription) -> void {
+  if (subscription.pending_reads > 0) {
+    --subscription.pending_reads;
+    if (subscription.pending_reads == 0) {
+      PublishCollectedResult(subscription);
+    }
+  }
+}
+
+/*!
+ * Publishes the merged result of a wildcard subscription. A single device is published in the layout of a single
+ * device read. Nothing is published if no device was read.
+ */
+auto SubscriptionsManager::PublishCollectedResult(SubscriptionInfo& subscription) -> void {
+  CommandParams const& params{subscription.command.params};
+  CollectedValues const& collected_values{subscription.collected_values};
+
+  if ((not collected_values.empty()) && (collected_values.front().address != 0)) {
+    JsonDocument json{&util::json_allocator_g};
+    json[json::kRootAction] = json::kActionRead;
+    JsonArray json_devices{};
+    if (params.has_family_code) {
+      json[json::kFamilyCode] = params.address.family_code;
+    }
+    if (not params.has_device_id) {
+      json_devices = json[json::kDevices].to<JsonArray>();
+    }
+
+    char device_id[one_wire::OneWireAddress::kFormattedLength + 1];
+    for (CollectedValue const& collected_value : collected_values) {
+      if (collected_value.address == 0) {
+        break;  // Entries are used in order
+      }
+
+      JsonObject json_device{params.has_device_id ? json[json::kDevice].to<JsonObject>()
+                                                  : json_devices.add<JsonObject>()};
+      if (collected_value.has_channel) {
+        json_device[json::kChannel] = collected_value.channel;
+      }
+      json_device[json::kDeviceId] = collected_value.address.Format(device_id);
+      for (std::size_t index{0}; index < kCollectedAttributeCount; ++index) {
+        if ((collected_value.attributes & (1U << index)) != 0) {
+          json_device[GetAttributeKey(kCollectedAttributes[index])] = collected_value.values[index];
+        }
+      }
+    }
+
+    PublishReadResult(subscription, json);
+  }
+
+  subscription.pending_reads = 0;
+}
+
+auto SubscriptionsManager::IsWildcard(CommandParams const& params) -> bool {
+  return params.all_devices || params.all_attributes || (params.device_attribute == DeviceAttributeType::All);
+}
+
+/*!
+ * Result callback of cyclic reads of filtered, windowed and wildcard subscriptions. Results of meanwhile removed
+ * subscriptions are dropped.
+ */
+auto SubscriptionsManager::HandleReadResult(void* ctx, Command const& cmd, JsonDocument& command_result) -> void {
+  SubscriptionsManager* const subscriptions_manager{static_cast<SubscriptionsManager*>(ctx)};
+  SubscriptionInfo* const subscription{subscriptions_manager->FindSubscription(cmd)};
+
+  if (subscription != nullptr) {
+    if (IsWildcard(subscription->command.params)) {
+      subscriptions_manager->CollectReadResult(*subscription, command_result);
+    } else {
+      subscriptions_manager->PublishReadResult(*subscription, command_result);
+    }
+  }
 }
 
-auto SubscriptionsManager::SubscriptionKeyDevice::operator==(SubscriptionKeyDevice const& other) const -> bool {
-  return std::tie(address, attribute) == std::tie(other.address, other.attribute);
+/*!
+ * Windowed subscriptions accumulate the values until the end of the window. Otherwise the result is forwarded to the
+ * subscriber if at least one value passes the filter.
+ */
+auto SubscriptionsManager::PublishReadResult(SubscriptionInfo& subscription, JsonDocument& command_result) -> void {
+  Command const& cmd{subscription.command};
+
+  if (subscription.options.adaptation.max_interval > 0) {
+    AdaptInterval(subscription, command_result);
+  }
+
+  if (subscription.options.aggregation.publish_interval > 0) {
+    AggregateReadResult(subscription, cmd.params.device_attribute, command_result);
+  } else if ((not subscription.options.filter.on_change) ||
+             FilterReadResult(subscription, cmd.params.device_attribute, command_result)) {
+    CommandResultCallback const& result_callback{subscription.result_callback};
+    if (result_callback.func != nullptr && result_callback.ctx != nullptr) {
+      result_callback.func(result_callback.ctx, cmd, command_result);
+    }
+  }
 }
 
-auto SubscriptionsManager::SubscriptionKeyDevice::operator<(SubscriptionKeyDevice const& other) const -> bool {
-  return std::tie(address, attribute) < std::tie(other.address, other.attribute);
+/*!
+ * Removes unchanged devices from family read results.
+ * \return True if the (remaining) result has to be published
+ */
+auto SubscriptionsManager::FilterReadResult(SubscriptionInfo& subscription, DeviceAttributeType attribute,
+                                            JsonDocument& command_result) -> bool {
+  bool publish{true};
+  char const* const attribute_key{GetAttributeKey(attribute)};
+
+  if (command_result[json::kDevice].is<JsonObject>()) {
+    publish = FilterDeviceValue(subscription, command_result[json::kDevice].as<JsonObject>(), attribute_key);
+  } else if (command_result[json::kDevices].is<JsonArray>()) {
+    JsonArray json_devices{command_result[json::kDevices].as<JsonArray>()};
+    std::size_t index{0};
+    while (index < json_devices.size()) {
+      if (FilterDeviceValue(subscription, json_devices[index].as<JsonObject>(), attribute_key)) {
+        ++index;
+      } else {
+        json_devices.remove(index);
+      }
+    }
+    publish = (json_devices.size() > 0);
+  }
+
+  return publish;
+}
+
+/*!
+ * A value is published if it changed by at least the deadband (booleans: any change) or if the last publishing of
+ * the device is older than max_silence. The first value of a device is always published, as are the values of
+ * devices exceeding the tracked devices.
+ */
+auto SubscriptionsManager::FilterDeviceValue(SubscriptionInfo& subscription, JsonObject json_device,
+                                             char const* attribute_key) -> bool {
+  bool publish{true};
+
+  bool const is_boolean{json_device[attribute_key].is<bool>()};
+  one_wire::OneWireAddress address{};
+  PublishedValue* const published_value{
+      ((is_boolean || json_device[attribute_key].is<float>()) &&
+       one_wire::OneWireAddress::FromOwfsFormat(json_device[json::kDeviceId].as<char const*>(), address))
+          ? FindDeviceEntry(subscription.published_values, address)
+          : nullptr};
+  if (published_value != nullptr) {
+    float const value{is_boolean ? (json_device[attribute_key].as<bool>() ? 1.0F : 0.0F)
+                                 : json_device[attribute_key].as<float>()};
+    time::TimeStampMs const now{time::TimeUtil::TimeSinceStartup()};
+
+    if (published_value->address != 0) {
+      SubscriptionFilter const& filter{subscription.options.filter};
+
+      float threshold{filter.deadband};
+      if (is_boolean) {
+        threshold = 0.0F;
+      } else if (filter.deadband_type == DeadbandType::Relative) {
+        threshold = std::fabs(published_value->value) * filter.deadband / 100.0F;
+      }
+
+      float const delta{std::fabs(value - published_value->value)};
+      bool const changed{(delta > 0.0F) && (delta >= threshold)};
+      bool const silence_exceeded{(filter.max_silence > 0) &&
+                                  ((now - published_value->time) >= filter.max_silence)};
+      publish = changed || silence_exceeded;
+    }
+
+    if (publish) {
+      *published_value = PublishedValue{address, value, now};
+    }
+  }
+
+  return publish;
+}
+
+auto SubscriptionsManager::AggregateReadResult(SubscriptionInfo& subscription, DeviceAttributeType attribute,
+                                               JsonDocument const& command_result) -> void {
+  char const* const attribute_key{GetAttributeKey(attribute)};
+
+  if (command_result[json::kDevice].is<JsonObjectConst>()) {
+    AggregateDeviceValue(subscription, command_result[json::kDevice].as<JsonObjectConst>(), attribute_key);
+  } else if (command_result[json::kDevices].is<JsonArrayConst>()) {
+    for (JsonVariantConst json_device : command_result[json::kDevices].as<JsonArrayConst>()) {
+      AggregateDeviceValue(subscription, json_device.as<JsonObjectConst>(), attribute_key);
+    }
+  }
+}
+
+/*!
+ * Booleans are aggregated as 0 / 1, so the mean of 'present' is the share of samples the device was present. A device
+ * takes the first unused accumulator of the window. If all are in use by other devices, the value is dropped.
+ */
+auto SubscriptionsManager::AggregateDeviceValue(SubscriptionInfo& subscription, JsonObjectConst json_device,
+                                                char const* attribute_key) -> void {
+  float value{0.0F};
+  one_wire::OneWireAddress address{};
+  if (one_wire::OneWireAddress::FromOwfsFormat(json_device[json::kDeviceId].as<char const*>(), address) &&
+      GetDeviceValue(json_device, attribute_key, value)) {
+    bool const has_channel{json_device[json::kChannel].is<std::uint8_t>()};
+    std::uint8_t const channel{has_channel ? json_device[json::kChannel].as<std::uint8_t>()
+                                           : static_cast<std::uint8_t>(0)};
+
+    AggregatedValues::iterator const aggregated_value{
+        std::find_if(subscription.aggregated_values.begin(), subscription.aggregated_values.end(),
+                     [&address](AggregatedValue const& aggregate) {
+                       return (aggregate.count == 0) || (aggregate.address == address);
+                     })};
+    if (aggregated_value == subscription.aggregated_values.end()) {
+      ++subscription.aggregation_dropped;
+    } else if (aggregated_value->count == 0) {
+      *aggregated_value = AggregatedValue{address, value, value, value, value, 1, channel, has_channel};
+    } else {
+      AggregatedValue& aggregate{*aggregated_value};
+      aggregate.min = std::min(aggregate.min, value);
+      aggregate.max = std::max(aggregate.max, value);
+      aggregate.sum += value;
+      aggregate.last = value;
+      ++aggregate.count;
+    }
+  }
+}
+
+/*!
+ * Publishes one result per window containing the selected aggregates of each sampled device. Nothing is published if
+ * no value was sampled during the window.
+ */
+auto SubscriptionsManager::PublishAggregates(SubscriptionInfo& subscription) -> void {
+  Command const& cmd{subscription.command};
+  CommandResultCallback const& result_callback{subscription.result_callback};
+
+  bool const has_values{(not subscription.aggregated_values.empty()) &&
+                         (subscription.aggregated_values.front().count > 0)};
+  if (has_values && (result_callback.func != nullptr) && (result_callback.ctx != nullptr)) {
+    std::uint8_t const aggregates{subscription.options.aggregation.aggregates};
+    char const* const attribute_key{GetAttributeKey(cmd.params.device_attribute)};
+
+    JsonDocument json{&util::json_allocator_g};
+    json[json::kRootAction] = json::kActionRead;
+    json[json::kAggregateWindow] = subscription.options.aggregation.publish_interval;
+    JsonArray json_devices{};
+    if (cmd.params.has_family_code) {
+      json[json::kFamilyCode] = cmd.params.address.family_code;
+    }
+    if (not cmd.params.has_device_id) {
+      json_devices = json[json::kDevices].to<JsonArray>();
+    }
+
+    char device_id[one_wire::OneWireAddress::kFormattedLength + 1];
+    for (AggregatedValue const& aggregate : subscription.aggregated_values) {
+      if (aggregate.count == 0) {
+        break;  // Accumulators are used in order
+      }
+
+      JsonObject json_device{cmd.params.has_device_id ? json[json::kDevice].to<JsonObject>()
+                                                      : json_devices.add<JsonObject>()};
+      if (aggregate.has_channel) {
+        json_device[json::kChannel] = aggregate.channel;
+      }
+      json_device[json::kDeviceId] = aggregate.address.Format(device_id);
+
+      JsonObject json_aggregates{json_device[attribute_key].to<JsonObject>()};
+      if ((aggregates & ToUnderlying(Aggregate::Min)) != 0) {
+        json_aggregates[json::kAggregateMin] = aggregate.min;
+      }
+      if ((aggregates & ToUnderlying(Aggregate::Max)) != 0) {
+        json_aggregates[json::kAggregateMax] = aggregate.max;
+      }
+      if ((aggregates & ToUnderlying(Aggregate::Mean)) != 0) {
+        json_aggregates[json::kAggregateMean] = aggregate.sum / static_cast<float>(aggregate.count);
+      }
+      if ((aggregates & ToUnderlying(Aggregate::Last)) != 0) {
+        json_aggregates[json::kAggregateLast] = aggregate.last;
+      }
+      if ((aggregates & ToUnderlying(Aggregate::Count)) != 0) {
+        json_aggregates[json::kAggregateCount] = aggregate.count;
+      }
+    }
+
+    result_callback.func(result_callback.ctx, cmd, json);
+  }
+
+  if (subscription.aggregation_dropped > 0) {
+    logger_.Warn(F("[SubscriptionsManager] Dropped %u values of devices exceeding %u aggregated devices"),
+                 subscription.aggregation_dropped, static_cast<std::uint8_t>(kMaxTrackedDevices));
+  }
+
+  // Reuse the accumulators in the next window
+  for (AggregatedValue& aggregate : subscription.aggregated_values) {
+    aggregate.count = 0;
+  }
+  subscription.aggregation_dropped = 0;
+}
+
+/*!
+ * Halves the interval while the average max. change per read exceeds the adaptive delta and doubles it while the
+ * values are flat (average change below a quarter of the delta). The interval only takes power-of-two multiples and
+ * fractions of the initial interval within [min_interval, max_interval], e.g. 10 s, 5 s, 2.5 s for min_interval 2 s.
+ * It therefore stays aligned with other subscriptions of the same initial interval. The adapted interval is persisted
+ * with a delay, so oscillating values do not wear the flash.
+ */
+auto SubscriptionsManager::AdaptInterval(SubscriptionInfo& subscription, JsonDocument const& command_result) -> void {
+  SubscriptionAdaptation const& adaptation{subscription.options.adaptation};
+  char const* const attribute_key{GetAttributeKey(subscription.command.params.device_attribute)};
+
+  float max_delta{0.0F};
+  if (command_result[json::kDevice].is<JsonObjectConst>()) {
+    max_delta = SampleDeviceDelta(subscription, command_result[json::kDevice].as<JsonObjectConst>(), attribute_key);
+  } else if (command_result[json::kDevices].is<JsonArrayConst>()) {
+    for (JsonVariantConst json_device : command_result[json::kDevices].as<JsonArrayConst>()) {
+      float const delta{SampleDeviceDelta(subscription, json_device.as<JsonObjectConst>(), attribute_key)};
+      max_delta = std::max(max_delta, delta);
+    }
+  }
+  subscription.delta_average = (subscription.delta_average + max_delta) / 2.0F;
+
+  std::uint32_t const interval{subscription.interval.value};
+  std::uint32_t adapted_interval{interval};
+  if (subscription.delta_average > adaptation.delta) {
+    if (((interval % 2) == 0) && ((interval / 2) >= adaptation.min_interval)) {
+      adapted_interval = interval / 2;
+    }
+  } else if (subscription.delta_average <= (adaptation.delta / 4.0F)) {
+    if ((static_cast<std::uint64_t>(interval) * 2) <= adaptation.max_interval) {
+      adapted_interval = interval * 2;
+    }
+  }
+
+  if (adapted_interval != interval) {
+    logger_.Debug(F("[SubscriptionsManager] Adapt interval: %u ms -> %u ms (average change: %f)"), interval,
+                  adapted_interval, subscription.delta_average);
+    subscription.interval.value = adapted_interval;
+    subscription.timer = Timer::Aligned(adapted_interval);
+    AdaptDeadline(subscription.command, interval, adapted_interval);
+    Reschedule(subscription);
+
+    if (not store_pending_) {
+      store_pending_ = true;
+      store_timer_ = Timer{kStoreDelay};
+    }
+  }
+}
+
+/*!
+ * A deadline equal to the interval, i.e. the default deadline of the cyclic reads (see
+ * ConvertSubscribeToReadCommand()), follows the adapted interval. So a read neither outlives the next tick nor expires
+ * before it. An explicit deadline of the subscriber is kept.
+ */
+auto SubscriptionsManager::AdaptDeadline(Command& command, std::uint32_t interval, std::uint32_t adapted_interval)
+    -> void {
+  if ((command.deadline.GetDelay() == interval) && (adapted_interval != interval)) {
+    command.deadline = Timer{adapted_interval};
+  }
+}
+
+/*!
+ * \return Absolute change of the device value since the previous read. 0 for the first read of a device and for
+ *         devices exceeding the tracked devices.
+ */
+auto SubscriptionsManager::SampleDeviceDelta(SubscriptionInfo& subscription, JsonObjectConst json_device,
+                                             char const* attribute_key) -> float {
+  float delta{0.0F};
+
+  float value{0.0F};
+  one_wire::OneWireAddress address{};
+  SampledValue* const sampled_value{
+      (GetDeviceValue(json_device, attribute_key, value) &&
+       one_wire::OneWireAddress::FromOwfsFormat(json_device[json::kDeviceId].as<char const*>(), address))
+          ? FindDeviceEntry(subscription.sampled_values, address)
+          : nullptr};
+  if (sampled_value != nullptr) {
+    if (sampled_value->address != 0) {
+      delta = std::fabs(value - sampled_value->value);
+      sampled_value->value = value;
+    } else {
+      *sampled_value = SampledValue{address, value};
+    }
+  }
+
+  return delta;
+}
+
+/*!
+ * Entries are taken in order and not released individually, so the first unused entry ends the search.
+ * \return Entry of the device or, for a new device, the first unused entry. nullptr if all entries are in use by other
+ *         devices.
+ */
+template <typename T>
+auto SubscriptionsManager::FindDeviceEntry(std::vector<T>& entries, one_wire::OneWireAddress const& address) -> T* {
+  T* result{nullptr};
+
+  for (T& entry : entries) {
+    if ((entry.address == address) || (entry.address == 0)) {
+      result = &entry;
+      break;
+    }
+  }
+
+  return result;
+}
+
+/*!
+ * Numeric value of the attribute. Booleans are returned as 0 / 1.
+ * \return False if the device has no value of the attribute
+ */
+auto SubscriptionsManager::GetDeviceValue(JsonObjectConst json_device, char const* attribute_key, float& value)
+    -> bool {
+  bool result{false};
+
+  if (json_device[attribute_key].is<bool>()) {
+    value = json_device[attribute_key].as<bool>() ? 1.0F : 0.0F;
+    result = true;
+  } else if (json_device[attribute_key].is<float>()) {
+    value = json_device[attribute_key].as<float>();
+    result = true;
+  }
+
+  return result;
+}
+
+auto SubscriptionsManager::GetAttributeKey(DeviceAttributeType attribute) -> char const* {
+  char const* result{json::kAttributePresence};
+
+  switch (attribute) {
+    case DeviceAttributeType::Temperature:
+      result = json::kActionReadAttributeTemperature;
+      break;
+    case DeviceAttributeType::VAD:
+      result = json::kActionReadAttributeVAD;
+      break;
+    case DeviceAttributeType::VDD:
+      result = json::kActionReadAttributeVDD;
+      break;
+    case DeviceAttributeType::Presence:
+    default:
+      result = json::kAttributePresence;
+      break;
+  }
+
+  return result;
+}
+
+auto SubscriptionsManager::ConvertSubscribeToReadCommand(Command& cmd) -> void {
+  cmd.action = Action::Read;
+  cmd.priority = CommandPriority::Periodic;
+
+  // A cyclic read is superseded by the read of the next interval. Use the interval as default deadline.
+  if (cmd.deadline.GetDelay() == 0) {
+    cmd.deadline = Timer{cmd.params.interval.value};
+  }
+
+  // Unset the 'interval' parameter
+  cmd.params.has_interval = false;
+  cmd.params.interval = TimeIntervalType{0};
 }
 
-auto SubscriptionsManager::SubscriptionKeyFamily::operator==(SubscriptionKeyFamily const& other) const -> bool {
-  return std::tie(family_code, attribute) == std::tie(other.family_code, other.attribute);
+auto SubscriptionsManager::SubscriptionKey::operator==(SubscriptionKey const& other) const -> bool {
+  return std::tie(scope, address, attribute) == std::tie(other.scope, other.address, other.attribute);
 }
 
-auto SubscriptionsManager::SubscriptionKeyFamily::operator<(SubscriptionKeyFamily const& other) const -> bool {
-  return std::tie(family_code, attribute) < std::tie(other.family_code, other.attribute);
+auto SubscriptionsManager::SubscriptionKey::operator<(SubscriptionKey const& other) const -> bool {
+  return std::tie(scope, address, attribute) < std::tie(other.scope, other.address, other.attribute);
 }
 
 }  // namespace cmd
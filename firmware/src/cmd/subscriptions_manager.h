@@ -3,26 +3,52 @@
 
 // ---- Includes ----
 
-#include <map>
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
 
 #include "cmd/command.h"
+#include "config/subscriptions_config.h"
 #include "logging/logger.h"
 #include "one_wire/one_wire_address.h"
+#include "one_wire/one_wire_subsystem.h"
+#include "time/time_util.h"
 
 namespace owif {
 namespace cmd {
 
 class CommandHandler;  // forward declaration due to circular dependency
 
+/*!
+ * \brief Statistics of the subscription table.
+ */
+struct SubscriptionsStatistics {
+  std::uint16_t size;      // Number of active subscriptions
+  std::uint16_t capacity;  // Max. number of subscriptions
+  std::uint32_t memory;    // Allocated memory of the subscription table [bytes]
+};
+
+/*!
+ * \brief Manages the subscriptions in a flat table of slots. A sorted index maps the subscription keys to the slots
+ *        and a min-heap ordered by the next due time schedules the slots, so a Loop() only touches due subscriptions.
+ *        Presence subscriptions are served by a single full bus search per tick instead of a search per subscription.
+ */
 class SubscriptionsManager final {
  public:
-  SubscriptionsManager(CommandHandler* command_handler);
+  SubscriptionsManager(CommandHandler* command_handler, one_wire::OneWireSystem* one_wire_system,
+                       std::uint16_t max_subscriptions = kDefaultMaxSubscriptions);
 
   SubscriptionsManager(SubscriptionsManager const&) = default;
   auto operator=(SubscriptionsManager const&) -> SubscriptionsManager& = default;
   SubscriptionsManager(SubscriptionsManager&&) = default;
   auto operator=(SubscriptionsManager&&) -> SubscriptionsManager& = default;
 
+  // Default max. number of subscriptions. Equals the number of persisted subscriptions.
+  static constexpr std::uint16_t kDefaultMaxSubscriptions{config::SubscriptionsConfig::kMaxSubscriptions};
+
   // ---- Public APIs --------------------------------------------------------------------------------------------------
   auto Loop() -> void;
 
@@ -30,41 +56,201 @@ class SubscriptionsManager final {
 
   auto ProcessActionUnsubscribe(Command& cmd) -> void;
 
+  auto Restore(config::SubscriptionsConfig const& subscriptions_config, CommandResultCallback const& result_callback,
+               ErrorResultCallback const& error_result_callback) -> void;
+
+  auto GetStatistics() const -> SubscriptionsStatistics;
+
  private:
-  auto ConvertSubscribeToReadCommand(Command& cmd) -> void;
+  struct SubscriptionInfo;
 
-  logging::Logger logger_{logging::logger_g};
+  // Index of a subscription in the table
+  using SubscriptionSlot = std::uint16_t;
+
+  enum class AddressScope : std::uint8_t {
+    Device = 0x00,
+    Family = 0x01,
+    AllDevices = 0x02,  // Wildcard device_id '*'
+  };
 
-  struct SubscriptionKeyDevice {
+  struct SubscriptionKey {
    public:
-    one_wire::OneWireAddress address;
+    AddressScope scope;
+    std::uint64_t address;  // Full 1-wire address or family code. Unused for all devices.
     DeviceAttributeType attribute;
 
-    auto operator==(SubscriptionKeyDevice const& other) const -> bool;
-    auto operator<(SubscriptionKeyDevice const& other) const -> bool;
+    auto operator==(SubscriptionKey const& other) const -> bool;
+    auto operator<(SubscriptionKey const& other) const -> bool;
   };
 
-  struct SubscriptionKeyFamily {
-   public:
-    one_wire::OneWireAddress::FamilyCode family_code;
-    DeviceAttributeType attribute;
+  struct IndexEntry {
+    SubscriptionKey key;
+    SubscriptionSlot slot;
+  };
 
-    auto operator==(SubscriptionKeyFamily const& other) const -> bool;
-    auto operator<(SubscriptionKeyFamily const& other) const -> bool;
+  struct ScheduleEntry {
+    time::TimeStampMs due_time;  // Next start of a read or expiry of the publish timer of the subscription
+    SubscriptionSlot slot;
+    std::uint16_t generation;  // Stale if it differs from the generation of the slot
   };
 
+  auto ConvertSubscribeToReadCommand(Command& cmd) -> void;
+  auto CreateSubscriptionInfo(Command const& cmd, SubscriptionOptions const& options, TimeIntervalType interval)
+      -> SubscriptionInfo;
+  auto FindSubscription(Command const& cmd) -> SubscriptionInfo*;
+  auto HasReplyTopicConflict(Command const& cmd) -> bool;
+  auto IsReplyTopicPersistable(Command const& cmd) const -> bool;
+  auto ProcessSubscription(SubscriptionInfo& subscription) -> void;
+  auto TriggerRead(SubscriptionInfo& subscription, Timer const& result_timer = Timer{}) -> void;
+  auto GetConversionTime(CommandParams const& params) -> std::uint32_t;
+  static auto GetFamilyConversionTime(one_wire::OneWireAddress::FamilyCode family_code, DeviceAttributeType attribute)
+      -> std::uint32_t;
+  static auto GetLeadTime(SubscriptionInfo const& subscription) -> std::uint32_t;
+
+  auto EnqueuePresenceSearch() -> void;
+  static auto HandlePresenceSearchResult(void* ctx, Command const& cmd, JsonDocument& command_result) -> void;
+  static auto HandlePresenceSearchError(void* ctx, Command const& cmd, ErrorCode error_code, char const* error_message,
+                                        char const* request_json) -> void;
+  auto CompletePresenceSearch(bool search_result, ErrorCode error_code, char const* error_message) -> void;
+  auto PublishPresence(SubscriptionInfo& subscription) -> void;
+  auto PublishPresenceChange(SubscriptionInfo& subscription, one_wire::OneWireSystem::PresenceChange const& change)
+      -> void;
+  static auto IsPresence(CommandParams const& params) -> bool;
+  static auto CoversDevice(CommandParams const& params, one_wire::OneWireAddress const& address) -> bool;
+
+  auto AddSubscription(SubscriptionInfo const& subscription, bool& is_new) -> SubscriptionInfo*;
+  auto RemoveSubscription(SubscriptionKey const& key) -> bool;
+  auto FindIndexEntry(SubscriptionKey const& key) -> std::vector<IndexEntry>::iterator;
+  auto Schedule(SubscriptionSlot slot) -> void;
+  auto Unschedule(SubscriptionSlot slot) -> void;
+  auto Reschedule(SubscriptionInfo& subscription) -> void;
+  auto CompactSchedule() -> void;
+  static auto GetSubscriptionKey(Command const& cmd) -> SubscriptionKey;
+  static auto IsDueLater(ScheduleEntry const& lhs, ScheduleEntry const& rhs) -> bool;
+  static auto IsWildcard(CommandParams const& params) -> bool;
+
+  auto ExecuteReadPlan(SubscriptionInfo& subscription) -> void;
+  auto CreateReadPlan(CommandParams const& params) -> std::vector<CommandParams>;
+  static auto GetMeasuredAttributes(one_wire::OneWireAddress::FamilyCode family_code)
+      -> std::vector<DeviceAttributeType>;
+  static auto HandleReadError(void* ctx, Command const& cmd, ErrorCode error_code, char const* error_message,
+                              char const* request_json) -> void;
+  auto CollectReadResult(SubscriptionInfo& subscription, JsonDocument const& command_result) -> void;
+  static auto CollectDeviceValues(SubscriptionInfo& subscription, JsonObjectConst json_device) -> void;
+  auto CompletePlannedRead(SubscriptionInfo& subscription) -> void;
+  auto PublishCollectedResult(SubscriptionInfo& subscription) -> void;
+
+  auto Store() -> void;
+  static auto ToPersistedSubscription(SubscriptionInfo const& subscription,
+                                      config::SubscriptionsConfig& subscriptions_config)
+      -> config::SubscriptionsConfig::Subscription;
+
+  static auto HandleReadResult(void* ctx, Command const& cmd, JsonDocument& command_result) -> void;
+  auto PublishReadResult(SubscriptionInfo& subscription, JsonDocument& command_result) -> void;
+  auto FilterReadResult(SubscriptionInfo& subscription, DeviceAttributeType attribute, JsonDocument& command_result)
+      -> bool;
+  auto FilterDeviceValue(SubscriptionInfo& subscription, JsonObject json_device, char const* attribute_key) -> bool;
+  static auto AggregateReadResult(SubscriptionInfo& subscription, DeviceAttributeType attribute,
+                                  JsonDocument const& command_result) -> void;
+  static auto AggregateDeviceValue(SubscriptionInfo& subscription, JsonObjectConst json_device,
+                                   char const* attribute_key) -> void;
+  auto PublishAggregates(SubscriptionInfo& subscription) -> void;
+  auto AdaptInterval(SubscriptionInfo& subscription, JsonDocument const& command_result) -> void;
+  static auto AdaptDeadline(Command& command, std::uint32_t interval, std::uint32_t adapted_interval) -> void;
+  static auto SampleDeviceDelta(SubscriptionInfo& subscription, JsonObjectConst json_device, char const* attribute_key)
+      -> float;
+  static auto GetDeviceValue(JsonObjectConst json_device, char const* attribute_key, float& value) -> bool;
+  static auto GetAttributeKey(DeviceAttributeType attribute) -> char const*;
+
+  logging::Logger logger_{logging::logger_g};
+
+  // Max. number of devices tracked per family subscription by the filter, the aggregation and the adaptation. Values
+  // of further devices are published unfiltered, dropped from the aggregation respectively not sampled.
+  static constexpr std::uint8_t kMaxTrackedDevices{16};
+  // Delay [ms] of persisting adapted intervals. Limits the writes to the flash.
+  static constexpr std::uint32_t kStoreDelay{60000};
+  // Measured attributes of the devices, merged by the reads of a wildcard read plan (see GetMeasuredAttributes())
+  static constexpr std::size_t kCollectedAttributeCount{3};
+  static constexpr std::array<DeviceAttributeType, kCollectedAttributeCount> kCollectedAttributes{
+      {DeviceAttributeType::Temperature, DeviceAttributeType::VAD, DeviceAttributeType::VDD}};
+
+  // The per device values of a subscription are kept in fixed-size tables keyed by the 1-wire address. A table is
+  // sized once when the subscription is created: a single entry for a device, kMaxTrackedDevices for a family.
+
+  struct PublishedValue {
+    one_wire::OneWireAddress address;  // Device of the entry. Null address: Entry unused.
+    float value;                       // Last published value. Booleans are stored as 0 / 1.
+    time::TimeStampMs time;            // Time of the last publishing
+  };
+
+  struct AggregatedValue {
+    one_wire::OneWireAddress address;
+    float min;
+    float max;
+    float sum;
+    float last;
+    std::uint32_t count;  // 0: accumulator unused in the current window
+    std::uint8_t channel;
+    bool has_channel;
+  };
+
+  struct SampledValue {
+    one_wire::OneWireAddress address;  // Device of the entry. Null address: Entry unused.
+    float value;                       // Last sampled value
+  };
+
+  // Values of a device merged from the reads of a wildcard read plan. Sized to the available devices, grows only with
+  // the number of devices on the bus.
+  struct CollectedValue {
+    one_wire::OneWireAddress address;  // Device of the entry. Null address: Entry unused in the current tick.
+    std::array<float, kCollectedAttributeCount> values;
+    std::uint8_t attributes;  // Bit mask of the set values, bit n: kCollectedAttributes[n]
+    std::uint8_t channel;
+    bool has_channel;
+  };
+
+  using PublishedValues = std::vector<PublishedValue>;
+  using AggregatedValues = std::vector<AggregatedValue>;
+  using SampledValues = std::vector<SampledValue>;
+  using CollectedValues = std::vector<CollectedValue>;
+
+  template <typename T>
+  static auto FindDeviceEntry(std::vector<T>& entries, one_wire::OneWireAddress const& address) -> T*;
+
   struct SubscriptionInfo {
-    Timer timer;
-    Command command;
+    Timer timer;                            // Periodic timer aligned to multiples of the interval since startup
+    TimeIntervalType interval;              // Subscription (sample) interval [ms]
+    std::uint32_t conversion_time;          // Reads are triggered ahead of the timer by the conversion time [ms]
+    Command command;                        // Cyclic read command. Results are routed via filter or aggregation.
+    SubscriptionOptions options;            // Filter, aggregation and adaptive sampling of the results
+    CommandResultCallback result_callback;  // Result callback of the subscriber
+    PublishedValues published_values;       // Only maintained if the filter is enabled
+    Timer publish_timer;                    // End of the aggregation window. Only used if aggregation is enabled.
+    AggregatedValues aggregated_values;     // Only maintained if aggregation is enabled
+    std::uint16_t aggregation_dropped;      // Values of the current window dropped as all accumulators are in use
+    CollectedValues collected_values;       // Wildcard: Merged results of the read plan of the current tick
+    std::uint16_t pending_reads;            // Wildcard: Reads of the current tick without result yet
+    SampledValues sampled_values;           // Adaptive: Only maintained if adaptive sampling is enabled
+    float delta_average;                    // Adaptive: Moving average of the max. change per read
+    bool presence_pending;                  // Presence: Read requested, served by the next presence search
+    bool scheduled;                         // Slot has a valid entry in the schedule
   };
 
   CommandHandler* command_handler_;
+  one_wire::OneWireSystem* one_wire_system_;
+  std::uint16_t max_subscriptions_;
 
-  using SubscriptionsMapDevice = std::map<SubscriptionKeyDevice, SubscriptionInfo>;
-  SubscriptionsMapDevice subscriptions_device_{};
-
-  using SubscriptionsMapFamily = std::map<SubscriptionKeyFamily, SubscriptionInfo>;
-  SubscriptionsMapFamily subscriptions_family_{};
+  std::vector<SubscriptionInfo> subscriptions_{};  // Table of subscriptions. Grows on demand up to the max.
+  std::vector<SubscriptionSlot> free_slots_{};     // Stack of unused slots of the table
+  std::vector<IndexEntry> index_{};                // Sorted by key
+  std::vector<ScheduleEntry> schedule_{};          // Min-heap by due time. One valid entry per active slot.
+  std::vector<std::uint16_t> generations_{};       // Per slot: Generation of its valid schedule entry
+  std::size_t stale_entries_{0};                   // Schedule entries of older generations, removed lazily
+  bool presence_search_pending_{false};            // Set if a presence subscription is due in the current Loop()
+  bool presence_search_enqueued_{false};           // Presence search waits in the command queue
+  std::uint32_t presence_search_deadline_{0};      // Shortest deadline of the due presence subscriptions [ms]
+  bool store_pending_{false};                      // Adapted intervals are not yet persisted
+  Timer store_timer_{};                            // Delay until the adapted intervals are persisted
 };
 
 }  // namespace cmd
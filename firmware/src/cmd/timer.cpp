@@ -6,6 +6,8 @@
 
 #include <cstdint>
 
+#include "time/time_util.h"
+
 namespace owif {
 namespace cmd {
 
@@ -13,24 +15,74 @@ Timer::Timer() : Timer(0) {}
 
 Timer::Timer(std::uint32_t delay) : delay_{delay} { Reset(); }
 
+/*!
+ * Create a periodic timer expiring at the next multiple of the period since startup. Timers with equal periods (or
+ * multiples of each other) therefore expire at the same time.
+ */
+auto Timer::Aligned(std::uint32_t period) -> Timer {
+  Timer timer{period};
+  if (period > 0) {
+    time::TimeStampMs const now{time::TimeUtil::TimeSinceStartup()};
+    timer.expiry_time_ = now - (now % period) + period;
+  }
+  return timer;
+}
+
 // ---- Public APIs --------------------------------------------------------------------------------------------------
 
 auto Timer::Reset() -> void { Reset(delay_); }
 
 auto Timer::Reset(std::uint32_t delay) -> void {
   delay_ = delay;
+  postponement_ = 0;
   if (delay_ > 0) {
-    minimum_abs_execution_time_ = millis() + delay_;
+    expiry_time_ = time::TimeUtil::TimeSinceStartup() + delay_;
   } else {
-    minimum_abs_execution_time_ = 0;
+    expiry_time_ = 0;
+  }
+}
+
+/*!
+ * Re-arm a periodic timer by exactly one delay relative to its last expiry time instead of the current time, so the
+ * period does not drift if the timer is checked late. Periods missed completely are skipped.
+ */
+auto Timer::Advance() -> void {
+  if (delay_ > 0) {
+    time::TimeStampMs const now{time::TimeUtil::TimeSinceStartup()};
+    expiry_time_ += delay_ - postponement_;
+    postponement_ = 0;
+    if (expiry_time_ <= now) {
+      expiry_time_ += ((now - expiry_time_) / delay_ + 1) * delay_;
+    }
+  }
+}
+
+/*!
+ * Postpone the next expiry of a periodic timer by an offset below the delay. The following expiries return to the
+ * original period grid.
+ */
+auto Timer::Postpone(std::uint32_t offset) -> void {
+  if ((delay_ > 0) && (expiry_time_ > 0)) {
+    offset %= delay_;
+    expiry_time_ = expiry_time_ - postponement_ + offset;
+    postponement_ = offset;
   }
 }
 
 auto Timer::IsExpired() const -> bool {
-  return (minimum_abs_execution_time_ == 0) || (minimum_abs_execution_time_ <= millis());
+  return (expiry_time_ == 0) || (expiry_time_ <= time::TimeUtil::TimeSinceStartup());
+}
+
+/*!
+ * Check if the timer expires within the time span from now, e.g. to start a preparation ahead of the expiry.
+ */
+auto Timer::ExpiresWithin(std::uint32_t time_span) const -> bool {
+  return (expiry_time_ == 0) || (expiry_time_ <= time::TimeUtil::TimeSinceStartup() + time_span);
 }
 
 auto Timer::GetDelay() const -> std::uint32_t { return delay_; }
 
+auto Timer::GetExpiryTime() const -> time::TimeStampMs { return expiry_time_; }
+
 }  // namespace cmd
 }  // namespace owif
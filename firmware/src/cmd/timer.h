@@ -7,9 +7,14 @@
 
 #include <cstdint>
 
+#include "time/time_util.h"
+
 namespace owif {
 namespace cmd {
 
+/*!
+ * \brief Timer based on the 64-bit monotonic time since startup. Does not overflow during the lifetime of the device.
+ */
 class Timer {
  public:
   Timer();
@@ -20,17 +25,25 @@ class Timer {
   Timer(Timer&&) = default;
   auto operator=(Timer&&) -> Timer& = default;
 
+  static auto Aligned(std::uint32_t period) -> Timer;
+
   // ---- Public APIs --------------------------------------------------------------------------------------------------
 
   auto Reset() -> void;
   auto Reset(std::uint32_t delay) -> void;
+  auto Advance() -> void;
+  auto Postpone(std::uint32_t offset) -> void;
   auto IsExpired() const -> bool;
+  auto ExpiresWithin(std::uint32_t time_span) const -> bool;
 
   auto GetDelay() const -> std::uint32_t;
+  auto GetExpiryTime() const -> time::TimeStampMs;
 
  private:
+  // The 64-bit expiry time comes first, so the timer packs without padding. Commands hold three timers.
+  time::TimeStampMs expiry_time_{0};  // 0: expired immediately
   std::uint32_t delay_{0};
-  std::uint32_t minimum_abs_execution_time_{0};
+  std::uint32_t postponement_{0};     // Offset of the next expiry from the period grid. Reverted by Advance().
 };
 
 }  // namespace cmd
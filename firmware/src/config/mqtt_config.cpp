@@ -28,5 +28,31 @@ auto MqttConfig::SetReconnectTimeout(std::uint32_t reconnect_timeout) -> void {
   reconnect_timeout_ = reconnect_timeout;
 }
 
+auto MqttConfig::GetDeviceTopics() const -> bool { return device_topics_; }
+auto MqttConfig::SetDeviceTopics(bool enable) -> void { device_topics_ = enable; }
+
+auto MqttConfig::GetBatchWindow() const -> std::uint32_t { return batch_window_; }
+auto MqttConfig::SetBatchWindow(std::uint32_t batch_window) -> void { batch_window_ = batch_window; }
+
+auto MqttConfig::GetBatchSize() const -> std::uint16_t { return batch_size_; }
+auto MqttConfig::SetBatchSize(std::uint16_t batch_size) -> void { batch_size_ = batch_size; }
+
+auto MqttConfig::GetPublishQos() const -> std::uint8_t { return publish_qos_; }
+auto MqttConfig::SetPublishQos(std::uint8_t publish_qos) -> void {
+  publish_qos_ = publish_qos > kMaxPublishQos ? kMaxPublishQos : publish_qos;
+}
+
+auto MqttConfig::GetMaxInFlight() const -> std::uint16_t { return max_in_flight_; }
+auto MqttConfig::SetMaxInFlight(std::uint16_t max_in_flight) -> void { max_in_flight_ = max_in_flight; }
+
+auto MqttConfig::GetOfflineBuffer() const -> std::uint16_t { return offline_buffer_; }
+auto MqttConfig::SetOfflineBuffer(std::uint16_t offline_buffer) -> void { offline_buffer_ = offline_buffer; }
+
+auto MqttConfig::GetOfflineSpill() const -> bool { return offline_spill_; }
+auto MqttConfig::SetOfflineSpill(bool enable) -> void { offline_spill_ = enable; }
+
+auto MqttConfig::GetReplayRate() const -> std::uint16_t { return replay_rate_; }
+auto MqttConfig::SetReplayRate(std::uint16_t replay_rate) -> void { replay_rate_ = replay_rate; }
+
 }  // namespace config
 }  // namespace owif
@@ -15,6 +15,15 @@ class MqttConfig {
   static constexpr std::uint32_t kDefaultReconnectTimeout{30 * 1000};  // ms
   static constexpr char const* kDefaultTopic{"1wIf"};
   static constexpr char const* kDefaultClientId{"1wIf"};
+  static constexpr bool kDefaultDeviceTopics{false};
+  static constexpr std::uint32_t kDefaultBatchWindow{0};  // ms. 0: publish every response immediately
+  static constexpr std::uint16_t kDefaultBatchSize{16};
+  static constexpr std::uint8_t kDefaultPublishQos{0};
+  static constexpr std::uint8_t kMaxPublishQos{1};  // QoS2 is not supported for publishing
+  static constexpr std::uint16_t kDefaultMaxInFlight{8};
+  static constexpr std::uint16_t kDefaultOfflineBuffer{64};  // 0: results are discarded while disconnected
+  static constexpr bool kDefaultOfflineSpill{false};
+  static constexpr std::uint16_t kDefaultReplayRate{10};  // messages / s
 
   MqttConfig() = default;
   MqttConfig(MqttConfig const&) = default;
@@ -46,6 +55,30 @@ class MqttConfig {
   auto GetReconnectTimeout() const -> std::uint32_t;
   auto SetReconnectTimeout(std::uint32_t reconnect_timeout) -> void;
 
+  auto GetDeviceTopics() const -> bool;
+  auto SetDeviceTopics(bool enable) -> void;
+
+  auto GetBatchWindow() const -> std::uint32_t;
+  auto SetBatchWindow(std::uint32_t batch_window) -> void;
+
+  auto GetBatchSize() const -> std::uint16_t;
+  auto SetBatchSize(std::uint16_t batch_size) -> void;
+
+  auto GetPublishQos() const -> std::uint8_t;
+  auto SetPublishQos(std::uint8_t publish_qos) -> void;
+
+  auto GetMaxInFlight() const -> std::uint16_t;
+  auto SetMaxInFlight(std::uint16_t max_in_flight) -> void;
+
+  auto GetOfflineBuffer() const -> std::uint16_t;
+  auto SetOfflineBuffer(std::uint16_t offline_buffer) -> void;
+
+  auto GetOfflineSpill() const -> bool;
+  auto SetOfflineSpill(bool enable) -> void;
+
+  auto GetReplayRate() const -> std::uint16_t;
+  auto SetReplayRate(std::uint16_t replay_rate) -> void;
+
  private:
   String server_addr_{kDefaultServerAddr};
   std::uint16_t server_port_{kDefaultServerPort};
@@ -54,6 +87,14 @@ class MqttConfig {
   std::uint32_t reconnect_timeout_{kDefaultReconnectTimeout};  // ms
   String topic_{kDefaultTopic};
   String client_id_{kDefaultClientId};
+  bool device_topics_{kDefaultDeviceTopics};             // Publish read values also on retained per-device topics
+  std::uint32_t batch_window_{kDefaultBatchWindow};      // ms. Max. delay of a response collected in a batch
+  std::uint16_t batch_size_{kDefaultBatchSize};          // Max. number of responses per batch
+  std::uint8_t publish_qos_{kDefaultPublishQos};         // Min. QoS of all publishings (0 or 1)
+  std::uint16_t max_in_flight_{kDefaultMaxInFlight};     // Max. number of unacknowledged QoS1 publishings
+  std::uint16_t offline_buffer_{kDefaultOfflineBuffer};  // Max. number of messages kept in RAM while disconnected
+  bool offline_spill_{kDefaultOfflineSpill};             // Spill messages exceeding the RAM buffer to LittleFS
+  std::uint16_t replay_rate_{kDefaultReplayRate};        // Max. number of offline messages replayed per second
 };
 
 }  // namespace config
@@ -8,6 +8,7 @@
 #include "config/mqtt_config.h"
 #include "config/onewire_config.h"
 #include "config/ota_config.h"
+#include "config/subscriptions_config.h"
 #include "config/webserver_config.h"
 
 namespace owif {
@@ -22,6 +23,7 @@ auto Persistency::PrettyPrint(logging::Logger& logger) -> void {
   OtaConfig const ota_config{LoadOtaConfig()};
   MqttConfig const mqtt_config{LoadMqttConfig()};
   NtpConfig const ntp_config{LoadNtpConfig()};
+  SubscriptionsConfig const subscriptions_config{LoadSubscriptionsConfig()};
 
   logger.Info(F("[Persistency] +- Configuration ---------------------------------"));
   logger.Info(F("[Persistency] | Logging:"));
@@ -44,9 +46,18 @@ auto Persistency::PrettyPrint(logging::Logger& logger) -> void {
   logger.Info(F("[Persistency] |   User:      %s"), mqtt_config.GetUser().c_str());
   logger.Info(F("[Persistency] |   Reconnect: %u ms"), mqtt_config.GetReconnectTimeout());
   logger.Info(F("[Persistency] |   Topic:     %s"), mqtt_config.GetTopic().c_str());
+  logger.Info(F("[Persistency] |   Dev-Topic: %s"), FormatOnOff(mqtt_config.GetDeviceTopics()));
+  logger.Info(F("[Persistency] |   Batching:  %u ms / %u responses"), mqtt_config.GetBatchWindow(),
+              mqtt_config.GetBatchSize());
+  logger.Info(F("[Persistency] |   QoS:       %u (max. in-flight: %u)"), mqtt_config.GetPublishQos(),
+              mqtt_config.GetMaxInFlight());
+  logger.Info(F("[Persistency] |   Offline:   %u messages, spill: %s, replay: %u/s"), mqtt_config.GetOfflineBuffer(),
+              FormatOnOff(mqtt_config.GetOfflineSpill()), mqtt_config.GetReplayRate());
   logger.Info(F("[Persistency] | NTP:"));
   logger.Info(F("[Persistency] |   Server:    %s"), ntp_config.GetServerAddr().c_str());
   logger.Info(F("[Persistency] |   Timezone:  %s"), ntp_config.GetTimezone().c_str());
+  logger.Info(F("[Persistency] | Subscriptions:"));
+  logger.Info(F("[Persistency] |   Stored:    %u"), subscriptions_config.GetSubscriptions().size());
   logger.Info(F("[Persistency] +-------------------------------------------------"));
 }
 
@@ -194,6 +205,14 @@ auto Persistency::LoadMqttConfig() -> MqttConfig {
   config.SetTopic(preferences_.getString(kMqttKeyTopic, MqttConfig::kDefaultTopic));
   config.SetClientId(preferences_.getString(kMqttKeyClientId, MqttConfig::kDefaultClientId));
   config.SetReconnectTimeout(preferences_.getUInt(kMqttKeyReconnectTime, MqttConfig::kDefaultReconnectTimeout));
+  config.SetDeviceTopics(preferences_.getBool(kMqttKeyDeviceTopics, MqttConfig::kDefaultDeviceTopics));
+  config.SetBatchWindow(preferences_.getUInt(kMqttKeyBatchWindow, MqttConfig::kDefaultBatchWindow));
+  config.SetBatchSize(preferences_.getUShort(kMqttKeyBatchSize, MqttConfig::kDefaultBatchSize));
+  config.SetPublishQos(preferences_.getUChar(kMqttKeyPublishQos, MqttConfig::kDefaultPublishQos));
+  config.SetMaxInFlight(preferences_.getUShort(kMqttKeyMaxInFlight, MqttConfig::kDefaultMaxInFlight));
+  config.SetOfflineBuffer(preferences_.getUShort(kMqttKeyOfflineBuffer, MqttConfig::kDefaultOfflineBuffer));
+  config.SetOfflineSpill(preferences_.getBool(kMqttKeyOfflineSpill, MqttConfig::kDefaultOfflineSpill));
+  config.SetReplayRate(preferences_.getUShort(kMqttKeyReplayRate, MqttConfig::kDefaultReplayRate));
 
   preferences_.end();
 
@@ -210,6 +229,14 @@ auto Persistency::StoreMqttConfig(MqttConfig const& mqtt_config) -> void {
   preferences_.putString(kMqttKeyTopic, mqtt_config.GetTopic());
   preferences_.putString(kMqttKeyClientId, mqtt_config.GetClientId());
   preferences_.putUInt(kMqttKeyReconnectTime, mqtt_config.GetReconnectTimeout());
+  preferences_.putBool(kMqttKeyDeviceTopics, mqtt_config.GetDeviceTopics());
+  preferences_.putUInt(kMqttKeyBatchWindow, mqtt_config.GetBatchWindow());
+  preferences_.putUShort(kMqttKeyBatchSize, mqtt_config.GetBatchSize());
+  preferences_.putUChar(kMqttKeyPublishQos, mqtt_config.GetPublishQos());
+  preferences_.putUShort(kMqttKeyMaxInFlight, mqtt_config.GetMaxInFlight());
+  preferences_.putUShort(kMqttKeyOfflineBuffer, mqtt_config.GetOfflineBuffer());
+  preferences_.putBool(kMqttKeyOfflineSpill, mqtt_config.GetOfflineSpill());
+  preferences_.putUShort(kMqttKeyReplayRate, mqtt_config.GetReplayRate());
 
   preferences_.end();
 }
@@ -236,6 +263,67 @@ auto Persistency::StoreNtpConfig(NtpConfig const& ntp_config) -> void {
   preferences_.end();
 }
 
+auto Persistency::LoadSubscriptionsConfig() -> SubscriptionsConfig {
+  SubscriptionsConfig config{};
+
+  preferences_.begin(kSubscriptionsKey, false);
+
+  std::uint8_t const version{preferences_.getUChar(kSubscriptionsKeyVersion, 0)};
+  std::size_t const entries_size{preferences_.getBytesLength(kSubscriptionsKeyEntries)};
+  std::size_t const entries{entries_size / sizeof(SubscriptionsConfig::Subscription)};
+
+  if ((version == SubscriptionsConfig::kVersion) && (entries_size % sizeof(SubscriptionsConfig::Subscription) == 0) &&
+      (entries <= SubscriptionsConfig::kMaxSubscriptions)) {
+    std::vector<SubscriptionsConfig::Subscription> subscriptions(entries);
+    if (preferences_.getBytes(kSubscriptionsKeyEntries, subscriptions.data(), entries_size) == entries_size) {
+      for (SubscriptionsConfig::Subscription const& subscription : subscriptions) {
+        config.AddSubscription(subscription);
+      }
+    }
+
+    std::size_t const reply_topics_size{preferences_.getBytesLength(kSubscriptionsKeyReplyTopics)};
+    std::size_t const reply_topics{reply_topics_size / sizeof(SubscriptionsConfig::ReplyTopic)};
+    if ((reply_topics_size % sizeof(SubscriptionsConfig::ReplyTopic) == 0) &&
+        (reply_topics <= SubscriptionsConfig::kMaxReplyTopics)) {
+      std::vector<SubscriptionsConfig::ReplyTopic> topics(reply_topics);
+      if (preferences_.getBytes(kSubscriptionsKeyReplyTopics, topics.data(), reply_topics_size) == reply_topics_size) {
+        for (SubscriptionsConfig::ReplyTopic& topic : topics) {
+          topic.topic[SubscriptionsConfig::kMaxReplyTopicLength] = '\0';
+          config.AddReplyTopic(topic.topic);
+        }
+      }
+    }
+  }
+
+  preferences_.end();
+
+  return config;
+}
+
+auto Persistency::StoreSubscriptionsConfig(SubscriptionsConfig const& subscriptions_config) -> void {
+  std::vector<SubscriptionsConfig::Subscription> const& subscriptions{subscriptions_config.GetSubscriptions()};
+
+  preferences_.begin(kSubscriptionsKey, false);
+
+  preferences_.putUChar(kSubscriptionsKeyVersion, SubscriptionsConfig::kVersion);
+  if (subscriptions.empty()) {
+    preferences_.remove(kSubscriptionsKeyEntries);
+  } else {
+    preferences_.putBytes(kSubscriptionsKeyEntries, subscriptions.data(),
+                          subscriptions.size() * sizeof(SubscriptionsConfig::Subscription));
+  }
+
+  std::vector<SubscriptionsConfig::ReplyTopic> const& reply_topics{subscriptions_config.GetReplyTopics()};
+  if (reply_topics.empty()) {
+    preferences_.remove(kSubscriptionsKeyReplyTopics);
+  } else {
+    preferences_.putBytes(kSubscriptionsKeyReplyTopics, reply_topics.data(),
+                          reply_topics.size() * sizeof(SubscriptionsConfig::ReplyTopic));
+  }
+
+  preferences_.end();
+}
+
 // ---- Private APIS ---------------------------------------------------------------------------------------------------
 
 auto Persistency::FormatOnOff(bool enabled) -> char const* { return enabled ? "on " : "off"; }
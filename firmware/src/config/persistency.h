@@ -9,6 +9,7 @@
 #include "config/ntp_config.h"
 #include "config/onewire_config.h"
 #include "config/ota_config.h"
+#include "config/subscriptions_config.h"
 #include "config/webserver_config.h"
 #include "logging/logger.h"
 
@@ -50,6 +51,9 @@ class Persistency {
   auto LoadNtpConfig() -> NtpConfig;
   auto StoreNtpConfig(NtpConfig const& ntp_config) -> void;
 
+  auto LoadSubscriptionsConfig() -> SubscriptionsConfig;
+  auto StoreSubscriptionsConfig(SubscriptionsConfig const& subscriptions_config) -> void;
+
  private:
   static constexpr char const* kLoggingKey{"log"};
   static constexpr char const* kLoggingKeyLogLevel{"loglevel"};
@@ -81,11 +85,24 @@ class Persistency {
   static constexpr char const* kMqttKeyReconnectTime{"reconnect_t"};
   static constexpr char const* kMqttKeyTopic{"topic"};
   static constexpr char const* kMqttKeyClientId{"client_id"};
+  static constexpr char const* kMqttKeyDeviceTopics{"dev_topics"};
+  static constexpr char const* kMqttKeyBatchWindow{"batch_window"};
+  static constexpr char const* kMqttKeyBatchSize{"batch_size"};
+  static constexpr char const* kMqttKeyPublishQos{"publish_qos"};
+  static constexpr char const* kMqttKeyMaxInFlight{"max_in_flight"};
+  static constexpr char const* kMqttKeyOfflineBuffer{"offline_buf"};
+  static constexpr char const* kMqttKeyOfflineSpill{"offline_spill"};
+  static constexpr char const* kMqttKeyReplayRate{"replay_rate"};
 
   static constexpr char const* kNtpKey{"ntp"};
   static constexpr char const* kNtpKeyServerAddr{"server_addr"};
   static constexpr char const* kNtpKeyTimezone{"timezone"};
 
+  static constexpr char const* kSubscriptionsKey{"subs"};
+  static constexpr char const* kSubscriptionsKeyVersion{"version"};
+  static constexpr char const* kSubscriptionsKeyEntries{"entries"};
+  static constexpr char const* kSubscriptionsKeyReplyTopics{"reply_topics"};
+
   static auto FormatOnOff(bool enabled) -> char const*;
 
   Preferences preferences_;
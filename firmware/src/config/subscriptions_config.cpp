@@ -0,0 +1,57 @@
+#include "config/subscriptions_config.h"
+
+#include <cstring>
+#include <vector>
+
+namespace owif {
+namespace config {
+
+auto SubscriptionsConfig::GetSubscriptions() const -> std::vector<Subscription> const& { return subscriptions_; }
+
+auto SubscriptionsConfig::AddSubscription(Subscription const& subscription) -> bool {
+  bool result{false};
+  if (subscriptions_.size() < kMaxSubscriptions) {
+    subscriptions_.push_back(subscription);
+    result = true;
+  }
+  return result;
+}
+
+auto SubscriptionsConfig::GetReplyTopics() const -> std::vector<ReplyTopic> const& { return reply_topics_; }
+
+/*!
+ * \return Reply topic of the index or an empty string for kNoReplyTopic or an unknown index.
+ */
+auto SubscriptionsConfig::GetReplyTopic(std::uint8_t index) const -> char const* {
+  return index < reply_topics_.size() ? reply_topics_[index].topic : "";
+}
+
+/*!
+ * Add a reply topic unless it is already known.
+ * \return Index of the reply topic or kNoReplyTopic if the topic is empty, too long or the table is full.
+ */
+auto SubscriptionsConfig::AddReplyTopic(char const* topic) -> std::uint8_t {
+  std::size_t const topic_length{std::strlen(topic)};
+  if (topic_length == 0 || topic_length > kMaxReplyTopicLength) {
+    return kNoReplyTopic;
+  }
+
+  for (std::size_t i{0}; i < reply_topics_.size(); ++i) {
+    if (std::strcmp(reply_topics_[i].topic, topic) == 0) {
+      return static_cast<std::uint8_t>(i);
+    }
+  }
+
+  if (reply_topics_.size() >= kMaxReplyTopics) {
+    return kNoReplyTopic;
+  }
+
+  ReplyTopic reply_topic{};
+  std::strcpy(reply_topic.topic, topic);
+  reply_topics_.push_back(reply_topic);
+
+  return static_cast<std::uint8_t>(reply_topics_.size() - 1);
+}
+
+}  // namespace config
+}  // namespace owif
@@ -0,0 +1,83 @@
+#ifndef OWIF_CONFIG_SUBSCRIPTIONS_CONFIG_H
+#define OWIF_CONFIG_SUBSCRIPTIONS_CONFIG_H
+
+#include <cstdint>
+#include <vector>
+
+namespace owif {
+namespace config {
+
+/*!
+ * \brief Persisted subscriptions. Restored after a restart, so subscribers need not re-subscribe.
+ */
+class SubscriptionsConfig {
+ public:
+  /*!
+   * \brief Persisted subscription. Trivially copyable as the subscriptions are stored as a binary blob.
+   */
+  struct Subscription {
+    std::uint64_t device_id;         // Full 1-wire address. Unused for family subscriptions.
+    std::uint32_t interval;          // Subscription (sample) interval [ms]
+    std::uint32_t deadline;          // Deadline of the cyclic reads [ms]
+    float deadband;                  // Filter: Deadband
+    std::uint32_t max_silence;       // Filter: Max. silence [ms]
+    std::uint32_t publish_interval;  // Aggregation: Window length [ms]. 0: aggregation disabled
+    std::uint32_t min_interval;      // Adaptation: Min. interval [ms]
+    std::uint32_t max_interval;      // Adaptation: Max. interval [ms]. 0: adaptive sampling disabled
+    float adaptive_delta;            // Adaptation: Change per read above which the interval is shortened
+    std::uint8_t family_code;        // Device family. Only used for family subscriptions.
+    std::uint8_t attribute;          // cmd::DeviceAttributeType
+    std::uint8_t deadband_type;      // cmd::DeadbandType
+    std::uint8_t aggregates;         // Aggregation: Bit mask of cmd::Aggregate
+    std::uint8_t payload_format;     // cmd::PayloadFormat of the results
+    std::uint8_t reply_topic;        // Index of the reply topic. kNoReplyTopic: results on the status topic
+    bool is_family;                  // Family or single device subscription
+    bool on_change;                  // Filter: Publish on change only
+    bool all_devices;                // Wildcard subscription of all devices (device_id '*')
+  };
+
+  static constexpr std::size_t kMaxReplyTopicLength{64};
+
+  /*!
+   * \brief Persisted reply topic. Stored once and referenced by index, as all subscriptions of a requester usually
+   *        share the same reply topic.
+   */
+  struct ReplyTopic {
+    char topic[kMaxReplyTopicLength + 1];
+  };
+
+  // Layout version of the stored subscriptions. Stored subscriptions of a different version are discarded.
+  static constexpr std::uint8_t kVersion{6};
+  // Max. number of persisted subscriptions (limits the NVS blob size)
+  static constexpr std::size_t kMaxSubscriptions{64};
+  // Max. number of distinct persisted reply topics (limits the NVS blob size)
+  static constexpr std::size_t kMaxReplyTopics{8};
+  static constexpr std::uint8_t kNoReplyTopic{0xFF};
+
+  SubscriptionsConfig() = default;
+
+  SubscriptionsConfig(SubscriptionsConfig const&) = default;
+  SubscriptionsConfig(SubscriptionsConfig&&) = default;
+  auto operator=(SubscriptionsConfig const&) -> SubscriptionsConfig& = default;
+  auto operator=(SubscriptionsConfig&&) -> SubscriptionsConfig& = default;
+
+  ~SubscriptionsConfig() = default;
+
+  // ---- Public APIs ----
+
+  auto GetSubscriptions() const -> std::vector<Subscription> const&;
+  auto AddSubscription(Subscription const& subscription) -> bool;
+
+  auto GetReplyTopics() const -> std::vector<ReplyTopic> const&;
+  auto GetReplyTopic(std::uint8_t index) const -> char const*;
+  auto AddReplyTopic(char const* topic) -> std::uint8_t;
+
+ private:
+  std::vector<Subscription> subscriptions_{};
+  std::vector<ReplyTopic> reply_topics_{};
+};
+
+}  // namespace config
+}  // namespace owif
+
+#endif  // OWIF_CONFIG_SUBSCRIPTIONS_CONFIG_H
@@ -28,9 +28,12 @@ auto WebSocketLogger::write(std::uint8_t character) -> std::size_t {
       StoreHistory(line_buffer_);
 
       if (web_socket_->count() > 0) {
-        // Serialize the complete line once and send.
-        String const serialized_log_json{web_server::web_socket::WebSocketProtocol::SerializeLog(line_buffer_)};
-        web_socket_->textAll(serialized_log_json);
+        // Serialize the complete line once, directly into the send buffer.
+        AsyncWebSocketMessageBuffer* const buffer{
+            web_server::web_socket::WebSocketProtocol::SerializeLog(*web_socket_, line_buffer_)};
+        if (buffer != nullptr) {
+          web_socket_->textAll(buffer);
+        }
       }
       line_buffer_.clear();
     }
@@ -58,7 +61,11 @@ auto WebSocketLogger::LogFullHistory(AsyncWebSocketClient* client) -> void {
 
     std::uint8_t const history_buffer_index{static_cast<std::uint8_t>((history_start_ + i) % kMaxHistorySize)};
     String const& history_string{history_buffer_[history_buffer_index]};
-    client->text(web_server::web_socket::WebSocketProtocol::SerializeLog(history_string));
+    AsyncWebSocketMessageBuffer* const buffer{
+        web_server::web_socket::WebSocketProtocol::SerializeLog(*web_socket_, history_string)};
+    if (buffer != nullptr) {
+      client->text(buffer);
+    }
   }
 }
 
@@ -61,7 +61,10 @@ auto owif_setup() -> void {
   config::persistency_g.PrettyPrint(logging::logger_g);
 
   setup_result &= one_wire::one_wire_system_g.Begin(config::persistency_g.LoadOneWireConfig());
-  setup_result &= cmd::command_handler_g.Begin(&one_wire::one_wire_system_g);
+  // Results of restored subscriptions are published via MQTT
+  setup_result &= cmd::command_handler_g.Begin(&one_wire::one_wire_system_g,
+                                               mqtt::mqtt_msg_handler_g.GetCommandResultCallback(),
+                                               mqtt::mqtt_msg_handler_g.GetErrorResultCallback());
 
   // Setup OTA / WebServer / MqttClient before Ethernet to allow registration of ConnectionStateChangeHandlers
   setup_result &= time::ntp_client_g.Begin(config::persistency_g.LoadNtpConfig());
@@ -2,8 +2,11 @@
 
 #include <ArduinoJson.h>
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <type_traits>
+#include <utility>
 
 #include "cmd/json_builder.h"
 #include "cmd/json_constants.h"
@@ -19,6 +22,13 @@ auto MqttClient::Begin() -> bool {
 
   config_ = config::persistency_g.LoadMqttConfig();
 
+  rx_buffer_.resize(kMaxPayloadSize + 1);  // + null terminator
+
+  {
+    std::lock_guard<std::mutex> lock_guard{publish_mutex_};
+    offline_store_.Begin(config_.GetOfflineBuffer(), config_.GetOfflineSpill());
+  }
+
   // Configure MQTT client
   mqtt_client_.onConnect([this](bool session_preset) { OnConnected(session_preset); });
   mqtt_client_.onDisconnect([this](AsyncMqttClientDisconnectReason reason) { OnDisconnect(reason); });
@@ -27,6 +37,7 @@ auto MqttClient::Begin() -> bool {
     OnMqttSubscribe(MqttMsgId{msg_id}, static_cast<MqttQoS>(qos));
   });
   mqtt_client_.onUnsubscribe([this](MqttMsgId::type msg_id) { OnMqttUnsubscribe(MqttMsgId{msg_id}); });
+  mqtt_client_.onPublish([this](MqttMsgId::type msg_id) { OnMqttPublish(MqttMsgId{msg_id}); });
   mqtt_client_.onMessage([this](char const* topic, char const* payload, AsyncMqttClientMessageProperties properties,
                                 size_t len, size_t index,
                                 size_t total) { OnMqttMessage(topic, payload, properties, len, index, total); });
@@ -48,10 +59,24 @@ auto MqttClient::Begin() -> bool {
 auto MqttClient::End() -> void { mqtt_client_.disconnect(); }
 
 auto MqttClient::Loop() -> void {
-  if (reconnect_time_ != 0 && millis() >= reconnect_time_) {
-    reconnect_time_ = 0;
+  bool reconnect{false};
+  {
+    std::lock_guard<std::mutex> lock_guard{reconnect_mutex_};
+    if (reconnect_pending_ && reconnect_timer_.IsExpired()) {
+      reconnect_pending_ = false;
+      reconnect = true;
+    }
+  }
+  if (reconnect) {
     Connect();
   }
+
+  if (IsConnected()) {
+    RetryQueuedMessages();
+    ReplayOfflineMessages();
+  } else {
+    StashQueuedMessages();
+  }
 }
 
 auto MqttClient::IsConnected() -> bool { return mqtt_client_.connected(); }
@@ -64,19 +89,45 @@ auto MqttClient::OnConnectionStateChange(ConnectionStateChangeHandler handler) -
   }
 }
 
+/*!
+ * Publish a text payload. Messages which cannot be sent immediately are queued and retried by Loop().
+ * \return Message id of the sent message or 0 if the message was queued or dropped.
+ */
 auto MqttClient::Publish(char const* topic, char const* payload, MqttQoS qos, MqttRetain retain) -> MqttMsgId {
   logger_.Verbose("[MQTTClient] Publishing to MQTT (topic: %s qos: %u retain: %u) payload: %s", topic, qos, retain,
                   payload);
 
-  return MqttMsgId{mqtt_client_.publish(topic, static_cast<std::underlying_type_t<MqttQoS>>(qos),
-                                        retain == MqttRetain::kRetain, payload)};
+  return EnqueueOrSend(topic, reinterpret_cast<std::uint8_t const*>(payload), std::strlen(payload), qos, retain);
+}
+
+/*!
+ * Publish a binary payload, e.g. MessagePack.
+ */
+auto MqttClient::Publish(char const* topic, std::uint8_t const* payload, std::size_t length, MqttQoS qos,
+                         MqttRetain retain) -> MqttMsgId {
+  logger_.Verbose("[MQTTClient] Publishing to MQTT (topic: %s qos: %u retain: %u) binary payload: %u bytes", topic, qos,
+                  retain, length);
+
+  return EnqueueOrSend(topic, payload, length, qos, retain);
+}
+
+/*!
+ * Publish a payload serialized by the caller. If the message cannot be sent immediately, the payload is moved to the
+ * publish queue or the offline store, so it is never copied. The topic is only copied in that case.
+ */
+auto MqttClient::Publish(char const* topic, std::vector<std::uint8_t>&& payload, MqttQoS qos, MqttRetain retain)
+    -> MqttMsgId {
+  logger_.Verbose("[MQTTClient] Publishing to MQTT (topic: %s qos: %u retain: %u) payload: %u bytes", topic, qos,
+                  retain, payload.size());
+
+  return EnqueueOrSend(topic, payload.data(), payload.size(), qos, retain, &payload);
 }
 
 auto MqttClient::Subscribe(String topic, MessageHandler handler, MqttQoS qos) -> MqttMsgId {
   logger_.Verbose("[MQTTClient] Subscribing to MQTT topic '%s'", topic.c_str());
-  if (topic_handlers_.find(topic) == topic_handlers_.end()) {
+  if (FindTopicHandler(topic.c_str()) == nullptr) {
     if (handler) {
-      topic_handlers_[topic] = std::move(handler);
+      topic_handlers_.push_back(TopicHandler{topic, std::move(handler)});
     } else {
       logger_.Warn(F("[MQTTClient] Skip registration of invalid message handler for MQTT topic '%s'"), topic.c_str());
     }
@@ -99,10 +150,70 @@ auto MqttClient::GetTopicStatus() -> char const* {
   return topic_status_.c_str();
 }
 
+auto MqttClient::GetTopicCmdMsgPack() -> char const* {
+  if (topic_cmd_msgpack_.isEmpty()) {
+    topic_cmd_msgpack_ = String{GetTopicCmd()} + kTopicSuffixMsgPack;
+  }
+  return topic_cmd_msgpack_.c_str();
+}
+
+auto MqttClient::GetTopicStatusMsgPack() -> char const* {
+  if (topic_status_msgpack_.isEmpty()) {
+    topic_status_msgpack_ = String{GetTopicStatus()} + kTopicSuffixMsgPack;
+  }
+  return topic_status_msgpack_.c_str();
+}
+
+/*!
+ * \return Retained value topic of a device attribute: %topic%/dev/<device_id>/<attribute>
+ */
+auto MqttClient::GetTopicDevice(char const* device_id, char const* attribute) -> String {
+  return config_.GetTopic() + "/dev/" + device_id + "/" + attribute;
+}
+
+auto MqttClient::GetDeviceTopicsEnabled() const -> bool { return config_.GetDeviceTopics(); }
+
+auto MqttClient::AddStatistics(JsonObject& json) -> void {
+  std::lock_guard<std::mutex> lock_guard{publish_mutex_};
+
+  JsonObject json_queue{json[cmd::json::kStatisticsPublishQueue].to<JsonObject>()};
+  json_queue[cmd::json::kStatisticsSize] = publish_queue_.size();
+  json_queue[cmd::json::kStatisticsCapacity] = static_cast<std::uint16_t>(kPublishQueueSize);
+  json_queue[cmd::json::kStatisticsHighWaterMark] = publish_queue_high_water_mark_;
+  json_queue[cmd::json::kStatisticsInFlight] = in_flight_messages_.size();
+  json_queue[cmd::json::kStatisticsRetried] = retried_;
+  json_queue[cmd::json::kStatisticsDropped] = dropped_;
+
+  OfflineStoreStatistics const offline_statistics{offline_store_.GetStatistics()};
+  JsonObject json_offline{json[cmd::json::kStatisticsOfflineStore].to<JsonObject>()};
+  json_offline[cmd::json::kStatisticsSize] = offline_statistics.size;
+  json_offline[cmd::json::kStatisticsCapacity] = offline_statistics.capacity;
+  json_offline[cmd::json::kStatisticsSpilled] = offline_statistics.spilled;
+  json_offline[cmd::json::kStatisticsReplayed] = replayed_;
+  json_offline[cmd::json::kStatisticsDropped] = offline_statistics.dropped;
+
+  ReconnectStatistics reconnect_statistics{};
+  {
+    std::lock_guard<std::mutex> reconnect_lock_guard{reconnect_mutex_};
+    reconnect_statistics = reconnect_statistics_;
+  }
+
+  JsonObject json_connection{json[cmd::json::kStatisticsMqttConnection].to<JsonObject>()};
+  json_connection[cmd::json::kStatisticsReconnects] = reconnect_statistics.reconnects;
+  json_connection[cmd::json::kStatisticsAttempts] = reconnect_statistics.attempts;
+  json_connection[cmd::json::kStatisticsLastDelay] = reconnect_statistics.last_delay;
+  json_connection[cmd::json::kStatisticsLastDowntime] = reconnect_statistics.last_downtime;
+  json_connection[cmd::json::kStatisticsMaxDowntime] = reconnect_statistics.max_downtime;
+}
+
 // ---- Private APIs ---------------------------------------------------------------------------------------------------
 
 auto MqttClient::Connect() -> void {
   logger_.Debug(F("[MQTTClient] connecting..."));
+  {
+    std::lock_guard<std::mutex> lock_guard{reconnect_mutex_};
+    ++reconnect_statistics_.attempts;
+  }
   mqtt_client_.connect();
 }
 
@@ -123,6 +234,19 @@ auto MqttClient::OnConnected(bool session_present) -> void {
   logger_.Debug(F("[MQTTClient] connected. | session present: %T"), session_present);
 
   connection_state_ = ConnectionState::kConnected;
+  {
+    std::lock_guard<std::mutex> lock_guard{reconnect_mutex_};
+    if (disconnect_time_ != 0) {
+      std::uint32_t const downtime{static_cast<std::uint32_t>(time::TimeUtil::TimeSinceStartup() - disconnect_time_)};
+      ++reconnect_statistics_.reconnects;
+      reconnect_statistics_.last_downtime = downtime;
+      reconnect_statistics_.max_downtime = std::max(reconnect_statistics_.max_downtime, downtime);
+      logger_.Info(F("[MQTTClient] Reconnected after %u ms and %u attempts"), downtime, reconnect_attempts_);
+    }
+    disconnect_time_ = 0;
+    reconnect_attempts_ = 0;
+    reconnect_pending_ = false;
+  }
   NotifyConnectionStateChangeHandlers();
 
   SendLwtOnline();
@@ -132,10 +256,10 @@ auto MqttClient::OnDisconnect(AsyncMqttClientDisconnectReason reason) -> void {
   logger_.Debug(F("[MQTTClient] disconnected. | reason: %u"), reason);
 
   connection_state_ = ConnectionState::kDisconnected;
+  RequeueInFlightMessages();
 
   if (ethernet::ethernet_g.IsConnected()) {
-    logger_.Debug(F("[MQTTClient] Try to reconnect in %u ms"), config_.GetReconnectTimeout());
-    reconnect_time_ = millis() + config_.GetReconnectTimeout();
+    ScheduleReconnect();
   } else {
     logger_.Debug(F("No auto-reconnect as ethernet is disconnected."));
   }
@@ -143,6 +267,47 @@ auto MqttClient::OnDisconnect(AsyncMqttClientDisconnectReason reason) -> void {
   NotifyConnectionStateChangeHandlers();
 }
 
+/*!
+ * Schedule the next reconnect attempt. Called after the loss of the connection and after every failed attempt.
+ */
+auto MqttClient::ScheduleReconnect() -> void {
+  std::lock_guard<std::mutex> lock_guard{reconnect_mutex_};
+
+  if (disconnect_time_ == 0) {
+    disconnect_time_ = time::TimeUtil::TimeSinceStartup();
+  }
+
+  std::uint32_t const delay{GetReconnectDelay(reconnect_attempts_)};
+  ++reconnect_attempts_;
+  reconnect_statistics_.last_delay = delay;
+  reconnect_timer_.Reset(delay);
+  reconnect_pending_ = true;
+
+  logger_.Debug(F("[MQTTClient] Try to reconnect in %u ms"), delay);
+}
+
+/*!
+ * The first attempt after the loss of the connection is immediate, so short broker restarts are bridged quickly. The
+ * delay of further attempts doubles from kReconnectBaseDelay up to the configured reconnect timeout. A random jitter
+ * of up to half the delay keeps multiple interfaces from reconnecting in lockstep.
+ * \param attempt Number of failed attempts since the connection was lost.
+ */
+auto MqttClient::GetReconnectDelay(std::uint16_t attempt) const -> std::uint32_t {
+  if (attempt == 0) {
+    return 0;
+  }
+
+  std::uint32_t const max_delay{
+      std::max(config_.GetReconnectTimeout(), static_cast<std::uint32_t>(kReconnectBaseDelay))};
+  std::uint32_t delay{kReconnectBaseDelay};
+  for (std::uint16_t i{1}; i < attempt && delay < max_delay; ++i) {
+    delay *= 2;
+  }
+  delay = std::min(delay, max_delay);
+
+  return delay - (esp_random() % (delay / 2 + 1));
+}
+
 auto MqttClient::OnMqttSubscribe(MqttMsgId msg_id, MqttQoS qos) -> void {
   logger_.Verbose("[MQTTClient] Subscribe confirmed for msg %u", msg_id.value);
 }
@@ -151,15 +316,50 @@ auto MqttClient::OnMqttUnsubscribe(MqttMsgId msg_id) -> void {
   logger_.Verbose("[MQTTClient] Unsubscribe confirmed for msg %u", msg_id.value);
 }
 
+auto MqttClient::OnMqttPublish(MqttMsgId msg_id) -> void {
+  logger_.Verbose("[MQTTClient] Publish acknowledged for msg %u", msg_id.value);
+
+  std::lock_guard<std::mutex> lock_guard{publish_mutex_};
+  auto const iter{std::find_if(in_flight_messages_.begin(), in_flight_messages_.end(),
+                               [msg_id](InFlightMessage const& entry) { return entry.msg_id == msg_id.value; })};
+  if (iter != in_flight_messages_.end()) {
+    in_flight_messages_.erase(iter);
+  } else if (sending_) {
+    early_acks_.push_back(msg_id.value);  // Acknowledged before the sender tracks the message
+  }
+}
+
+/*!
+ * Payloads exceeding the TCP segment are delivered in fragments (index: offset of the fragment, total: size of the
+ * payload). The fragments are reassembled in the receive buffer and the message is dispatched once it is complete.
+ */
 auto MqttClient::OnMqttMessage(char const* topic, char const* payload, AsyncMqttClientMessageProperties properties,
                                size_t len, size_t index, size_t total) -> void {
-  // Dispatch to topic-specific message handler
-  if (topic_handlers_.find(topic) != topic_handlers_.end()) {
-    MessageHandler& message_handler{topic_handlers_.at(topic)};
-    message_handler(String{topic}, String{payload, len},
-                    MqttMsgProps{static_cast<MqttQoS>(properties.qos), properties.dup, properties.retain});
-  } else {
-    logger_.Warn(F("[MQTTClient] No message handler for MQTT topic '%s' found"), topic);
+  if (index == 0) {
+    rx_length_ = 0;
+    rx_discard_ = total > kMaxPayloadSize;
+    if (rx_discard_) {
+      logger_.Warn(F("[MQTTClient] Discarding message of %u bytes on topic '%s' (max. %u bytes)"), total, topic,
+                   static_cast<unsigned>(kMaxPayloadSize));
+    }
+  }
+
+  if (rx_discard_) {
+    return;
+  }
+
+  if (index != rx_length_ || index + len > total) {
+    logger_.Warn(F("[MQTTClient] Discarding out of order fragment of topic '%s'"), topic);
+    rx_discard_ = true;
+    return;
+  }
+
+  std::memcpy(&rx_buffer_[index], payload, len);
+  rx_length_ = index + len;
+
+  if (rx_length_ == total) {
+    rx_buffer_[rx_length_] = '\0';
+    DispatchMessage(topic, MqttMsgProps{static_cast<MqttQoS>(properties.qos), properties.dup, properties.retain});
   }
 }
 
@@ -169,6 +369,224 @@ auto MqttClient::NotifyConnectionStateChangeHandlers() -> void {
   }
 }
 
+/*!
+ * Dispatch the reassembled message in the receive buffer to the topic-specific message handler.
+ */
+auto MqttClient::DispatchMessage(char const* topic, MqttMsgProps properties) -> void {
+  TopicHandler* const topic_handler{FindTopicHandler(topic)};
+  if (topic_handler != nullptr) {
+    topic_handler->handler(topic, rx_buffer_.data(), rx_length_, properties);
+  } else {
+    logger_.Warn(F("[MQTTClient] No message handler for MQTT topic '%s' found"), topic);
+  }
+}
+
+auto MqttClient::FindTopicHandler(char const* topic) -> TopicHandler* {
+  auto const iter{std::find_if(topic_handlers_.begin(), topic_handlers_.end(), [topic](TopicHandler const& entry) {
+    return std::strcmp(entry.topic.c_str(), topic) == 0;
+  })};
+
+  return iter != topic_handlers_.end() ? &(*iter) : nullptr;
+}
+
+/*!
+ * Raise the QoS to the configured min. QoS and send the message. While disconnected, messages are kept in the offline
+ * store (if enabled). Messages are queued if the queue is not empty (to keep the order), if another message is being
+ * sent or if the MQTT client rejects the message. The oldest message is dropped if the queue is full.
+ * The topic (and the payload) are only copied into an outbound message if the message is kept.
+ * \param[in] payload_buffer Buffer owning the payload. Moved instead of copied when kept. nullptr: copy the payload.
+ */
+auto MqttClient::EnqueueOrSend(char const* topic, std::uint8_t const* payload, std::size_t length, MqttQoS qos,
+                               MqttRetain retain, std::vector<std::uint8_t>* payload_buffer) -> MqttMsgId {
+  MqttQoS const effective_qos{std::max(qos, static_cast<MqttQoS>(config_.GetPublishQos()))};
+  auto const to_outbound_message = [&]() -> OutboundMessage {
+    if (payload_buffer != nullptr) {
+      return OutboundMessage{String{topic}, std::move(*payload_buffer), effective_qos, retain};
+    }
+    return OutboundMessage{String{topic}, std::vector<std::uint8_t>{payload, payload + length}, effective_qos, retain};
+  };
+
+  std::unique_lock<std::mutex> lock{publish_mutex_};
+
+  if (offline_store_.IsEnabled() && not mqtt_client_.connected()) {
+    offline_store_.Push(to_outbound_message());
+    return MqttMsgId{0};
+  }
+
+  MqttMsgId msg_id{0};
+  if (publish_queue_.empty() && CanSend(effective_qos)) {
+    msg_id = SendMessage(lock, topic, payload, length, effective_qos, retain);
+    if (msg_id.value == 0) {
+      Requeue(to_outbound_message());
+    } else if (effective_qos != MqttQoS::kQoS0) {
+      TrackInFlight(msg_id, to_outbound_message());
+    }
+  } else {
+    Enqueue(to_outbound_message());
+  }
+
+  return msg_id;
+}
+
+/*!
+ * \return True if no other message is being sent and the in-flight limit allows another message of the QoS. Must be
+ *         called with the publish mutex held.
+ */
+auto MqttClient::CanSend(MqttQoS qos) const -> bool {
+  return not sending_ && (qos == MqttQoS::kQoS0 ||
+                          in_flight_messages_.size() < std::max<std::uint16_t>(config_.GetMaxInFlight(), 1));
+}
+
+/*!
+ * Hand over a message to the MQTT client. Must be called with the publish mutex held, which is released while the
+ * client copies the message into its TCP buffer. Other senders queue their messages meanwhile (see CanSend()), so the
+ * order is kept. Topic and payload must not be owned by the publish queue or the offline store.
+ * \return Message id or 0 if the client is disconnected or its buffer is full.
+ */
+auto MqttClient::SendMessage(std::unique_lock<std::mutex>& lock, char const* topic, std::uint8_t const* payload,
+                             std::size_t length, MqttQoS qos, MqttRetain retain) -> MqttMsgId {
+  sending_ = true;
+  lock.unlock();
+
+  MqttMsgId const msg_id{mqtt_client_.publish(topic, ToUnderlying(qos), retain == MqttRetain::kRetain,
+                                              reinterpret_cast<char const*>(payload), length)};
+
+  lock.lock();
+  sending_ = false;
+
+  return msg_id;
+}
+
+/*!
+ * Keep a sent QoS1 / QoS2 message until the broker acknowledges it. Must be called with the publish mutex held.
+ */
+auto MqttClient::TrackInFlight(MqttMsgId msg_id, OutboundMessage&& message) -> void {
+  auto const early_ack{std::find(early_acks_.begin(), early_acks_.end(), msg_id.value)};
+  if (early_ack != early_acks_.end()) {
+    early_acks_.erase(early_ack);
+  } else {
+    in_flight_messages_.push_back(InFlightMessage{msg_id.value, std::move(message)});
+  }
+}
+
+/*!
+ * Append a message to the publish queue. The oldest message is dropped if the queue is full. Must be called with the
+ * publish mutex held.
+ */
+auto MqttClient::Enqueue(OutboundMessage&& message) -> void {
+  if (publish_queue_.size() >= kPublishQueueSize) {
+    logger_.Warn(F("[MQTTClient] Publish queue full. Dropping oldest message (topic: %s)"),
+                 publish_queue_.front().topic.c_str());
+    publish_queue_.pop_front();
+    ++dropped_;
+  }
+
+  publish_queue_.push_back(std::move(message));
+  publish_queue_high_water_mark_ =
+      std::max(publish_queue_high_water_mark_, static_cast<std::uint16_t>(publish_queue_.size()));
+}
+
+/*!
+ * Put a message rejected by the MQTT client back to the front of the publish queue, so it is retried first. The message
+ * itself is dropped if the queue is full, as it is the oldest one. Must be called with the publish mutex held.
+ */
+auto MqttClient::Requeue(OutboundMessage&& message) -> void {
+  if (publish_queue_.size() >= kPublishQueueSize) {
+    logger_.Warn(F("[MQTTClient] Publish queue full. Dropping oldest message (topic: %s)"), message.topic.c_str());
+    ++dropped_;
+  } else {
+    publish_queue_.push_front(std::move(message));
+    publish_queue_high_water_mark_ =
+        std::max(publish_queue_high_water_mark_, static_cast<std::uint16_t>(publish_queue_.size()));
+  }
+}
+
+/*!
+ * Put the messages without acknowledgment back to the front of the publish queue once the connection is lost, so they
+ * are resent (or moved to the offline store) in their original order. The client does not resend them itself.
+ */
+auto MqttClient::RequeueInFlightMessages() -> void {
+  std::lock_guard<std::mutex> lock_guard{publish_mutex_};
+
+  while (!in_flight_messages_.empty()) {
+    Requeue(std::move(in_flight_messages_.back().message));
+    in_flight_messages_.pop_back();
+  }
+  early_acks_.clear();
+}
+
+/*!
+ * Send the queued messages in order until the first one is rejected again. Each message is taken out of the queue
+ * before it is handed over to the MQTT client.
+ */
+auto MqttClient::RetryQueuedMessages() -> void {
+  std::unique_lock<std::mutex> lock{publish_mutex_};
+
+  while (!publish_queue_.empty() && CanSend(publish_queue_.front().qos)) {
+    OutboundMessage message{std::move(publish_queue_.front())};
+    publish_queue_.pop_front();
+
+    MqttMsgId const msg_id{SendMessage(lock, message.topic.c_str(), message.payload.data(), message.payload.size(),
+                                       message.qos, message.retain)};
+    if (msg_id.value == 0) {
+      Requeue(std::move(message));
+      break;
+    }
+    ++retried_;
+    if (message.qos != MqttQoS::kQoS0) {
+      TrackInFlight(msg_id, std::move(message));
+    }
+  }
+}
+
+/*!
+ * Move the messages queued for a retry to the offline store once the connection is lost.
+ */
+auto MqttClient::StashQueuedMessages() -> void {
+  std::lock_guard<std::mutex> lock_guard{publish_mutex_};
+
+  if (offline_store_.IsEnabled()) {
+    while (!publish_queue_.empty()) {
+      offline_store_.Push(std::move(publish_queue_.front()));
+      publish_queue_.pop_front();
+    }
+  }
+}
+
+/*!
+ * Send the messages of the offline store in order, throttled to the configured replay rate. Live messages are not
+ * delayed by the replay. The replay pauses while messages are queued for a retry. A replayed message rejected by the
+ * MQTT client is queued for a retry.
+ * Replayed messages are not retained: Live messages published since reconnecting already hold the newer value of the
+ * topic, which must not be replaced by an outdated one.
+ */
+auto MqttClient::ReplayOfflineMessages() -> void {
+  std::unique_lock<std::mutex> lock{publish_mutex_};
+
+  if (!publish_queue_.empty() || offline_store_.IsEmpty() || not replay_timer_.IsExpired()) {
+    return;
+  }
+
+  OutboundMessage* const front{offline_store_.Front()};
+  if (front != nullptr && CanSend(front->qos)) {
+    OutboundMessage message{std::move(*front)};
+    offline_store_.Pop();
+    message.retain = MqttRetain::kNoRetain;
+    replay_timer_.Reset(1000U / std::max<std::uint16_t>(config_.GetReplayRate(), 1));  // ms
+
+    MqttMsgId const msg_id{SendMessage(lock, message.topic.c_str(), message.payload.data(), message.payload.size(),
+                                       message.qos, message.retain)};
+    if (msg_id.value == 0) {
+      Requeue(std::move(message));
+    } else {
+      ++replayed_;
+      if (message.qos != MqttQoS::kQoS0) {
+        TrackInFlight(msg_id, std::move(message));
+      }
+    }
+  }
+}
+
 auto MqttClient::SetLwtOffline() -> void {
   JsonDocument lwt_json{};
   lwt_json[cmd::json::kRootState] = cmd::json::kStateOffline;
@@ -4,29 +4,22 @@
 #include <ArduinoJson.h>
 #include <AsyncMqttClient.h>
 
-#include <map>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <vector>
 
+#include "cmd/timer.h"
 #include "config/mqtt_config.h"
 #include "ethernet/ethernet.h"
 #include "logging/logger.h"
+#include "mqtt/offline_store.h"
+#include "mqtt/qos.h"
+#include "time/time_util.h"
 
 namespace owif {
 namespace mqtt {
 
-enum class MqttQoS : std::uint8_t {
-  kQoS0 = 0,  // At most once:  QoS 0 offers "fire and forget" messaging with no acknowledgment from the receiver.
-  kQoS1 = 1,  // At least once: QoS 1 ensures that messages are delivered at least once by requiring a PUBACK
-              // acknowledgment.
-  kQoS2 = 2   // Exactly once: QoS 2 guarantees that each message is delivered exactly once by using a four-step
-              // handshake (PUBLISH, PUBREC, PUBREL, PUBCOMP).
-};
-
-enum class MqttRetain : std::uint8_t {
-  kNoRetain = 0,  // Do not retain the message.
-  kRetain = 1     // Broker stores last retained message. New subscribers will immediately get the retained message.
-};
-
 struct MqttMsgId {
   using type = std::uint16_t;
   type value;
@@ -41,7 +34,12 @@ struct MqttMsgProps {
 enum class ConnectionState : std::uint8_t { kDisconnected = 0, kConnected = 1 };
 
 using ConnectionStateChangeHandler = std::function<void(ConnectionState connection_state)>;
-using MessageHandler = std::function<void(String topic, String payload, MqttMsgProps properties)>;
+/*!
+ * \brief Handler of a received message. The complete payload is passed in the null-terminated receive buffer of the
+ *        MQTT client. It is valid until the handler returns.
+ */
+using MessageHandler =
+    std::function<void(char const* topic, char const* payload, std::size_t length, MqttMsgProps properties)>;
 
 class MqttClient {
  public:
@@ -64,13 +62,44 @@ class MqttClient {
 
   auto Publish(char const* topic, char const* payload, MqttQoS qos = MqttQoS::kQoS0,
                MqttRetain retain = MqttRetain::kNoRetain) -> MqttMsgId;
+  auto Publish(char const* topic, std::uint8_t const* payload, std::size_t length, MqttQoS qos = MqttQoS::kQoS0,
+               MqttRetain retain = MqttRetain::kNoRetain) -> MqttMsgId;
+  auto Publish(char const* topic, std::vector<std::uint8_t>&& payload, MqttQoS qos = MqttQoS::kQoS0,
+               MqttRetain retain = MqttRetain::kNoRetain) -> MqttMsgId;
   auto Subscribe(String topic, MessageHandler handler, MqttQoS qos = MqttQoS::kQoS0) -> MqttMsgId;
 
   auto GetTopicCmd() -> char const*;
   auto GetTopicStatus() -> char const*;
+  auto GetTopicCmdMsgPack() -> char const*;
+  auto GetTopicStatusMsgPack() -> char const*;
+  auto GetTopicDevice(char const* device_id, char const* attribute) -> String;
+  auto GetDeviceTopicsEnabled() const -> bool;
+
+  auto AddStatistics(JsonObject& json) -> void;
 
  private:
-  static constexpr std::size_t kReconnectDelay{10 * 1000};  // ms
+  static constexpr std::uint32_t kReconnectBaseDelay{1000};      // ms. Delay of the second reconnect attempt
+  static constexpr char const* kTopicSuffixMsgPack{"/msgpack"};  // Suffix of the MessagePack command / status topics
+  static constexpr std::size_t kPublishQueueSize{32};            // Max. number of queued outbound messages
+  static constexpr std::size_t kMaxPayloadSize{8 * 1024};        // Max. size of a received message [bytes]
+
+  struct TopicHandler {
+    String topic;
+    MessageHandler handler;
+  };
+
+  struct InFlightMessage {
+    MqttMsgId::type msg_id;   // Id assigned by the MQTT client. Released by its PUBACK.
+    OutboundMessage message;  // Kept until acknowledged, so it can be resent after a reconnect
+  };
+
+  struct ReconnectStatistics {
+    std::uint32_t reconnects;     // Number of successful reconnects
+    std::uint32_t attempts;       // Number of connection attempts, including the initial one
+    std::uint32_t last_delay;     // ms. Delay before the last reconnect attempt
+    std::uint32_t last_downtime;  // ms. Time from the loss of the connection until the last reconnect
+    std::uint32_t max_downtime;   // ms. Max. downtime since startup
+  };
 
   auto OnConnectionStateChange(ethernet::ConnectionState connection_state) -> void;
 
@@ -78,13 +107,31 @@ class MqttClient {
   auto Disconnect() -> void;
 
   auto OnConnected(bool session_resent) -> void;
+  auto ScheduleReconnect() -> void;
+  auto GetReconnectDelay(std::uint16_t attempt) const -> std::uint32_t;
   auto OnDisconnect(AsyncMqttClientDisconnectReason reason) -> void;
   auto OnMqttSubscribe(MqttMsgId msg_id, MqttQoS qos) -> void;
   auto OnMqttUnsubscribe(MqttMsgId msg_id) -> void;
+  auto OnMqttPublish(MqttMsgId msg_id) -> void;
   auto OnMqttMessage(char const* topic, char const* payload, AsyncMqttClientMessageProperties properties, size_t len,
                      size_t index, size_t total) -> void;
 
   auto NotifyConnectionStateChangeHandlers() -> void;
+  auto DispatchMessage(char const* topic, MqttMsgProps properties) -> void;
+  auto FindTopicHandler(char const* topic) -> TopicHandler*;
+
+  auto EnqueueOrSend(char const* topic, std::uint8_t const* payload, std::size_t length, MqttQoS qos,
+                     MqttRetain retain, std::vector<std::uint8_t>* payload_buffer = nullptr) -> MqttMsgId;
+  auto CanSend(MqttQoS qos) const -> bool;
+  auto SendMessage(std::unique_lock<std::mutex>& lock, char const* topic, std::uint8_t const* payload,
+                   std::size_t length, MqttQoS qos, MqttRetain retain) -> MqttMsgId;
+  auto TrackInFlight(MqttMsgId msg_id, OutboundMessage&& message) -> void;
+  auto Enqueue(OutboundMessage&& message) -> void;
+  auto Requeue(OutboundMessage&& message) -> void;
+  auto RequeueInFlightMessages() -> void;
+  auto RetryQueuedMessages() -> void;
+  auto StashQueuedMessages() -> void;
+  auto ReplayOfflineMessages() -> void;
 
   auto SetLwtOffline() -> void;
   auto SendLwtOnline() -> void;
@@ -94,16 +141,40 @@ class MqttClient {
   config::MqttConfig config_;
   ::AsyncMqttClient mqtt_client_{};
 
-  std::size_t reconnect_time_{0};
+  std::mutex reconnect_mutex_{};                // Guards the reconnect state. Written by the MQTT task.
+  bool reconnect_pending_{false};               // Reconnect attempt scheduled by reconnect_timer_
+  cmd::Timer reconnect_timer_{};                // Delay until the next reconnect attempt
+  std::uint16_t reconnect_attempts_{0};         // Consecutive failed attempts since the connection was lost
+  time::TimeStampMs disconnect_time_{0};        // Time of the loss of the connection. 0: connected
+  ReconnectStatistics reconnect_statistics_{};  // Reported by the statistics command
 
   ConnectionState connection_state_{ConnectionState::kDisconnected};
   std::vector<ConnectionStateChangeHandler> connection_state_change_handlers_{};
-  std::map<String, MessageHandler> topic_handlers_{};
+  std::vector<TopicHandler> topic_handlers_{};  // Few topics only, searched linearly without allocation
+
+  std::vector<char> rx_buffer_{};  // Reassembly buffer of fragmented messages. Allocated once in Begin().
+  std::size_t rx_length_{0};       // Number of received bytes of the current message
+  bool rx_discard_{false};         // Current message exceeds the buffer and is discarded
 
   String topic_cmd_{};
   String topic_status_{};
+  String topic_cmd_msgpack_{};
+  String topic_status_msgpack_{};
 
   String lwt_offline_{};
+
+  std::mutex publish_mutex_{};                        // Guards the publish queue and its counters
+  std::deque<OutboundMessage> publish_queue_{};       // Messages waiting for a retry. Oldest first.
+  std::uint16_t publish_queue_high_water_mark_{0};    // Max. number of queued messages since startup
+  bool sending_{false};                               // A message is handed over to the client without the mutex
+  std::deque<InFlightMessage> in_flight_messages_{};  // QoS1 / QoS2 messages without PUBACK. Oldest first.
+  std::vector<MqttMsgId::type> early_acks_{};         // PUBACKs received before the send returned the message id
+  std::uint32_t retried_{0};                          // Number of queued messages sent by a retry
+  std::uint32_t dropped_{0};                          // Number of messages dropped due to a full queue
+
+  OfflineStore offline_store_{};  // Messages published while disconnected. Guarded by the publish mutex.
+  std::uint32_t replayed_{0};     // Number of offline messages sent after reconnecting
+  cmd::Timer replay_timer_{};     // Delay until the next replayed message
 };
 
 extern MqttClient mqtt_client_g;
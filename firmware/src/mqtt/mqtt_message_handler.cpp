@@ -3,7 +3,12 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include "cmd/command.h"
+#include "cmd/command_attachments.h"
 #include "cmd/command_handler.h"
 #include "cmd/json_builder.h"
 #include "cmd/json_constants.h"
@@ -12,6 +17,8 @@
 #include "config/persistency.h"
 #include "mqtt/mqtt_client.h"
 #include "time/time_util.h"
+#include "util/json_allocator.h"
+#include "util/language.h"
 
 namespace owif {
 namespace mqtt {
@@ -23,11 +30,23 @@ auto MqttMessageHandler::Begin(MqttClient* mqtt_client, cmd::CommandHandler* com
 
   command_handler_ = command_handler;
 
+  config::MqttConfig const mqtt_config{config::persistency_g.LoadMqttConfig()};
+  batch_window_ = mqtt_config.GetBatchWindow();
+  batch_size_ = std::max(mqtt_config.GetBatchSize(), static_cast<std::uint16_t>(1));
+  for (Batch& batch : batches_) {
+    batch.json = JsonDocument{&util::json_allocator_g};
+  }
+
   mqtt_client_->OnConnectionStateChange([this](ConnectionState connection_state) {
     if (connection_state == ConnectionState::kConnected) {
-      MqttMsgId msg_id{mqtt_client_->Subscribe(
-          mqtt_client_->GetTopicCmd(),
-          [this](String topic, String payload, MqttMsgProps props) { ProcessMessage(topic, payload, props); })};
+      mqtt_client_->Subscribe(mqtt_client_->GetTopicCmd(),
+                              [this](char const* topic, char const* payload, std::size_t length, MqttMsgProps props) {
+                                ProcessMessage(topic, payload, length, props, cmd::PayloadFormat::Json);
+                              });
+      mqtt_client_->Subscribe(mqtt_client_->GetTopicCmdMsgPack(),
+                              [this](char const* topic, char const* payload, std::size_t length, MqttMsgProps props) {
+                                ProcessMessage(topic, payload, length, props, cmd::PayloadFormat::MsgPack);
+                              });
     }
   });
 
@@ -35,202 +54,368 @@ auto MqttMessageHandler::Begin(MqttClient* mqtt_client, cmd::CommandHandler* com
 }
 
 auto MqttMessageHandler::Loop() -> void {
-  // Nothing to be done
+  if (batch_window_ > 0) {
+    FlushBatches();
+  }
 }
 
 // ---- Private APIs ---------------------------------------------------------------------------------------------------
 
 // ---- Request Handling ----
 
-auto MqttMessageHandler::ProcessMessage(String topic, String payload, MqttMsgProps props) -> void {
-  logger_.Verbose("[MqttMessageHandler] Msg received | topic: %s payload: %s", topic.c_str(), payload.c_str());
+/*!
+ * \param[in] payload Complete, null-terminated payload in the receive buffer of the MQTT client. Parsed in place.
+ * \param[in] payload_format Format of the payload. Determined by the topic the message was received on.
+ */
+auto MqttMessageHandler::ProcessMessage(char const* topic, char const* payload, std::size_t length,
+                                        MqttMsgProps props, cmd::PayloadFormat payload_format) -> void {
+  CommonAttributes common_attributes{};
+  common_attributes.payload_format = payload_format;
+  common_attributes.request_id_attachment = cmd::kNoAttachment;
+  common_attributes.reply_to_attachment = cmd::kNoAttachment;
+
+  JsonDocument json{&util::json_allocator_g};
+  DeserializationError deserialization_result{};
+  char const* request_json{payload};  // Requests are echoed as JSON in error responses
+  String request_json_msgpack{};      // JSON echo of a MessagePack request
+  if (payload_format == cmd::PayloadFormat::MsgPack) {
+    logger_.Verbose("[MqttMessageHandler] Msg received | topic: %s payload: %u bytes", topic, length);
+    deserialization_result = deserializeMsgPack(json, payload, length);
+    if (deserialization_result == DeserializationError::Ok) {
+      serializeJson(json, request_json_msgpack);
+    }
+    request_json = request_json_msgpack.c_str();
+  } else {
+    logger_.Verbose("[MqttMessageHandler] Msg received | topic: %s payload: %s", topic, payload);
+    deserialization_result = deserializeJson(json, payload, length);
+  }
 
-  JsonDocument json{};
-  DeserializationError deserialization_result{deserializeJson(json, payload.c_str())};
   if (deserialization_result == DeserializationError::Ok) {
-    JsonVariant action_json{json[cmd::json::kRootAction]};
-    String action{action_json.as<String>()};
-
-    if (action == cmd::json::kActionRestart) {
-      ProcessActionRestart(json);
-    } else if (action == cmd::json::kActionScan) {
-      ProcessActionScan(json);
-    } else if (action == cmd::json::kActionRead) {
-      ProcessActionRead(json);
-    } else if (action == cmd::json::kActionSubscribe) {
-      ProcessActionSubscribe(json);
-    } else if (action == cmd::json::kActionUnsubscribe) {
-      ProcessActionUnsubscribe(json);
+    bool const request_id_result{cmd::json::JsonParser::ParseRequestId(json, common_attributes.request_id)};
+    bool const deadline_result{cmd::json::JsonParser::ParseDeadline(json, common_attributes.deadline)};
+    bool const reply_to_result{cmd::json::JsonParser::ParseReplyTo(json, common_attributes.reply_to)};
+    if (not reply_to_result) {
+      SendErrorResponse(common_attributes, "Invalid JSON attribute 'reply_to'.", request_json);
+    } else if (request_id_result && deadline_result) {
+      if (AddAttachments(common_attributes)) {
+        JsonVariant action_json{json[cmd::json::kRootAction]};
+        String action{action_json.as<String>()};
+
+        if (action == cmd::json::kActionRestart) {
+          ProcessActionRestart(json, common_attributes);
+        } else if (action == cmd::json::kActionScan) {
+          ProcessActionScan(json, common_attributes);
+        } else if (action == cmd::json::kActionRead) {
+          ProcessActionRead(json, common_attributes);
+        } else if (action == cmd::json::kActionSubscribe) {
+          ProcessActionSubscribe(json, common_attributes);
+        } else if (action == cmd::json::kActionUnsubscribe) {
+          ProcessActionUnsubscribe(json, common_attributes);
+        } else if (action == cmd::json::kActionStatistics) {
+          ProcessActionStatistics(json, common_attributes);
+        } else {
+          SendErrorResponse(common_attributes, "Unknown/Unsupported action.", request_json);
+        }
+      } else {
+        SendErrorResponse(common_attributes, "Too many pending requests with 'id' or 'reply_to'. Retry later.",
+                          request_json, cmd::ErrorCode::Busy);
+      }
+      // The enqueued commands hold their own references
+      ReleaseAttachments(common_attributes);
     } else {
-      SendErrorResponse("Unknown/Unsupported action.", payload.c_str());
+      SendErrorResponse(common_attributes, "Invalid JSON attributes 'id' or 'deadline'.", request_json);
     }
   } else {
-    SendErrorResponse("Failed to deserialize MQTT message.", payload.c_str());
+    SendErrorResponse(common_attributes, "Failed to deserialize MQTT message.", request_json);
   }
 }
 
 /*!
  * no parameters
  */
-auto MqttMessageHandler::ProcessActionRestart(JsonDocument json) -> void {
+auto MqttMessageHandler::ProcessActionRestart(JsonDocument const& json, CommonAttributes const& common_attributes)
+    -> void {
   logger_.Debug("[MqttMessageHandler] Process action 'restart'");
 
-  cmd::Command const cmd{InitEmptyCommand(cmd::Action::Restart)};
+  cmd::Command const cmd{InitEmptyCommand(cmd::Action::Restart, common_attributes)};
   command_handler_->EnqueueCommand(cmd);
 }
 
 /*!
- * param1: [Optional] device_id
- * param2: [Optional] family_code
+ * params: [Optional] device_id or family_code
  */
-auto MqttMessageHandler::ProcessActionScan(JsonDocument json) -> void {
+auto MqttMessageHandler::ProcessActionScan(JsonDocument const& json, CommonAttributes const& common_attributes)
+    -> void {
   logger_.Debug("[MqttMessageHandler] Process action 'scan'");
 
-  cmd::Command cmd{InitEmptyCommand(cmd::Action::Scan)};
+  cmd::Command cmd{InitEmptyCommand(cmd::Action::Scan, common_attributes)};
 
   bool address_parsing_result{
-      cmd::json::JsonParser::ParseAddressing(json, cmd.param1, cmd.param2, /* any_address_info_mandatory:*/ false)};
+      cmd::json::JsonParser::ParseAddressing(json, cmd.params, /* any_address_info_mandatory:*/ false)};
 
   if (address_parsing_result) {
     command_handler_->EnqueueCommand(cmd);
   } else {
     String request_json{};
     serializeJson(json, request_json);
-    SendErrorResponse("Missing or invalid JSON attributes 'device_id' or 'family_code'.", request_json.c_str());
+    SendErrorResponse(common_attributes, "Missing or invalid JSON attributes 'device_id' or 'family_code'.",
+                      request_json.c_str());
   }
 }
 
 /*!
- * param1: [Optional] device_id
- * param2: [Optional] family_code
- * param3: device_attribute
+ * params: [Optional] device_id or family_code, device_attribute
  */
-auto MqttMessageHandler::ProcessActionRead(JsonDocument json) -> void {
+auto MqttMessageHandler::ProcessActionRead(JsonDocument const& json, CommonAttributes const& common_attributes)
+    -> void {
   logger_.Debug("[MqttMessageHandler] Process action 'read'");
 
-  cmd::Command cmd{InitEmptyCommand(cmd::Action::Read)};
+  cmd::Command cmd{InitEmptyCommand(cmd::Action::Read, common_attributes)};
 
   bool address_parsing_result{
-      cmd::json::JsonParser::ParseAddressing(json, cmd.param1, cmd.param2, /* any_address_info_mandatory:*/ true)};
+      cmd::json::JsonParser::ParseAddressing(json, cmd.params, /* any_address_info_mandatory:*/ true)};
 
   if (address_parsing_result) {
-    bool const has_attribute_param{cmd::json::JsonParser::ParseDeviceAttribute(json, cmd.param3)};
+    bool const has_attribute_param{cmd::json::JsonParser::ParseDeviceAttribute(json, cmd.params)};
 
     if (has_attribute_param) {
       command_handler_->EnqueueCommand(cmd);
     } else {
       String request_json{};
       serializeJson(json, request_json);
-      SendErrorResponse("Missing or invalid JSON attribute 'attribute'.", request_json.c_str());
+      SendErrorResponse(common_attributes, "Missing or invalid JSON attribute 'attribute'.",
+                        request_json.c_str());
     }
   } else {
     String request_json{};
     serializeJson(json, request_json);
-    SendErrorResponse("Missing or invalid JSON attributes 'device_id' or 'family_code'.", request_json.c_str());
+    SendErrorResponse(common_attributes, "Missing or invalid JSON attributes 'device_id' or 'family_code'.",
+                      request_json.c_str());
   }
 }
 
 /*!
- * param1: [Optional] device_id
- * param2: [Optional] family_code
- * param3: device_attribute
- * param4: interval
+ * params: device_id ('*': all devices) or family_code, device_attribute ('*': all measured attributes), interval,
+ *         [Optional] filter, [Optional] aggregation, [Optional] adaptation
  */
-auto MqttMessageHandler::ProcessActionSubscribe(JsonDocument json) -> void {
+auto MqttMessageHandler::ProcessActionSubscribe(JsonDocument const& json, CommonAttributes const& common_attributes)
+    -> void {
   logger_.Debug("[MqttMessageHandler] Process action 'subscribe'");
 
-  cmd::Command cmd{InitEmptyCommand(cmd::Action::Subscribe)};
-  bool address_parsing_result{
-      cmd::json::JsonParser::ParseAddressing(json, cmd.param1, cmd.param2, /* any_address_info_mandatory:*/ true)};
+  cmd::Command cmd{InitEmptyCommand(cmd::Action::Subscribe, common_attributes)};
+  bool address_parsing_result{cmd::json::JsonParser::ParseAddressing(
+      json, cmd.params, /* any_address_info_mandatory:*/ true, /* wildcard_allowed:*/ true)};
 
   if (address_parsing_result) {
-    bool const has_attribute_param{cmd::json::JsonParser::ParseDeviceAttribute(json, cmd.param3)};
-    bool const has_interval_param{json[cmd::json::kActionSubscribeInterval].is<cmd::TimeIntervalType::type>()};
-
-    if (has_attribute_param && has_interval_param) {
-      cmd.param4.param_available = true;  // interval.
-      cmd.param4.param_value.interval.value =
-          json[cmd::json::kActionSubscribeInterval].as<cmd::TimeIntervalType::type>();
-
-      command_handler_->EnqueueCommand(cmd);
+    bool const has_attribute_param{
+        cmd::json::JsonParser::ParseDeviceAttribute(json, cmd.params, /* wildcard_allowed:*/ true)};
+    // Windowed subscriptions may name the interval 'sample_interval'
+    char const* const interval_key{json[cmd::json::kActionSubscribeSampleInterval].isNull()
+                                       ? cmd::json::kActionSubscribeInterval
+                                       : cmd::json::kActionSubscribeSampleInterval};
+    bool const has_interval_param{json[interval_key].is<cmd::TimeIntervalType::type>()};
+    cmd::SubscriptionOptions options{};
+    bool const filter_parsing_result{cmd::json::JsonParser::ParseSubscriptionFilter(json, options)};
+    bool const aggregation_parsing_result{cmd::json::JsonParser::ParseSubscriptionAggregation(json, options)};
+    // Parsed after the filter: The adaptive delta defaults to the deadband
+    bool const adaptation_parsing_result{cmd::json::JsonParser::ParseSubscriptionAdaptation(json, options)};
+
+    if (has_attribute_param && has_interval_param && filter_parsing_result && aggregation_parsing_result &&
+        adaptation_parsing_result) {
+      cmd.params.has_interval = true;
+      cmd.params.interval.value = json[interval_key].as<cmd::TimeIntervalType::type>();
+
+      if (cmd::command_attachments_g.AddSubscriptionOptions(options, cmd.subscription_options)) {
+        command_handler_->EnqueueCommand(cmd);
+        cmd::command_attachments_g.Release(cmd.subscription_options);
+      } else {
+        String request_json{};
+        serializeJson(json, request_json);
+        SendErrorResponse(common_attributes, "Too many pending subscribes. Retry later.", request_json.c_str(),
+                          cmd::ErrorCode::Busy);
+      }
+    } else if (not filter_parsing_result) {
+      String request_json{};
+      serializeJson(json, request_json);
+      SendErrorResponse(common_attributes,
+                        "Invalid JSON attributes 'on_change', 'deadband', 'deadband_type' or 'max_silence'.",
+                        request_json.c_str());
+    } else if (not aggregation_parsing_result) {
+      String request_json{};
+      serializeJson(json, request_json);
+      SendErrorResponse(common_attributes, "Invalid JSON attributes 'publish_interval' or 'aggregates'.",
+                        request_json.c_str());
+    } else if (not adaptation_parsing_result) {
+      String request_json{};
+      serializeJson(json, request_json);
+      SendErrorResponse(common_attributes,
+                        "Invalid JSON attributes 'min_interval', 'max_interval' or 'adaptive_delta'.",
+                        request_json.c_str());
     } else {
       String request_json{};
       serializeJson(json, request_json);
-      SendErrorResponse("Missing or invalid JSON attributes 'attribute' or 'interval'.", request_json.c_str());
+      SendErrorResponse(common_attributes, "Missing or invalid JSON attributes 'attribute' or 'interval'.",
+                        request_json.c_str());
     }
   } else {
     String request_json{};
     serializeJson(json, request_json);
-    SendErrorResponse("Missing or invalid JSON attributes 'device_id' or 'family_code'.", request_json.c_str());
+    SendErrorResponse(common_attributes, "Missing or invalid JSON attributes 'device_id' or 'family_code'.",
+                      request_json.c_str());
   }
 }
 
 /*!
- * param1: [Optional] device_id
- * param2: [Optional] family_code
- * param3: device_attribute
+ * params: device_id ('*': all devices) or family_code, device_attribute ('*': all measured attributes)
  */
-auto MqttMessageHandler::ProcessActionUnsubscribe(JsonDocument json) -> void {
+auto MqttMessageHandler::ProcessActionUnsubscribe(JsonDocument const& json, CommonAttributes const& common_attributes)
+    -> void {
   logger_.Debug("[MqttMessageHandler] Process action 'unsubscribe'");
 
-  cmd::Command cmd{InitEmptyCommand(cmd::Action::Unsubscribe)};
-  bool address_parsing_result{
-      cmd::json::JsonParser::ParseAddressing(json, cmd.param1, cmd.param2, /* any_address_info_mandatory:*/ true)};
+  cmd::Command cmd{InitEmptyCommand(cmd::Action::Unsubscribe, common_attributes)};
+  bool address_parsing_result{cmd::json::JsonParser::ParseAddressing(
+      json, cmd.params, /* any_address_info_mandatory:*/ true, /* wildcard_allowed:*/ true)};
 
   if (address_parsing_result) {
-    bool const has_attribute_param{cmd::json::JsonParser::ParseDeviceAttribute(json, cmd.param3)};
+    bool const has_attribute_param{
+        cmd::json::JsonParser::ParseDeviceAttribute(json, cmd.params, /* wildcard_allowed:*/ true)};
     if (has_attribute_param) {
       command_handler_->EnqueueCommand(cmd);
     } else {
       String request_json{};
       serializeJson(json, request_json);
-      SendErrorResponse("Missing or invalid JSON attribute 'attribute'.", request_json.c_str());
+      SendErrorResponse(common_attributes, "Missing or invalid JSON attribute 'attribute'.",
+                        request_json.c_str());
     }
   } else {
     String request_json{};
     serializeJson(json, request_json);
-    SendErrorResponse("Missing or invalid JSON attributes 'device_id' or 'family_code'.", request_json.c_str());
+    SendErrorResponse(common_attributes, "Missing or invalid JSON attributes 'device_id' or 'family_code'.",
+                      request_json.c_str());
   }
 }
 
+/*!
+ * no parameters
+ *
+ * Processed immediately without passing the command queue. Statistics are therefore also available under overload.
+ */
+auto MqttMessageHandler::ProcessActionStatistics(JsonDocument const& json, CommonAttributes const& common_attributes)
+    -> void {
+  logger_.Debug("[MqttMessageHandler] Process action 'statistics'");
+
+  JsonDocument response_json{&util::json_allocator_g};
+  response_json[cmd::json::kRootAction] = cmd::json::kActionStatistics;
+  JsonObject json_statistics{response_json.as<JsonObject>()};
+  command_handler_->AddStatistics(json_statistics);
+  mqtt_client_->AddStatistics(json_statistics);
+
+  SendCommandResponse(common_attributes, response_json);
+}
+
 // ---- Response Handling ----
 
-auto MqttMessageHandler::HandleCommandResponse(void* ctx, JsonDocument& command_result) -> void {
-  static_cast<MqttMessageHandler*>(ctx)->SendCommandResponse(command_result);
+auto MqttMessageHandler::HandleCommandResponse(void* ctx, cmd::Command const& cmd, JsonDocument& command_result)
+    -> void {
+  static_cast<MqttMessageHandler*>(ctx)->SendCommandResponse(ToCommonAttributes(cmd), command_result);
+}
+
+auto MqttMessageHandler::HandleErrorResponse(void* ctx, cmd::Command const& cmd, cmd::ErrorCode error_code,
+                                             char const* error_message, char const* request_json) -> void {
+  static_cast<MqttMessageHandler*>(ctx)->SendErrorResponse(ToCommonAttributes(cmd), error_message, request_json,
+                                                           error_code);
+}
+
+auto MqttMessageHandler::GetCommandResultCallback() -> cmd::CommandResultCallback {
+  return cmd::CommandResultCallback{&MqttMessageHandler::HandleCommandResponse, this};
 }
 
-auto MqttMessageHandler::HandleErrorResponse(void* ctx, char const* error_message, char const* request_json) -> void {
-  static_cast<MqttMessageHandler*>(ctx)->SendErrorResponse(error_message, request_json);
+auto MqttMessageHandler::GetErrorResultCallback() -> cmd::ErrorResultCallback {
+  return cmd::ErrorResultCallback{&MqttMessageHandler::HandleErrorResponse, this};
 }
 
-auto MqttMessageHandler::SendCommandResponse(JsonDocument& command_result) -> void {
+auto MqttMessageHandler::SendCommandResponse(CommonAttributes const& common_attributes, JsonDocument& command_result)
+    -> void {
+  cmd::json::JsonBuilder::AddRequestId(command_result, common_attributes.request_id);
   cmd::json::JsonBuilder::AddTimestamp(command_result);
 
-  String command_result_serialized{};
-  serializeJson(command_result, command_result_serialized);
+  PublishStatus(command_result, common_attributes);
+
+  // Results addressed to a reply topic are private to their requester and not shared on the device topics
+  bool const is_shared{common_attributes.reply_to.topic.c_str()[0] == '\0'};
+  if (mqtt_client_->GetDeviceTopicsEnabled() && is_shared &&
+      (command_result[cmd::json::kRootAction] == cmd::json::kActionRead)) {
+    PublishDeviceValues(command_result);
+  }
+}
+
+/*!
+ * Publishes every attribute value of the devices in a read result as retained plain payload on its device topic. The
+ * broker keeps the last value per device attribute, so consumers subscribe to the values they need and late joiners
+ * receive them immediately.
+ */
+auto MqttMessageHandler::PublishDeviceValues(JsonDocument const& command_result) -> void {
+  if (command_result[cmd::json::kDevice].is<JsonObjectConst>()) {
+    PublishDeviceValues(command_result[cmd::json::kDevice].as<JsonObjectConst>());
+  } else if (command_result[cmd::json::kDevices].is<JsonArrayConst>()) {
+    for (JsonVariantConst json_device : command_result[cmd::json::kDevices].as<JsonArrayConst>()) {
+      PublishDeviceValues(json_device.as<JsonObjectConst>());
+    }
+  }
+}
 
-  mqtt_client_->Publish(mqtt_client_->GetTopicStatus(), command_result_serialized.c_str());
+/*!
+ * Numbers and booleans are published as plain text (e.g. '21.5', 'true'), aggregates of windowed subscriptions as
+ * JSON object. Values are serialized on the stack, values exceeding kMaxDeviceValueLength are not published.
+ */
+auto MqttMessageHandler::PublishDeviceValues(JsonObjectConst json_device) -> void {
+  char const* const device_id{json_device[cmd::json::kDeviceId].as<char const*>()};
+
+  if (device_id != nullptr) {
+    for (JsonPairConst json_attribute : json_device) {
+      char const* const attribute{json_attribute.key().c_str()};
+      if ((strcmp(attribute, cmd::json::kDeviceId) != 0) && (strcmp(attribute, cmd::json::kChannel) != 0)) {
+        char value_serialized[kMaxDeviceValueLength + 1];  // +1 for null-termination
+        if (measureJson(json_attribute.value()) <= kMaxDeviceValueLength) {
+          serializeJson(json_attribute.value(), value_serialized, sizeof(value_serialized));
+          mqtt_client_->Publish(mqtt_client_->GetTopicDevice(device_id, attribute).c_str(), value_serialized,
+                                MqttQoS::kQoS0, MqttRetain::kRetain);
+        } else {
+          logger_.Warn(F("[MqttMessageHandler] Value of device %s attribute %s too long for its device topic"),
+                       device_id, attribute);
+        }
+      }
+    }
+  }
 }
 
-auto MqttMessageHandler::SendErrorResponse(char const* error_message, char const* request_json) -> void {
+auto MqttMessageHandler::SendErrorResponse(CommonAttributes const& common_attributes, char const* error_message,
+                                           char const* request_json, cmd::ErrorCode error_code) -> void {
   if (request_json != "") {
     // Try to deserialize the original request json string
-    JsonDocument request_json_deserialized{};
+    JsonDocument request_json_deserialized{&util::json_allocator_g};
     DeserializationError const deserialize_result{deserializeJson(request_json_deserialized, request_json)};
     if (deserialize_result == DeserializationError::Ok) {
-      SendErrorResponse(error_message, &request_json_deserialized);
+      SendErrorResponse(common_attributes, error_message, &request_json_deserialized, error_code);
     } else {
-      SendErrorResponse(error_message, static_cast<JsonDocument*>(nullptr));
+      SendErrorResponse(common_attributes, error_message, static_cast<JsonDocument*>(nullptr), error_code);
     }
   } else {
-    SendErrorResponse(error_message, static_cast<JsonDocument*>(nullptr));
+    SendErrorResponse(common_attributes, error_message, static_cast<JsonDocument*>(nullptr), error_code);
   }
 }
 
-auto MqttMessageHandler::SendErrorResponse(char const* error_message, JsonDocument* request_json) -> void {
-  JsonDocument json{};
+auto MqttMessageHandler::SendErrorResponse(CommonAttributes const& common_attributes, char const* error_message,
+                                           JsonDocument* request_json, cmd::ErrorCode error_code) -> void {
+  JsonDocument json{&util::json_allocator_g};
+  cmd::json::JsonBuilder::AddRequestId(json, common_attributes.request_id);
   JsonObject json_error{json[cmd::json::kRootError].to<JsonObject>()};
   json_error[cmd::json::kErrorMessage] = error_message;
+  if (error_code == cmd::ErrorCode::Busy) {
+    json_error[cmd::json::kErrorCode] = cmd::json::kErrorCodeBusy;
+  } else if (error_code == cmd::ErrorCode::Expired) {
+    json_error[cmd::json::kErrorCode] = cmd::json::kErrorCodeExpired;
+  }
 
   if (request_json != nullptr) {
     json_error[cmd::json::kErrorRequest] = request_json->as<JsonObject>();
@@ -240,25 +425,171 @@ auto MqttMessageHandler::SendErrorResponse(char const* error_message, JsonDocume
 
   cmd::json::JsonBuilder::AddTimestamp(json);
 
-  String error_result_serialized{};
-  serializeJson(json, error_result_serialized);
-  mqtt_client_->Publish(mqtt_client_->GetTopicStatus(), error_result_serialized.c_str());
+  PublishStatus(json, common_attributes);
+}
+
+/*!
+ * Publishes a response on the status topic of the payload format or on the reply topic of the request. With batching
+ * enabled a response on the status topic is appended to the current batch of the format, which is published as a
+ * single array once it holds batch_size responses or its window elapsed (see Loop()). Responses on a reply topic are
+ * not batched.
+ */
+auto MqttMessageHandler::PublishStatus(JsonDocument const& json, CommonAttributes const& common_attributes) -> void {
+  cmd::PayloadFormat const payload_format{common_attributes.payload_format};
+
+  if (common_attributes.reply_to.topic.length() > 0) {
+    PublishSerialized(json, payload_format, common_attributes.reply_to.topic.c_str());
+  } else if (batch_window_ == 0) {
+    PublishSerialized(json, payload_format);
+  } else {
+    bool batch_full{false};
+    {
+      std::lock_guard<std::mutex> lock_guard{batch_mutex_};
+      Batch& batch{batches_[ToUnderlying(payload_format)]};
+      if (batch.json.size() == 0) {
+        batch.json.to<JsonArray>();
+        batch.start_time = time::TimeUtil::TimeSinceStartup();
+      }
+      batch.json.add(json);
+      batch_full = (batch.json.size() >= batch_size_);
+    }
+
+    if (batch_full) {
+      FlushBatch(payload_format);
+    }
+  }
+}
+
+auto MqttMessageHandler::FlushBatches() -> void {
+  FlushBatch(cmd::PayloadFormat::Json);
+  FlushBatch(cmd::PayloadFormat::MsgPack);
+}
+
+/*!
+ * Publishes the current batch of the payload format if it is full or its window elapsed.
+ */
+auto MqttMessageHandler::FlushBatch(cmd::PayloadFormat payload_format) -> void {
+  JsonDocument json{&util::json_allocator_g};
+  {
+    std::lock_guard<std::mutex> lock_guard{batch_mutex_};
+    Batch& batch{batches_[ToUnderlying(payload_format)]};
+    std::size_t const batch_size{batch.json.size()};
+    if ((batch_size > 0) && ((batch_size >= batch_size_) ||
+                             ((time::TimeUtil::TimeSinceStartup() - batch.start_time) >= batch_window_))) {
+      json = std::move(batch.json);
+      batch.json.clear();
+    }
+  }
+
+  if (json.size() > 0) {
+    PublishSerialized(json, payload_format);
+  }
+}
+
+/*!
+ * Serializes the document in the payload format and publishes it. The size is measured first and the document is
+ * written once into the payload, which the MQTT client sends or queues without a copy.
+ * \param[in] topic Topic to publish on. nullptr: status topic of the payload format.
+ */
+auto MqttMessageHandler::PublishSerialized(JsonDocument const& json, cmd::PayloadFormat payload_format,
+                                           char const* topic) -> void {
+  std::vector<std::uint8_t> payload{};
+
+  if (payload_format == cmd::PayloadFormat::MsgPack) {
+    topic = topic != nullptr ? topic : mqtt_client_->GetTopicStatusMsgPack();
+    payload.resize(measureMsgPack(json));
+    serializeMsgPack(json, payload.data(), payload.size());
+  } else {
+    topic = topic != nullptr ? topic : mqtt_client_->GetTopicStatus();
+    payload.resize(measureJson(json));
+    serializeJson(json, payload.data(), payload.size());  // Exact size: no null terminator
+  }
+
+  mqtt_client_->Publish(topic, std::move(payload));
 }
 
 // ---- Utilities ----
 
-auto MqttMessageHandler::InitEmptyCommand(cmd::Action const action) -> cmd::Command {
+auto MqttMessageHandler::InitEmptyCommand(cmd::Action const action, CommonAttributes const& common_attributes)
+    -> cmd::Command {
+  std::uint32_t const request_id_value{common_attributes.request_id.type == cmd::RequestIdType::String
+                                           ? common_attributes.request_id_attachment
+                                           : common_attributes.request_id.number};
+
   return cmd::Command{// Timer (no delay)
                       cmd::Timer{},
-                      // Action and Sub-Action
-                      action, cmd::SubAction::None,
+                      // Deadline
+                      common_attributes.deadline,
+                      // Result Timer (no delay)
+                      cmd::Timer{},
                       // Parameters
-                      cmd::CommandParam{false}, cmd::CommandParam{false}, cmd::CommandParam{false},
-                      cmd::CommandParam{false},
+                      cmd::CommandParams{},
                       // Result Callback
-                      cmd::CommandResultCallback{&MqttMessageHandler::HandleCommandResponse, this},
+                      GetCommandResultCallback(),
                       // Error Result Callback
-                      cmd::ErrorResultCallback{&MqttMessageHandler::HandleErrorResponse, this}};
+                      GetErrorResultCallback(),
+                      // Request Id (number or attachment of the string)
+                      cmd::CommandRequestId{common_attributes.request_id.type, request_id_value},
+                      // Action and Sub-Action
+                      action, cmd::SubAction::None,
+                      // Priority
+                      cmd::CommandPriority::Interactive,
+                      // Payload Format of the Responses
+                      common_attributes.payload_format,
+                      // Topic of the Responses
+                      common_attributes.reply_to_attachment,
+                      // Subscription Options (set by subscribes)
+                      cmd::kNoAttachment};
+}
+
+auto MqttMessageHandler::ToCommonAttributes(cmd::Command const& cmd) -> CommonAttributes {
+  cmd::AttachmentHandle const request_id_attachment{cmd.request_id.type == cmd::RequestIdType::String
+                                                        ? static_cast<cmd::AttachmentHandle>(cmd.request_id.value)
+                                                        : cmd::kNoAttachment};
+
+  cmd::RequestId request_id{cmd.request_id.type, 0, cmd::RequestId::StringType{}};
+  if (cmd.request_id.type == cmd::RequestIdType::Number) {
+    request_id.number = cmd.request_id.value;
+  } else if (cmd.request_id.type == cmd::RequestIdType::String) {
+    request_id.string = cmd::RequestId::StringType{cmd::command_attachments_g.GetText(request_id_attachment)};
+  }
+
+  return CommonAttributes{request_id,
+                          cmd.deadline,
+                          cmd.payload_format,
+                          cmd::ReplyTo{cmd::ReplyTo::StringType{cmd::command_attachments_g.GetText(cmd.reply_to)}},
+                          request_id_attachment,
+                          cmd.reply_to};
+}
+
+/*!
+ * Interns the string request id and the reply topic, so the commands of the request can reference them.
+ * \return False if the attachments are exhausted. No reference is held then.
+ */
+auto MqttMessageHandler::AddAttachments(CommonAttributes& common_attributes) -> bool {
+  bool result{true};
+
+  if (common_attributes.request_id.type == cmd::RequestIdType::String) {
+    result = cmd::command_attachments_g.AddText(common_attributes.request_id.string.c_str(),
+                                                common_attributes.request_id_attachment);
+  }
+  if (result) {
+    result = cmd::command_attachments_g.AddText(common_attributes.reply_to.topic.c_str(),
+                                                common_attributes.reply_to_attachment);
+  }
+
+  if (not result) {
+    ReleaseAttachments(common_attributes);
+    common_attributes.request_id_attachment = cmd::kNoAttachment;
+    common_attributes.reply_to_attachment = cmd::kNoAttachment;
+  }
+
+  return result;
+}
+
+auto MqttMessageHandler::ReleaseAttachments(CommonAttributes const& common_attributes) -> void {
+  cmd::command_attachments_g.Release(common_attributes.request_id_attachment);
+  cmd::command_attachments_g.Release(common_attributes.reply_to_attachment);
 }
 
 // ---- Global Instance ----
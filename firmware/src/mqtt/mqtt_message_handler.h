@@ -4,9 +4,13 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 
+#include <array>
+#include <mutex>
+
 #include "cmd/command_handler.h"
 #include "logging/logger.h"
 #include "mqtt/mqtt_client.h"
+#include "time/time_util.h"
 
 namespace owif {
 namespace mqtt {
@@ -26,27 +30,76 @@ class MqttMessageHandler {
   auto Begin(MqttClient* mqtt_client, cmd::CommandHandler* command_handler) -> bool;
   auto Loop() -> void;
 
-  static auto HandleCommandResponse(void* ctx, JsonDocument& command_result) -> void;
-  static auto HandleErrorResponse(void* ctx, char const* error_message, char const* request_json) -> void;
-
- private:
-  auto ProcessMessage(String topic, String payload, MqttMsgProps props) -> void;
-
-  auto ProcessActionRestart(JsonDocument json) -> void;
-  auto ProcessActionScan(JsonDocument json) -> void;
-  auto ProcessActionRead(JsonDocument json) -> void;
-  auto ProcessActionSubscribe(JsonDocument json) -> void;
-  auto ProcessActionUnsubscribe(JsonDocument json) -> void;
+  static auto HandleCommandResponse(void* ctx, cmd::Command const& cmd, JsonDocument& command_result) -> void;
+  static auto HandleErrorResponse(void* ctx, cmd::Command const& cmd, cmd::ErrorCode error_code,
+                                  char const* error_message, char const* request_json) -> void;
 
-  auto SendCommandResponse(JsonDocument& command_result) -> void;
-  auto SendErrorResponse(char const* error_message, char const* request_json = "") -> void;
-  auto SendErrorResponse(char const* error_message, JsonDocument* request_json) -> void;
+  auto GetCommandResultCallback() -> cmd::CommandResultCallback;
+  auto GetErrorResultCallback() -> cmd::ErrorResultCallback;
 
-  auto InitEmptyCommand(cmd::Action action) -> cmd::Command;
+ private:
+  /*!
+   * \brief Optional attributes common to all commands. The commands reference the strings as attachments.
+   */
+  struct CommonAttributes {
+    cmd::RequestId request_id;
+    cmd::Timer deadline;
+    cmd::PayloadFormat payload_format;            // Format of the request and its responses
+    cmd::ReplyTo reply_to;                        // Topic of the responses. Empty: status topic
+    cmd::AttachmentHandle request_id_attachment;  // String request id interned for the commands
+    cmd::AttachmentHandle reply_to_attachment;    // Reply topic interned for the commands
+  };
+
+  /*!
+   * \brief Responses collected for a single publishing.
+   */
+  struct Batch {
+    JsonDocument json;             // Array of the collected responses
+    time::TimeStampMs start_time;  // Time of the first response
+  };
+
+  // Number of payload formats (see cmd::PayloadFormat)
+  static constexpr std::size_t kPayloadFormats{2};
+  // Max. length of a serialized device topic value, e.g. the aggregates of a window
+  static constexpr std::size_t kMaxDeviceValueLength{128};
+
+  auto ProcessMessage(char const* topic, char const* payload, std::size_t length, MqttMsgProps props,
+                      cmd::PayloadFormat payload_format) -> void;
+
+  auto ProcessActionRestart(JsonDocument const& json, CommonAttributes const& common_attributes) -> void;
+  auto ProcessActionScan(JsonDocument const& json, CommonAttributes const& common_attributes) -> void;
+  auto ProcessActionRead(JsonDocument const& json, CommonAttributes const& common_attributes) -> void;
+  auto ProcessActionSubscribe(JsonDocument const& json, CommonAttributes const& common_attributes) -> void;
+  auto ProcessActionUnsubscribe(JsonDocument const& json, CommonAttributes const& common_attributes) -> void;
+  auto ProcessActionStatistics(JsonDocument const& json, CommonAttributes const& common_attributes) -> void;
+
+  auto SendCommandResponse(CommonAttributes const& common_attributes, JsonDocument& command_result) -> void;
+  auto PublishDeviceValues(JsonDocument const& command_result) -> void;
+  auto PublishDeviceValues(JsonObjectConst json_device) -> void;
+  auto PublishStatus(JsonDocument const& json, CommonAttributes const& common_attributes) -> void;
+  auto FlushBatches() -> void;
+  auto FlushBatch(cmd::PayloadFormat payload_format) -> void;
+  auto PublishSerialized(JsonDocument const& json, cmd::PayloadFormat payload_format, char const* topic = nullptr)
+      -> void;
+  auto SendErrorResponse(CommonAttributes const& common_attributes, char const* error_message,
+                         char const* request_json = "", cmd::ErrorCode error_code = cmd::ErrorCode::Generic) -> void;
+  auto SendErrorResponse(CommonAttributes const& common_attributes, char const* error_message,
+                         JsonDocument* request_json, cmd::ErrorCode error_code = cmd::ErrorCode::Generic) -> void;
+
+  auto InitEmptyCommand(cmd::Action action, CommonAttributes const& common_attributes) -> cmd::Command;
+  static auto ToCommonAttributes(cmd::Command const& cmd) -> CommonAttributes;
+  static auto AddAttachments(CommonAttributes& common_attributes) -> bool;
+  static auto ReleaseAttachments(CommonAttributes const& common_attributes) -> void;
   logging::Logger& logger_{logging::logger_g};
 
   MqttClient* mqtt_client_;
   cmd::CommandHandler* command_handler_;
+
+  // Outbound batching of the responses on the status topic. Responses are sent from the MQTT task and the main loop.
+  std::uint32_t batch_window_{0};  // ms. 0: batching disabled
+  std::uint16_t batch_size_{0};    // Max. number of responses per batch
+  std::mutex batch_mutex_{};
+  std::array<Batch, kPayloadFormats> batches_{};  // Current batch per payload format
 };
 
 extern MqttMessageHandler mqtt_msg_handler_g;
@@ -0,0 +1,234 @@
+// ---- Includes ----
+#include "mqtt/offline_store.h"
+
+#include <LittleFS.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <utility>
+
+#include "util/language.h"
+
+namespace owif {
+namespace mqtt {
+
+// ---- Public APIs ----------------------------------------------------------------------------------------------------
+
+/*!
+ * \param capacity Max. number of messages in RAM. 0 disables the store.
+ * \param spill Spill messages exceeding the capacity to the log on LittleFS.
+ */
+auto OfflineStore::Begin(std::uint16_t capacity, bool spill) -> bool {
+  ring_.clear();
+  ring_.resize(capacity);
+  head_ = 0;
+  count_ = 0;
+  spill_ = false;
+
+  if (spill && capacity > 0) {
+    if (LittleFS.begin()) {
+      spill_ = true;
+      RestoreLog();
+    } else {
+      logger_.Error(F("[OfflineStore] LittleFS setup failed. Spilling disabled."));
+    }
+  }
+
+  return true;
+}
+
+auto OfflineStore::IsEnabled() const -> bool { return not ring_.empty(); }
+
+auto OfflineStore::IsEmpty() const -> bool { return count_ == 0 && log_count_ == 0; }
+
+/*!
+ * Append a message. If the ring buffer is full, its oldest message is spilled to the log or dropped.
+ */
+auto OfflineStore::Push(OutboundMessage&& message) -> void {
+  if (ring_.empty()) {
+    ++dropped_;
+    return;
+  }
+
+  std::uint16_t const capacity{static_cast<std::uint16_t>(ring_.size())};
+  if (count_ == capacity) {
+    OutboundMessage& oldest{ring_[head_]};
+    if (not(spill_ && Spill(oldest))) {
+      ++dropped_;
+    }
+    head_ = (head_ + 1) % capacity;
+    --count_;
+  }
+
+  ring_[(head_ + count_) % capacity] = std::move(message);
+  ++count_;
+}
+
+/*!
+ * \return Oldest message or nullptr if the store is empty. Valid until the next call of Push() or Pop(). May be
+ *         moved out before calling Pop().
+ */
+auto OfflineStore::Front() -> OutboundMessage* {
+  OutboundMessage* result{nullptr};
+
+  if (log_count_ > 0) {
+    if (log_front_size_ == 0 && not ReadLogRecord(log_read_offset_, log_front_, log_front_size_)) {
+      logger_.Error(F("[OfflineStore] Corrupted log. Dropping %u messages."), log_count_);
+      dropped_ += log_count_;
+      ClearLog();
+    }
+  }
+
+  if (log_count_ > 0) {
+    result = &log_front_;
+  } else if (count_ > 0) {
+    result = &ring_[head_];
+  }
+
+  return result;
+}
+
+/*!
+ * Remove the message returned by Front().
+ */
+auto OfflineStore::Pop() -> void {
+  if (log_count_ > 0) {
+    log_read_offset_ += log_front_size_;
+    log_front_size_ = 0;
+    log_front_ = OutboundMessage{};
+    --log_count_;
+    if (log_count_ == 0) {
+      ClearLog();
+    }
+  } else if (count_ > 0) {
+    ring_[head_] = OutboundMessage{};  // Release the memory of the message
+    head_ = (head_ + 1) % ring_.size();
+    --count_;
+  }
+}
+
+auto OfflineStore::GetStatistics() const -> OfflineStoreStatistics {
+  return OfflineStoreStatistics{count_ + log_count_, static_cast<std::uint16_t>(ring_.size()), log_count_, dropped_};
+}
+
+// ---- Private APIs ---------------------------------------------------------------------------------------------------
+
+/*!
+ * Append a message to the log. Fails if the log would exceed its max. size, the file cannot be opened or the record
+ * cannot be written completely, e.g. as the flash is full. A partially written record is truncated, so the records
+ * spilled before stay readable. If the truncation fails as well, spilling is disabled: The records before the partial
+ * record are still replayed, as the log is read up to the number of records only.
+ */
+auto OfflineStore::Spill(OutboundMessage const& message) -> bool {
+  LogRecordHeader const header{kLogRecordMagic, ToUnderlying(message.qos), ToUnderlying(message.retain),
+                               static_cast<std::uint16_t>(message.topic.length()),
+                               static_cast<std::uint32_t>(message.payload.size())};
+  std::size_t const record_size{sizeof(header) + header.topic_length + header.payload_length};
+  if (log_size_ + record_size > kMaxLogSize) {
+    return false;
+  }
+
+  File file{LittleFS.open(kLogPath, FILE_APPEND)};
+  if (not file) {
+    logger_.Error(F("[OfflineStore] Failed to open '%s'"), kLogPath);
+    return false;
+  }
+
+  std::size_t written{file.write(reinterpret_cast<std::uint8_t const*>(&header), sizeof(header))};
+  written += file.write(reinterpret_cast<std::uint8_t const*>(message.topic.c_str()), header.topic_length);
+  written += file.write(message.payload.data(), header.payload_length);
+  file.close();
+
+  bool result{true};
+  if (written == record_size) {
+    log_size_ += written;
+    ++log_count_;
+  } else {
+    logger_.Error(F("[OfflineStore] Failed to write '%s' (%u of %u bytes)"), kLogPath, written, record_size);
+    if (::truncate((String{kMountPath} + kLogPath).c_str(), static_cast<off_t>(log_size_)) != 0) {
+      logger_.Error(F("[OfflineStore] Failed to truncate '%s'. Spilling disabled."), kLogPath);
+      spill_ = false;
+    }
+    result = false;
+  }
+
+  return result;
+}
+
+auto OfflineStore::ReadLogRecord(std::size_t offset, OutboundMessage& message, std::size_t& record_size) -> bool {
+  File file{LittleFS.open(kLogPath, FILE_READ)};
+  if (not file || not file.seek(offset)) {
+    return false;
+  }
+
+  bool result{false};
+
+  LogRecordHeader header{};
+  if (file.read(reinterpret_cast<std::uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+      header.magic == kLogRecordMagic) {
+    std::vector<char> topic(header.topic_length + 1, '\0');
+    message.payload.resize(header.payload_length);
+    if (file.read(reinterpret_cast<std::uint8_t*>(topic.data()), header.topic_length) == header.topic_length &&
+        file.read(message.payload.data(), header.payload_length) == header.payload_length) {
+      message.topic = String{topic.data()};
+      message.qos = static_cast<MqttQoS>(header.qos);
+      message.retain = static_cast<MqttRetain>(header.retain);
+      record_size = sizeof(header) + header.topic_length + header.payload_length;
+      result = true;
+    }
+  }
+  file.close();
+
+  return result;
+}
+
+/*!
+ * Count the records of a log left over from before a restart. A log with a corrupted record is discarded.
+ */
+auto OfflineStore::RestoreLog() -> void {
+  log_size_ = 0;
+  log_read_offset_ = 0;
+  log_count_ = 0;
+  log_front_size_ = 0;
+
+  if (not LittleFS.exists(kLogPath)) {
+    return;
+  }
+
+  File file{LittleFS.open(kLogPath, FILE_READ)};
+  std::size_t const file_size{file ? file.size() : 0};
+
+  std::size_t offset{0};
+  std::uint32_t count{0};
+  LogRecordHeader header{};
+  while (offset + sizeof(header) <= file_size && file.seek(offset) &&
+         file.read(reinterpret_cast<std::uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+         header.magic == kLogRecordMagic) {
+    offset += sizeof(header) + header.topic_length + header.payload_length;
+    ++count;
+  }
+  if (file) {
+    file.close();
+  }
+
+  if (offset == file_size && count > 0) {
+    log_size_ = file_size;
+    log_count_ = count;
+    logger_.Info(F("[OfflineStore] Restored %u messages from '%s'"), count, kLogPath);
+  } else {
+    logger_.Warn(F("[OfflineStore] Discarding corrupted or empty log '%s'"), kLogPath);
+    ClearLog();
+  }
+}
+
+auto OfflineStore::ClearLog() -> void {
+  LittleFS.remove(kLogPath);
+  log_size_ = 0;
+  log_read_offset_ = 0;
+  log_count_ = 0;
+  log_front_ = OutboundMessage{};
+  log_front_size_ = 0;
+}
+
+}  // namespace mqtt
+}  // namespace owif
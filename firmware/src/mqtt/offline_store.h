@@ -0,0 +1,104 @@
+#ifndef OWIF_MQTT_OFFLINE_STORE_H
+#define OWIF_MQTT_OFFLINE_STORE_H
+
+// ---- Includes ----
+
+#include <Arduino.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "logging/logger.h"
+#include "mqtt/qos.h"
+
+namespace owif {
+namespace mqtt {
+
+/*!
+ * \brief Serialized message which could not be published yet.
+ */
+struct OutboundMessage {
+  String topic;
+  std::vector<std::uint8_t> payload;
+  MqttQoS qos;
+  MqttRetain retain;
+};
+
+/*!
+ * \brief Statistics of the offline store.
+ */
+struct OfflineStoreStatistics {
+  std::uint32_t size;      // Number of stored messages (RAM and log)
+  std::uint16_t capacity;  // Max. number of messages in RAM
+  std::uint32_t spilled;   // Number of stored messages in the log
+  std::uint32_t dropped;   // Number of messages dropped due to a full store
+};
+
+/*!
+ * \brief Keeps messages published while the MQTT connection is down, oldest first. The messages are held in a RAM ring
+ *        buffer. If spilling is enabled, the oldest message of a full ring buffer is appended to a log file on
+ *        LittleFS instead of being dropped. The log always holds older messages than the ring buffer, so it is
+ *        drained first. The log survives a restart.
+ *        Not thread-safe. The owner serializes all calls.
+ */
+class OfflineStore final {
+ public:
+  OfflineStore() = default;
+
+  OfflineStore(OfflineStore const&) = delete;
+  auto operator=(OfflineStore const&) -> OfflineStore& = delete;
+  OfflineStore(OfflineStore&&) = delete;
+  auto operator=(OfflineStore&&) -> OfflineStore& = delete;
+
+  // ---- Public APIs --------------------------------------------------------------------------------------------------
+
+  auto Begin(std::uint16_t capacity, bool spill) -> bool;
+
+  auto IsEnabled() const -> bool;
+  auto IsEmpty() const -> bool;
+
+  auto Push(OutboundMessage&& message) -> void;
+  auto Front() -> OutboundMessage*;
+  auto Pop() -> void;
+
+  auto GetStatistics() const -> OfflineStoreStatistics;
+
+ private:
+  static constexpr char const* kMountPath{"/littlefs"};  // Default base path of LittleFS.begin()
+  static constexpr char const* kLogPath{"/offline.log"};
+  static constexpr std::size_t kMaxLogSize{256 * 1024};  // bytes
+  static constexpr std::uint8_t kLogRecordMagic{0xA5};
+
+  struct LogRecordHeader {
+    std::uint8_t magic;
+    std::uint8_t qos;
+    std::uint8_t retain;
+    std::uint16_t topic_length;
+    std::uint32_t payload_length;
+  };
+
+  auto Spill(OutboundMessage const& message) -> bool;
+  auto ReadLogRecord(std::size_t offset, OutboundMessage& message, std::size_t& record_size) -> bool;
+  auto RestoreLog() -> void;
+  auto ClearLog() -> void;
+
+  logging::Logger& logger_{logging::logger_g};
+
+  std::vector<OutboundMessage> ring_{};  // RAM ring buffer
+  std::uint16_t head_{0};                // Slot of the oldest message in the ring buffer
+  std::uint16_t count_{0};               // Number of messages in the ring buffer
+
+  bool spill_{false};
+  std::size_t log_size_{0};         // Size of the log file [bytes]
+  std::size_t log_read_offset_{0};  // Offset of the oldest unsent record in the log
+  std::uint32_t log_count_{0};      // Number of unsent records in the log
+  OutboundMessage log_front_{};     // Cached oldest record of the log
+  std::size_t log_front_size_{0};   // Size of the cached record. 0: not cached.
+
+  std::uint32_t dropped_{0};
+};
+
+}  // namespace mqtt
+}  // namespace owif
+
+#endif  // OWIF_MQTT_OFFLINE_STORE_H
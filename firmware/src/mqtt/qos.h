@@ -0,0 +1,25 @@
+#ifndef OWIF_MQTT_QOS_H
+#define OWIF_MQTT_QOS_H
+
+#include <cstdint>
+
+namespace owif {
+namespace mqtt {
+
+enum class MqttQoS : std::uint8_t {
+  kQoS0 = 0,  // At most once:  QoS 0 offers "fire and forget" messaging with no acknowledgment from the receiver.
+  kQoS1 = 1,  // At least once: QoS 1 ensures that messages are delivered at least once by requiring a PUBACK
+              // acknowledgment.
+  kQoS2 = 2   // Exactly once: QoS 2 guarantees that each message is delivered exactly once by using a four-step
+              // handshake (PUBLISH, PUBREC, PUBREL, PUBCOMP).
+};
+
+enum class MqttRetain : std::uint8_t {
+  kNoRetain = 0,  // Do not retain the message.
+  kRetain = 1     // Broker stores last retained message. New subscribers will immediately get the retained message.
+};
+
+}  // namespace mqtt
+}  // namespace owif
+
+#endif  // OWIF_MQTT_QOS_H
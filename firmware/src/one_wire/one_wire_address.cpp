@@ -5,6 +5,8 @@
 #include <stdint.h>
 
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <string>
 
@@ -18,12 +20,29 @@ namespace owif {
 namespace one_wire {
 
 auto OneWireAddress::FromOwfsFormat(String const& address) -> std::unique_ptr<OneWireAddress> {
+  OneWireAddress parsed_address{};
+  if (FromOwfsFormat(address.c_str(), parsed_address)) {
+    return std::make_unique<OneWireAddress>(parsed_address);
+  } else {
+    logging::logger_g.Error(F("[OneWireAddress] Failed to parse 1-Wire address '%s'"), address.c_str());
+    return std::unique_ptr<OneWireAddress>{nullptr};
+  }
+}
+
+/*!
+ * Parses without allocating, e.g. the device_id of every device of a cyclic read result.
+ * \param[out] ow_address Parsed address. Unchanged if the address can not be parsed.
+ * \return False if the address has not the OWFS format
+ */
+auto OneWireAddress::FromOwfsFormat(char const* address, OneWireAddress& ow_address) -> bool {
+  bool result{false};
+
   // no CRC, but with separation '.' -> 16 - 2 + 1 = 15
-  if (address.length() == 15) {
+  if ((address != nullptr) && (std::strlen(address) == kFormattedLength)) {
     char hex[16];  // max. length: 15 characters + null termination
     std::uint8_t pos{0};
 
-    for (std::size_t i{0}; i < address.length() && pos < 16; i++) {
+    for (std::size_t i{0}; address[i] != '\0' && pos < 16; i++) {
       // Skip '.' in formatted address OWFS (e.g. "28.8F0945161302")
       if (address[i] != '.') {
         hex[pos++] = address[i];
@@ -31,18 +50,16 @@ auto OneWireAddress::FromOwfsFormat(String const& address) -> std::unique_ptr<On
     }
     hex[pos] = '\0';  // add null-termination
 
-    std::uint64_t parsed_address{std::stoull(hex, nullptr, 16)};
+    std::uint64_t parsed_address{std::strtoull(hex, nullptr, 16)};
     parsed_address = __builtin_bswap64(parsed_address);
 
     // Calc CRC missing in the input string format.
     std::uint8_t const crc{util::crc8(reinterpret_cast<std::uint8_t*>(&parsed_address) + 1, 7)};
-    parsed_address = (parsed_address >> 8) | (static_cast<std::uint64_t>(crc) << 56);
-
-    return std::make_unique<OneWireAddress>(parsed_address);
-  } else {
-    logging::logger_g.Error(F("[OneWireAddress] Failed to parse 1-Wire address '%s'"), address.c_str());
-    return std::unique_ptr<OneWireAddress>{nullptr};
+    ow_address.address_ = (parsed_address >> 8) | (static_cast<std::uint64_t>(crc) << 56);
+    result = true;
   }
+
+  return result;
 }
 
 OneWireAddress::OneWireAddress(std::uint64_t addr) : address_{addr} {}
@@ -62,8 +79,16 @@ auto OneWireAddress::GetCrc() const -> std::uint8_t { return static_cast<std::ui
  */
 
 auto OneWireAddress::Format() const -> String {
-  String buffer{"00.000000000000"};  // 16 Hex-Characters + '.'
+  char buffer[kFormattedLength + 1];
+  return String{Format(buffer)};
+}
 
+/*!
+ * Formats without allocating.
+ * \param[out] buffer Receives the formatted address. Min. size: kFormattedLength + 1
+ * \return buffer
+ */
+auto OneWireAddress::Format(char* buffer) const -> char const* {
   uint8_t const* ptr = reinterpret_cast<const uint8_t*>(&address_);
 
   std::uint8_t pos{0};
@@ -3,6 +3,7 @@
 
 #include <WString.h>
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 
@@ -16,7 +17,10 @@ class OneWireAddress {
  public:
   using FamilyCode = std::uint8_t;
 
+  static constexpr std::size_t kFormattedLength{15};  // OWFS format without CRC, e.g. '28.8F0945161302'
+
   static auto FromOwfsFormat(String const& address) -> std::unique_ptr<OneWireAddress>;
+  static auto FromOwfsFormat(char const* address, OneWireAddress& ow_address) -> bool;
 
   OneWireAddress() = default;
   explicit OneWireAddress(std::uint64_t addr);
@@ -30,6 +34,7 @@ class OneWireAddress {
   auto GetFamilyCode() const -> FamilyCode;
   auto GetCrc() const -> std::uint8_t;
   auto Format() const -> String;
+  auto Format(char* buffer) const -> char const*;
 
   auto operator==(OneWireAddress const& other) const -> bool;
   auto operator==(std::uint64_t const& other) const -> bool;
@@ -88,22 +88,39 @@ auto OneWireSystem::Begin(config::OneWireConfig const& config) -> bool {
 auto OneWireSystem::Loop() -> void {  // Nothing to be done
 }
 
-auto OneWireSystem::Scan() -> bool {
+/*!
+ * Search all 1-wire buses and update the available devices. The changes are kept until taken by
+ * TakePresenceChanges().
+ */
+auto OneWireSystem::Scan() -> bool { return Scan(presence_changes_); }
+
+/*!
+ * Search all 1-wire buses and update the available devices.
+ * Known devices of a bus whose search failed are kept, so a bus error is not reported as departure of its devices.
+ * \param[out] changes Devices arrived or departed since the previous search
+ */
+auto OneWireSystem::Scan(PresenceChanges& changes) -> bool {
   bool result{true};
 
+  changes.clear();
+
   // ---- Search available devices on all 1-wire buses ----
   std::vector<OwAddrBus> available_addresses{0};
   available_addresses.reserve(ow_available_devices_.size());
+  std::vector<OneWireBus::BusId> failed_buses{};
 
   for (one_wire::Ds2484OneWireBus& ow_bus : ow_buses_) {
-    result &= ow_bus.Search();
+    bool const bus_result{ow_bus.Search()};
+    result &= bus_result;
 
-    if (result) {
+    if (bus_result) {
       std::vector<OneWireAddress> const& bus_available_addresses{ow_bus.GetDevices()};
       for (OneWireAddress const& addr : bus_available_addresses) {
         OneWireBus* b{&ow_bus};
         available_addresses.push_back(OwAddrBus{addr, b});
       }
+    } else {
+      failed_buses.push_back(ow_bus.GetId());
     }
   }
 
@@ -112,10 +129,14 @@ auto OneWireSystem::Scan() -> bool {
   // Remove missing devices
   for (DeviceMap::iterator available_device{ow_available_devices_.begin()};
        available_device != ow_available_devices_.end();) {
-    if (std::find_if(available_addresses.begin(), available_addresses.end(),
-                     [&available_device](OwAddrBus& available_addr) {
-                       return available_addr.addr == available_device->first;
-                     }) == available_addresses.end()) {
+    bool const bus_failed{available_device->second &&
+                          (std::find(failed_buses.begin(), failed_buses.end(),
+                                     available_device->second->GetBusId()) != failed_buses.end())};
+    if ((not bus_failed) && (std::find_if(available_addresses.begin(), available_addresses.end(),
+                                          [&available_device](OwAddrBus& available_addr) {
+                                            return available_addr.addr == available_device->first;
+                                          }) == available_addresses.end())) {
+      changes.push_back(PresenceChange{available_device->first, 0, false});
       available_device = ow_available_devices_.erase(available_device);
     } else {
       ++available_device;
@@ -126,6 +147,7 @@ auto OneWireSystem::Scan() -> bool {
   for (OwAddrBus const& addr_bus : available_addresses) {
     if (ow_available_devices_.find(addr_bus.addr) == ow_available_devices_.end()) {
       ow_available_devices_[addr_bus.addr] = CreateDevice(*(addr_bus.bus), addr_bus.addr);
+      changes.push_back(PresenceChange{addr_bus.addr, addr_bus.bus->GetId(), true});
     }
   }
 
@@ -216,6 +238,15 @@ auto OneWireSystem::Scan(OneWireAddress::FamilyCode const family_code) -> bool {
   return result;
 }
 
+/*!
+ * \return Devices arrived or departed in the last search of all buses by Scan(). Empty if taken before.
+ */
+auto OneWireSystem::TakePresenceChanges() -> PresenceChanges {
+  PresenceChanges changes{};
+  changes.swap(presence_changes_);
+  return changes;
+}
+
 auto OneWireSystem::GetAvailableDevices() -> DeviceMap& { return ow_available_devices_; }
 
 auto OneWireSystem::GetAvailableDevices(OneWireAddress::FamilyCode family_code) -> DeviceMap {
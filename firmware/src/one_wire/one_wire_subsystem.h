@@ -23,6 +23,16 @@ class OneWireSystem {
   using DeviceMap = std::map<OneWireAddress, std::shared_ptr<OneWireDevice>>;
   using DeviceAttributesList = std::vector<String>;
 
+  /*!
+   * \brief Arrival or departure of a device detected by a full bus search.
+   */
+  struct PresenceChange {
+    OneWireAddress address;
+    OneWireBus::BusId bus_id;  // Channel of an arrived device. 0 for departed devices.
+    bool is_present;           // true: device arrived, false: device departed
+  };
+  using PresenceChanges = std::vector<PresenceChange>;
+
   OneWireSystem();
 
   // ---- Public APIs --------------------------------------------------------------------------------------------------
@@ -31,8 +41,10 @@ class OneWireSystem {
   auto Loop() -> void;
 
   auto Scan() -> bool;
+  auto Scan(PresenceChanges& changes) -> bool;
   auto Scan(OneWireAddress const& address, bool& is_present, OneWireBus::BusId& bus_id) -> bool;
   auto Scan(OneWireAddress::FamilyCode family_code) -> bool;
+  auto TakePresenceChanges() -> PresenceChanges;
 
   auto GetAvailableDevice(OneWireAddress const& address) -> std::shared_ptr<OneWireDevice>;
   auto GetAvailableDevices() -> DeviceMap&;
@@ -86,6 +98,7 @@ class OneWireSystem {
   std::vector<one_wire::Ds2484OneWireBus> ow_buses_;
 
   DeviceMap ow_available_devices_{};
+  PresenceChanges presence_changes_{};  // Changes of the last search of all buses, until taken
 };
 
 /*!
@@ -0,0 +1,131 @@
+// ---- Includes ----
+#include "util/json_allocator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace owif {
+namespace util {
+
+constexpr std::array<std::size_t, JsonPoolAllocator::kSizeClasses> JsonPoolAllocator::kBlockSizes;
+constexpr std::array<std::size_t, JsonPoolAllocator::kSizeClasses> JsonPoolAllocator::kBlockCounts;
+
+JsonPoolAllocator::JsonPoolAllocator() {
+  std::uint8_t* block{arena_.data()};
+  for (std::size_t size_class{0}; size_class < kSizeClasses; ++size_class) {
+    class_begin_[size_class] = block;
+    FreeBlock* free_list{nullptr};
+    for (std::size_t i{0}; i < kBlockCounts[size_class]; ++i) {
+      FreeBlock* const free_block{reinterpret_cast<FreeBlock*>(block + i * kBlockSizes[size_class])};
+      free_block->next = free_list;
+      free_list = free_block;
+    }
+    free_lists_[size_class] = free_list;
+    block += kBlockCounts[size_class] * kBlockSizes[size_class];
+  }
+}
+
+// ---- Public APIs ----------------------------------------------------------------------------------------------------
+
+auto JsonPoolAllocator::allocate(std::size_t size) -> void* {
+  std::lock_guard<std::mutex> lock_guard{mutex_};
+  return Allocate(size);
+}
+
+auto JsonPoolAllocator::deallocate(void* ptr) -> void {
+  std::lock_guard<std::mutex> lock_guard{mutex_};
+  Deallocate(ptr);
+}
+
+/*!
+ * Keeps the block if the new size still fits, e.g. when ArduinoJson shrinks a string or a variant pool. Heap blocks
+ * stay on the heap.
+ */
+auto JsonPoolAllocator::reallocate(void* ptr, std::size_t new_size) -> void* {
+  std::lock_guard<std::mutex> lock_guard{mutex_};
+
+  if (ptr == nullptr) {
+    return Allocate(new_size);
+  }
+
+  std::size_t const size_class{FindSizeClass(ptr)};
+  if (size_class == kSizeClasses) {
+    return std::realloc(ptr, new_size);
+  }
+
+  std::size_t const block_size{kBlockSizes[size_class]};
+  if (new_size <= block_size) {
+    return ptr;
+  }
+
+  void* const block{Allocate(new_size)};
+  if (block != nullptr) {
+    std::memcpy(block, ptr, std::min(block_size, new_size));
+    Deallocate(ptr);
+  }
+  return block;
+}
+
+auto JsonPoolAllocator::GetStatistics() -> JsonPoolStatistics {
+  std::lock_guard<std::mutex> lock_guard{mutex_};
+  return JsonPoolStatistics{used_, static_cast<std::uint32_t>(kArenaSize), high_water_mark_, fallbacks_};
+}
+
+// ---- Private APIs ---------------------------------------------------------------------------------------------------
+
+/*!
+ * Take a free block of the smallest size class fitting the size. Falls back to the heap if the size exceeds the
+ * largest block or all fitting size classes are exhausted. Must be called with the mutex held.
+ */
+auto JsonPoolAllocator::Allocate(std::size_t size) -> void* {
+  for (std::size_t size_class{0}; size_class < kSizeClasses; ++size_class) {
+    FreeBlock* const free_block{free_lists_[size_class]};
+    if (size <= kBlockSizes[size_class] && free_block != nullptr) {
+      free_lists_[size_class] = free_block->next;
+      used_ += kBlockSizes[size_class];
+      high_water_mark_ = std::max(high_water_mark_, used_);
+      return free_block;
+    }
+  }
+
+  ++fallbacks_;
+  return std::malloc(size);
+}
+
+/*!
+ * Must be called with the mutex held.
+ */
+auto JsonPoolAllocator::Deallocate(void* ptr) -> void {
+  std::size_t const size_class{FindSizeClass(ptr)};
+  if (size_class == kSizeClasses) {
+    std::free(ptr);
+  } else {
+    FreeBlock* const free_block{static_cast<FreeBlock*>(ptr)};
+    free_block->next = free_lists_[size_class];
+    free_lists_[size_class] = free_block;
+    used_ -= kBlockSizes[size_class];
+  }
+}
+
+/*!
+ * \return Size class of an arena block or kSizeClasses for heap blocks (and nullptr).
+ */
+auto JsonPoolAllocator::FindSizeClass(void const* ptr) const -> std::size_t {
+  std::uint8_t const* const block{static_cast<std::uint8_t const*>(ptr)};
+  if (block < arena_.data() || block >= arena_.data() + kArenaSize) {
+    return kSizeClasses;
+  }
+
+  std::size_t size_class{kSizeClasses - 1};
+  while (block < class_begin_[size_class]) {
+    --size_class;
+  }
+  return size_class;
+}
+
+// ---- Global Instance ----
+JsonPoolAllocator json_allocator_g{};
+
+}  // namespace util
+}  // namespace owif
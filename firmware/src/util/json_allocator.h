@@ -0,0 +1,82 @@
+#ifndef OWIF_UTIL_JSON_ALLOCATOR_H
+#define OWIF_UTIL_JSON_ALLOCATOR_H
+
+// ---- Includes ----
+
+#include <ArduinoJson.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace owif {
+namespace util {
+
+/*!
+ * \brief Statistics of the JSON pool allocator.
+ */
+struct JsonPoolStatistics {
+  std::uint32_t size;             // Bytes of the arena in use
+  std::uint32_t capacity;         // Size of the arena [bytes]
+  std::uint32_t high_water_mark;  // Max. bytes of the arena in use since startup
+  std::uint32_t fallbacks;        // Number of allocations served by the heap as no block was available
+};
+
+/*!
+ * \brief ArduinoJson allocator backed by a static arena of fixed-size blocks. The arena is split into size classes
+ *        matching the allocations of ArduinoJson (strings, variant pools of 1 KB), each managed by a free list. The
+ *        blocks are reused across documents, so building responses does not fragment the heap. Requests exceeding the
+ *        largest block or an exhausted size class fall back to the heap and are counted.
+ *        Thread-safe. Documents are built in the MQTT task and the main loop.
+ */
+class JsonPoolAllocator final : public ArduinoJson::Allocator {
+ public:
+  JsonPoolAllocator();
+
+  JsonPoolAllocator(JsonPoolAllocator const&) = delete;
+  auto operator=(JsonPoolAllocator const&) -> JsonPoolAllocator& = delete;
+  JsonPoolAllocator(JsonPoolAllocator&&) = delete;
+  auto operator=(JsonPoolAllocator&&) -> JsonPoolAllocator& = delete;
+
+  ~JsonPoolAllocator() = default;
+
+  // ---- Public APIs --------------------------------------------------------------------------------------------------
+
+  auto allocate(std::size_t size) -> void* override;
+  auto deallocate(void* ptr) -> void override;
+  auto reallocate(void* ptr, std::size_t new_size) -> void* override;
+
+  auto GetStatistics() -> JsonPoolStatistics;
+
+ private:
+  static constexpr std::size_t kSizeClasses{6};
+  static constexpr std::array<std::size_t, kSizeClasses> kBlockSizes{{32, 64, 128, 256, 512, 1024}};  // bytes
+  static constexpr std::array<std::size_t, kSizeClasses> kBlockCounts{{48, 32, 16, 8, 4, 8}};
+  // Sum of the block sizes times the block counts
+  static constexpr std::size_t kArenaSize{48 * 32 + 32 * 64 + 16 * 128 + 8 * 256 + 4 * 512 + 8 * 1024};  // bytes
+
+  // Free blocks are linked through their first bytes
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  auto Allocate(std::size_t size) -> void*;
+  auto Deallocate(void* ptr) -> void;
+  auto FindSizeClass(void const* ptr) const -> std::size_t;
+
+  std::mutex mutex_{};
+  alignas(std::max_align_t) std::array<std::uint8_t, kArenaSize> arena_{};
+  std::array<std::uint8_t*, kSizeClasses> class_begin_{};  // First block of every size class
+  std::array<FreeBlock*, kSizeClasses> free_lists_{};
+  std::uint32_t used_{0};
+  std::uint32_t high_water_mark_{0};
+  std::uint32_t fallbacks_{0};
+};
+
+extern JsonPoolAllocator json_allocator_g;
+
+}  // namespace util
+}  // namespace owif
+
+#endif  // OWIF_UTIL_JSON_ALLOCATOR_H
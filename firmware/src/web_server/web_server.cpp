@@ -393,6 +393,27 @@ auto WebServer::HandleSave(AsyncWebServerRequest* request) -> void {
   if (request->hasParam(kConfigSaveMqttClientId, true)) {
     mqtt_config.SetClientId(request->getParam(kConfigSaveMqttClientId, true)->value());
   }
+  mqtt_config.SetDeviceTopics(request->hasParam(kConfigSaveMqttDevTopics, true));
+  if (request->hasParam(kConfigSaveMqttBatchWindow, true)) {
+    String const batch_window_str{request->getParam(kConfigSaveMqttBatchWindow, true)->value()};
+    mqtt_config.SetBatchWindow(std::strtoul(batch_window_str.c_str(), nullptr, 10));
+  }
+  if (request->hasParam(kConfigSaveMqttBatchSize, true)) {
+    mqtt_config.SetBatchSize(request->getParam(kConfigSaveMqttBatchSize, true)->value().toInt());
+  }
+  if (request->hasParam(kConfigSaveMqttPublishQos, true)) {
+    mqtt_config.SetPublishQos(request->getParam(kConfigSaveMqttPublishQos, true)->value().toInt());
+  }
+  if (request->hasParam(kConfigSaveMqttMaxInFlight, true)) {
+    mqtt_config.SetMaxInFlight(request->getParam(kConfigSaveMqttMaxInFlight, true)->value().toInt());
+  }
+  if (request->hasParam(kConfigSaveMqttOfflineBuffer, true)) {
+    mqtt_config.SetOfflineBuffer(request->getParam(kConfigSaveMqttOfflineBuffer, true)->value().toInt());
+  }
+  mqtt_config.SetOfflineSpill(request->hasParam(kConfigSaveMqttOfflineSpill, true));
+  if (request->hasParam(kConfigSaveMqttReplayRate, true)) {
+    mqtt_config.SetReplayRate(request->getParam(kConfigSaveMqttReplayRate, true)->value().toInt());
+  }
 
   config::persistency_g.StoreMqttConfig(mqtt_config);
 
@@ -483,6 +504,22 @@ auto WebServer::HandleConfig(AsyncWebServerRequest* request) -> void {
                     return mqtt_config.GetClientId();
                   } else if (var == "MQTT_RECON_TIMEOUT") {
                     return String{mqtt_config.GetReconnectTimeout()};
+                  } else if (var == "MQTT_DEV_TOPICS") {
+                    return ToTemplateCheckOption(mqtt_config.GetDeviceTopics());
+                  } else if (var == "MQTT_BATCH_WINDOW") {
+                    return String{mqtt_config.GetBatchWindow()};
+                  } else if (var == "MQTT_BATCH_SIZE") {
+                    return String{mqtt_config.GetBatchSize()};
+                  } else if (var == "MQTT_PUBLISH_QOS") {
+                    return String{mqtt_config.GetPublishQos()};
+                  } else if (var == "MQTT_MAX_IN_FLIGHT") {
+                    return String{mqtt_config.GetMaxInFlight()};
+                  } else if (var == "MQTT_OFFLINE_BUF") {
+                    return String{mqtt_config.GetOfflineBuffer()};
+                  } else if (var == "MQTT_OFFLINE_SPILL") {
+                    return ToTemplateCheckOption(mqtt_config.GetOfflineSpill());
+                  } else if (var == "MQTT_REPLAY_RATE") {
+                    return String{mqtt_config.GetReplayRate()};
                   }
                   // NtpConfig
                   else if (var == "NTP_SERVER") {
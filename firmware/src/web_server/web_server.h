@@ -76,6 +76,14 @@ class WebServer {
   static constexpr char const* kConfigSaveMqttTopic{"mqtt_topic"};
   static constexpr char const* kConfigSaveMqttClientId{"mqtt_client_id"};
   static constexpr char const* kConfigSaveMqttReconTimeout{"mqtt_recon_timeout"};
+  static constexpr char const* kConfigSaveMqttDevTopics{"mqtt_dev_topics"};
+  static constexpr char const* kConfigSaveMqttBatchWindow{"mqtt_batch_window"};
+  static constexpr char const* kConfigSaveMqttBatchSize{"mqtt_batch_size"};
+  static constexpr char const* kConfigSaveMqttPublishQos{"mqtt_publish_qos"};
+  static constexpr char const* kConfigSaveMqttMaxInFlight{"mqtt_max_in_flight"};
+  static constexpr char const* kConfigSaveMqttOfflineBuffer{"mqtt_offline_buf"};
+  static constexpr char const* kConfigSaveMqttOfflineSpill{"mqtt_offline_spill"};
+  static constexpr char const* kConfigSaveMqttReplayRate{"mqtt_replay_rate"};
   static constexpr char const* kConfigSaveNtpServer{"ntp_server"};
   static constexpr char const* kConfigSaveNtpTimezone{"ntp_timezone"};
 
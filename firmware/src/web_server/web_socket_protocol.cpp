@@ -5,25 +5,35 @@
 
 #include "cmd/json_builder.h"
 #include "cmd/json_constants.h"
+#include "util/json_allocator.h"
 
 namespace owif {
 namespace web_server {
 namespace web_socket {
 
-auto WebSocketProtocol::SerializeLog(String const& log_message) -> String {
-  JsonDocument log_json{};
+/*!
+ * Serializes the log message, terminated by a newline, directly into a message buffer of the web socket. The size is
+ * measured first, so the message is not built in an intermediate string.
+ * \return Buffer to be passed to textAll() or text(), which take over its ownership. nullptr if out of memory.
+ */
+auto WebSocketProtocol::SerializeLog(AsyncWebSocket& web_socket, String const& log_message)
+    -> AsyncWebSocketMessageBuffer* {
+  JsonDocument log_json{&util::json_allocator_g};
   log_json[kWebSocketKeyLogging] = log_message;
 
-  String serialized_json;
-  serializeJson(log_json, serialized_json);
-
-  serialized_json += "\n";
+  std::size_t const json_length{measureJson(log_json)};
+  AsyncWebSocketMessageBuffer* const buffer{web_socket.makeBuffer(json_length + 1)};
+  if (buffer != nullptr) {
+    char* const data{reinterpret_cast<char*>(buffer->get())};
+    serializeJson(log_json, data, json_length);  // Exact size: no null terminator
+    data[json_length] = '\n';
+  }
 
-  return serialized_json;
+  return buffer;
 }
 
 auto WebSocketProtocol::SerializeOneWireDeviceMap(one_wire::OneWireSystem& one_wire_system) -> String {
-  JsonDocument json{};
+  JsonDocument json{&util::json_allocator_g};
   JsonArray devices_json{json[cmd::json::kDevices].to<JsonArray>()};
 
   one_wire::OneWireSystem::DeviceMap const& devices_map{one_wire_system.GetAvailableDevices()};
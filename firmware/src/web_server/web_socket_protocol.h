@@ -2,6 +2,7 @@
 #define OWIF_WEB_SERVER_WEB_SOCKET_PROTOCOL_H
 
 #include <Arduino.h>
+#include <AsyncWebSocket.h>
 
 #include "one_wire/one_wire_subsystem.h"
 
@@ -11,7 +12,7 @@ namespace web_socket {
 
 class WebSocketProtocol {
  public:
-  static auto SerializeLog(String const& log_message) -> String;
+  static auto SerializeLog(AsyncWebSocket& web_socket, String const& log_message) -> AsyncWebSocketMessageBuffer*;
   static auto SerializeOneWireDeviceMap(one_wire::OneWireSystem& one_wire_system) -> String;
 
  private:
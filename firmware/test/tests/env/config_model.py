@@ -18,6 +18,13 @@ class MqttConfig:
     status_topic: str = "1wIf/stat"
 
 
+@dataclass
+class WebConfig:
+    host: str
+    user: str
+    password: str
+
+
 @dataclass
 class DeviceConfig:
     device_id: OneWireAddress
@@ -28,6 +35,9 @@ class DeviceConfig:
 class ConfigModel:
     mqtt: MqttConfig
     devices: List[DeviceConfig] = field(default_factory=list)
+    hotplug_device: DeviceConfig | None = None  # Device unplugged / plugged in by the operator during the test
+    web: WebConfig | None = None  # Web interface of the device, used to change its configuration
+    ethernet_unplug_test: bool = False  # Ethernet cable unplugged / plugged in by the operator during the test
 
     @staticmethod
     def load_from_yaml(
@@ -57,7 +67,26 @@ class ConfigModel:
             channel = device_data["channel"]
             devices_config.append(DeviceConfig(device_id, channel))
 
-        return ConfigModel(mqtt=mqtt_config, devices=devices_config)
+        # Optional hot-plug device
+        hotplug_device_config = None
+        hotplug_device_data = data.get("hotplug_device")
+        if hotplug_device_data is not None:
+            hotplug_device_config = DeviceConfig(
+                OneWireAddress(hotplug_device_data["device_id"]), hotplug_device_data["channel"]
+            )
+
+        # Optional WebConfig
+        web_config = None
+        if data.get("web_host") is not None:
+            web_config = WebConfig(host=data["web_host"], user=data.get("web_user"), password=data.get("web_password"))
+
+        return ConfigModel(
+            mqtt=mqtt_config,
+            devices=devices_config,
+            hotplug_device=hotplug_device_config,
+            web=web_config,
+            ethernet_unplug_test=bool(data.get("ethernet_unplug_test", False)),
+        )
 
     def get_family_codes_from_devices(self) -> List[int]:
         family_codes = set()
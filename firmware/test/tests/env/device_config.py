@@ -0,0 +1,138 @@
+import logging
+import re
+import typing as t
+import urllib.parse
+import urllib.request
+from html.parser import HTMLParser
+from http.cookiejar import CookieJar
+
+import pytest
+
+from tests.env.mqtt_fixture import MqttCaptureFixture
+from tests.env.mqtt_protocol import MqttProtocol as p
+
+logger = logging.getLogger(__name__)
+
+
+class ConfigFormParser(HTMLParser):
+    """Collects the current values of the config form (config.html) as they would be submitted by the browser."""
+
+    def __init__(self) -> None:
+        super().__init__()
+        self.form: t.Dict[str, str] = {}
+
+    def handle_starttag(self, tag: str, attrs: t.List[t.Tuple[str, str | None]]) -> None:
+        attributes = dict(attrs)
+        name = attributes.get("name")
+        if tag != "input" or name is None:
+            return
+
+        input_type = attributes.get("type", "text")
+        if input_type == "checkbox":
+            # Checkboxes are only submitted if set (HTML standard)
+            if "checked" in attributes:
+                self.form[name] = "on"
+        elif input_type != "password":
+            # Empty passwords keep the stored password, hence they are not submitted
+            self.form[name] = attributes.get("value") or ""
+
+
+class DeviceConfigFixture:
+    """Changes the configuration of the device via its web interface. Changes are applied by a restart."""
+
+    LOGIN_PARAM_USER = "user"
+    LOGIN_PARAM_PASSWORD = "pass"
+    LOG_LEVEL_PARAM = "log_level"
+    MQTT_DEV_TOPICS_PARAM = "mqtt_dev_topics"
+    MQTT_BATCH_WINDOW_PARAM = "mqtt_batch_window"
+    MQTT_BATCH_SIZE_PARAM = "mqtt_batch_size"
+    MQTT_OFFLINE_BUF_PARAM = "mqtt_offline_buf"
+    MQTT_OFFLINE_SPILL_PARAM = "mqtt_offline_spill"
+    MQTT_REPLAY_RATE_PARAM = "mqtt_replay_rate"
+    RESTART_TIMEOUT_SEC = 60
+
+    def __init__(self, mqtt_capture: MqttCaptureFixture, host: str, user: str, password: str) -> None:
+        self._mqtt_capture = mqtt_capture
+        self._base_url = f"http://{host}"
+        self._user = user
+        self._password = password
+        self._opener = urllib.request.build_opener(urllib.request.HTTPCookieProcessor(CookieJar()))
+        self._original_form: t.Dict[str, str] | None = None
+
+    def apply(self, overrides: t.Dict[str, str | None]) -> None:
+        """Stores the config with the overrides and restarts the device. A value of None unsets a checkbox."""
+        self._login()
+        form = self._load()
+        if self._original_form is None:
+            self._original_form = dict(form)
+
+        for name, value in overrides.items():
+            if value is None:
+                form.pop(name, None)
+            else:
+                form[name] = value
+
+        self._save(form)
+        self._restart()
+
+    def finalize(self) -> None:
+        """Restores the original config."""
+        if self._original_form is not None:
+            self._login()
+            self._save(self._original_form)
+            self._restart()
+            self._original_form = None
+
+    def _request(self, path: str, form: t.Dict[str, str] | None = None) -> str:
+        data = urllib.parse.urlencode(form).encode("utf-8") if form is not None else None
+        with self._opener.open(f"{self._base_url}{path}", data=data, timeout=10) as response:
+            return response.read().decode("utf-8")
+
+    def _login(self) -> None:
+        self._request("/login", {self.LOGIN_PARAM_USER: self._user, self.LOGIN_PARAM_PASSWORD: self._password})
+
+    def _load(self) -> t.Dict[str, str]:
+        html = self._request("/config")
+        parser = ConfigFormParser()
+        parser.feed(html)
+
+        # The log level is selected by a script on page load
+        log_level = re.search(r"log_level-select'\)\.value = \"(\d+)\"", html)
+        if log_level is not None:
+            parser.form[self.LOG_LEVEL_PARAM] = log_level.group(1)
+
+        return parser.form
+
+    def _save(self, form: t.Dict[str, str]) -> None:
+        logger.debug(f"[DeviceConfig] Saving config: {form}")
+        self._request("/save", form)
+
+    def _restart(self) -> None:
+        logger.debug("[DeviceConfig] Restarting device")
+        self._mqtt_capture.messages.clear()
+        self._request("/restart")
+
+        # The device publishes 'online' on the status topic once reconnected (never batched)
+        self._mqtt_capture.wait_for_message(
+            lambda mqtt_message: mqtt_message.is_json()
+            and isinstance(mqtt_message.as_json(), dict)
+            and mqtt_message.as_json().get(p.ATTRIB_STATE) == p.VALUE_STATE_ONLINE,
+            timeout=self.RESTART_TIMEOUT_SEC,
+        )
+        self._mqtt_capture.messages.clear()
+
+
+@pytest.fixture(scope="function")
+def device_config(request: pytest.FixtureRequest, mqtt_capture: MqttCaptureFixture) -> DeviceConfigFixture:
+    web_config_marker = request.node.get_closest_marker("device_config_data")
+    assert web_config_marker is not None
+    web_config = web_config_marker.args[0]
+    if web_config is None:
+        pytest.skip("No web interface configured in the test environment")
+
+    device_config = DeviceConfigFixture(
+        mqtt_capture, host=web_config.host, user=web_config.user, password=web_config.password
+    )
+
+    yield device_config
+    device_config.finalize()
@@ -144,6 +144,15 @@ class MqttCaptureFixture:
                 time.sleep(0.05)
         pytest.fail(f"Timeout: timeout expired while waiting for reception of {expected_number} MQTT message(s)")
 
+    def wait_for_message(self, predicate: t.Callable[[MqttMessage], bool], timeout: float = 5.0) -> MqttMessage:
+        start = time.time()
+        while time.time() - start < timeout:
+            for message in self._buffer:
+                if predicate(message):
+                    return message
+            time.sleep(0.05)
+        pytest.fail("Timeout: timeout expired while waiting for reception of the expected MQTT message")
+
 
 @pytest.fixture(scope="function")
 def mqtt_capture(request: pytest.FixtureRequest) -> MqttCaptureFixture:
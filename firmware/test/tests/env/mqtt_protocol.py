@@ -8,6 +8,9 @@ class MqttProtocol:
     ATTRIB_STATE = "state"
     ATTRIB_TIME = "time"
     ATTRIB_ACTION = "action"
+    ATTRIB_ID = "id"
+    ATTRIB_DEADLINE = "deadline"
+    ATTRIB_REPLY_TO = "reply_to"
     ATTRIB_DEVICE = "device"
     ATTRIB_DEVICE_ID = "device_id"
     ATTRIB_CHANNEL = "channel"
@@ -15,7 +18,25 @@ class MqttProtocol:
     ATTRIB_ATTRIBUTE = "attribute"
     ATTRIB_ATTRIBUTES = "attributes"
     ATTRIB_INTERVAL = "interval"
+    ATTRIB_ON_CHANGE = "on_change"
+    ATTRIB_DEADBAND = "deadband"
+    ATTRIB_DEADBAND_TYPE = "deadband_type"
+    ATTRIB_MAX_SILENCE = "max_silence"
+    ATTRIB_SAMPLE_INTERVAL = "sample_interval"
+    ATTRIB_PUBLISH_INTERVAL = "publish_interval"
+    ATTRIB_AGGREGATES = "aggregates"
+    ATTRIB_WINDOW = "window"
+    ATTRIB_MIN = "min"
+    ATTRIB_MAX = "max"
+    ATTRIB_MEAN = "mean"
+    ATTRIB_LAST = "last"
+    ATTRIB_COUNT = "count"
+    ATTRIB_WILDCARD = "*"
+    ATTRIB_MIN_INTERVAL = "min_interval"
+    ATTRIB_MAX_INTERVAL = "max_interval"
+    ATTRIB_ADAPTIVE_DELTA = "adaptive_delta"
     ATTRIB_PRESENCE = "presence"
+    ATTRIB_EVENT = "event"
     ATTRIB_TEMPERATURE = "temperature"
     ATTRIB_VAD = "VAD"
     ATTRIB_VDD = "VDD"
@@ -24,6 +45,32 @@ class MqttProtocol:
     ATTRIB_MESSAGE = "message"
     ATTRIB_REQUEST = "request"
     ATTRIB_DEVICES = "devices"
+    ATTRIB_CODE = "code"
+    ATTRIB_COMMAND_QUEUES = "command_queues"
+    ATTRIB_COMMAND_POOL = "command_pool"
+    ATTRIB_SUBSCRIPTIONS = "subscriptions"
+    ATTRIB_INTERACTIVE = "interactive"
+    ATTRIB_PERIODIC = "periodic"
+    ATTRIB_SIZE = "size"
+    ATTRIB_CAPACITY = "capacity"
+    ATTRIB_HIGH_WATER_MARK = "high_water_mark"
+    ATTRIB_REJECTED = "rejected"
+    ATTRIB_DROPPED = "dropped"
+    ATTRIB_EXPIRED = "expired"
+    ATTRIB_MEMORY = "memory"
+    ATTRIB_PUBLISH_QUEUE = "publish_queue"
+    ATTRIB_IN_FLIGHT = "in_flight"
+    ATTRIB_RETRIED = "retried"
+    ATTRIB_OFFLINE_STORE = "offline_store"
+    ATTRIB_SPILLED = "spilled"
+    ATTRIB_REPLAYED = "replayed"
+    ATTRIB_MQTT_CONNECTION = "mqtt_connection"
+    ATTRIB_RECONNECTS = "reconnects"
+    ATTRIB_ATTEMPTS = "attempts"
+    ATTRIB_LAST_DOWNTIME = "last_downtime"
+    ATTRIB_MAX_DOWNTIME = "max_downtime"
+    ATTRIB_JSON_POOL = "json_pool"
+    ATTRIB_FALLBACKS = "fallbacks"
 
     # --- Action types ---
     ACTION_RESTART = "restart"
@@ -31,7 +78,11 @@ class MqttProtocol:
     ACTION_READ = "read"
     ACTION_SUBSCRIBE = "subscribe"
     ACTION_UNSUBSCRIBE = "unsubscribe"
+    ACTION_STATISTICS = "statistics"
 
     # ---- Common attribute values ----
     VALUE_STATE_ONLINE = "online"
     VALUE_STATE_OFFLINE = "offline"
+    VALUE_EVENT_ARRIVED = "arrived"
+    VALUE_EVENT_DEPARTED = "departed"
+    VALUE_ERROR_CODE_BUSY = "busy"
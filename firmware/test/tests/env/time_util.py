@@ -6,6 +6,10 @@ class TimeUtil:
     DISABLE_MAX_DELTA_CHECK = -1
     MAX_DELTA_SECONDS_DEFAULT = 30
 
+    @staticmethod
+    def parse_timestamp(timestamp: str) -> datetime:
+        return datetime.strptime(timestamp, TimeUtil.TIMESTAMP_FORMAT)
+
     @staticmethod
     def assert_timestamp(timestamp: str, max_delta_seconds_to_now = MAX_DELTA_SECONDS_DEFAULT) -> None:
         try:
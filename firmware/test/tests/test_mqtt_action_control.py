@@ -56,3 +56,226 @@ def test_mqtt_protocol_restart(mqtt_capture) -> None:
 
     scan_response_msg = mqtt_capture.messages[0].as_json()
     assert scan_response_msg.get(p.ATTRIB_ACTION) == p.ACTION_SCAN
+
+
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_statistics(mqtt_capture) -> None:
+    logger.info("Send statistics request to 1-Wire Interface.")
+
+    request = json.dumps({p.ATTRIB_ACTION: p.ACTION_STATISTICS})
+    mqtt_capture.publish(config.mqtt.cmd_topic, request)
+
+    mqtt_capture.wait_for_messages()
+    response = mqtt_capture.messages[0].as_json()
+
+    # Verify response
+    TimeUtil.assert_timestamp(response.get(p.ATTRIB_TIME))
+    assert response.get(p.ATTRIB_ACTION) == p.ACTION_STATISTICS
+    command_pool = response.get(p.ATTRIB_COMMAND_POOL)
+    assert command_pool is not None
+    assert 0 <= command_pool.get(p.ATTRIB_SIZE) <= command_pool.get(p.ATTRIB_HIGH_WATER_MARK)
+    assert command_pool.get(p.ATTRIB_HIGH_WATER_MARK) <= command_pool.get(p.ATTRIB_CAPACITY)
+    command_queues = response.get(p.ATTRIB_COMMAND_QUEUES)
+    assert command_queues is not None
+    for lane in [p.ATTRIB_INTERACTIVE, p.ATTRIB_PERIODIC]:
+        queue_statistics = command_queues.get(lane)
+        assert queue_statistics is not None
+        assert 0 <= queue_statistics.get(p.ATTRIB_SIZE) <= queue_statistics.get(p.ATTRIB_CAPACITY)
+        assert queue_statistics.get(p.ATTRIB_HIGH_WATER_MARK) <= queue_statistics.get(p.ATTRIB_CAPACITY)
+        assert queue_statistics.get(p.ATTRIB_REJECTED) >= 0
+        assert queue_statistics.get(p.ATTRIB_DROPPED) is None
+        assert queue_statistics.get(p.ATTRIB_EXPIRED) >= 0
+    subscriptions = response.get(p.ATTRIB_SUBSCRIPTIONS)
+    assert subscriptions is not None
+    assert 0 <= subscriptions.get(p.ATTRIB_SIZE) <= subscriptions.get(p.ATTRIB_CAPACITY)
+    assert subscriptions.get(p.ATTRIB_MEMORY) >= 0
+    publish_queue = response.get(p.ATTRIB_PUBLISH_QUEUE)
+    assert publish_queue is not None
+    assert 0 <= publish_queue.get(p.ATTRIB_SIZE) <= publish_queue.get(p.ATTRIB_HIGH_WATER_MARK)
+    assert publish_queue.get(p.ATTRIB_HIGH_WATER_MARK) <= publish_queue.get(p.ATTRIB_CAPACITY)
+    assert publish_queue.get(p.ATTRIB_IN_FLIGHT) >= 0
+    assert publish_queue.get(p.ATTRIB_RETRIED) >= 0
+    assert publish_queue.get(p.ATTRIB_DROPPED) >= 0
+    offline_store = response.get(p.ATTRIB_OFFLINE_STORE)
+    assert offline_store is not None
+    assert 0 <= offline_store.get(p.ATTRIB_SPILLED) <= offline_store.get(p.ATTRIB_SIZE)
+    assert offline_store.get(p.ATTRIB_REPLAYED) >= 0
+    assert offline_store.get(p.ATTRIB_DROPPED) >= 0
+    mqtt_connection = response.get(p.ATTRIB_MQTT_CONNECTION)
+    assert mqtt_connection is not None
+    assert 0 <= mqtt_connection.get(p.ATTRIB_RECONNECTS) <= mqtt_connection.get(p.ATTRIB_ATTEMPTS)
+    assert 0 <= mqtt_connection.get(p.ATTRIB_LAST_DOWNTIME) <= mqtt_connection.get(p.ATTRIB_MAX_DOWNTIME)
+    json_pool = response.get(p.ATTRIB_JSON_POOL)
+    assert json_pool is not None
+    assert 0 <= json_pool.get(p.ATTRIB_SIZE) <= json_pool.get(p.ATTRIB_HIGH_WATER_MARK)
+    assert json_pool.get(p.ATTRIB_HIGH_WATER_MARK) <= json_pool.get(p.ATTRIB_CAPACITY)
+    assert json_pool.get(p.ATTRIB_FALLBACKS) >= 0
+
+
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_statistics_command_pool_overload(mqtt_capture) -> None:
+    logger.info("Flood the command pool with read requests and verify 'busy' errors and the statistics.")
+
+    device = config.devices[0]
+
+    def get_statistics() -> dict:
+        mqtt_capture.messages.clear()
+        mqtt_capture.publish(config.mqtt.cmd_topic, json.dumps({p.ATTRIB_ACTION: p.ACTION_STATISTICS}))
+        return mqtt_capture.wait_for_message(
+            lambda mqtt_message: mqtt_message.as_json().get(p.ATTRIB_ACTION) == p.ACTION_STATISTICS
+        ).as_json()
+
+    def wait_until_quiet(quiet_sec: float = 2.0, timeout_sec: float = 120.0) -> None:
+        start = time.time()
+        received = -1
+        while received != len(mqtt_capture.messages):
+            assert time.time() - start < timeout_sec, "Device did not finish the flood of requests"
+            received = len(mqtt_capture.messages)
+            time.sleep(quiet_sec)
+
+    statistics_before = get_statistics()
+    capacity = statistics_before.get(p.ATTRIB_COMMAND_POOL).get(p.ATTRIB_CAPACITY)
+    rejected_before = statistics_before.get(p.ATTRIB_COMMAND_QUEUES).get(p.ATTRIB_INTERACTIVE).get(p.ATTRIB_REJECTED)
+
+    # Requests arrive much faster than the 1-Wire bus serves them: the pool runs full
+    requests = 2 * capacity
+    read_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_READ,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+        }
+    )
+    mqtt_capture.messages.clear()
+    for _ in range(requests):
+        mqtt_capture.publish(config.mqtt.cmd_topic, read_request)
+    wait_until_quiet()
+
+    # Responses may be lost by the full publish queue, so not every rejected request shows up as error
+    responses = [mqtt_message.as_json() for mqtt_message in mqtt_capture.messages if mqtt_message.is_json()]
+    busy_errors = [
+        response
+        for response in responses
+        if isinstance(response, dict)
+        and response.get(p.ATTRIB_ERROR) is not None
+        and response.get(p.ATTRIB_ERROR).get(p.ATTRIB_CODE) == p.VALUE_ERROR_CODE_BUSY
+    ]
+    assert len(busy_errors) > 0
+    busy_message = busy_errors[0].get(p.ATTRIB_ERROR).get(p.ATTRIB_MESSAGE)
+    assert busy_message == "Command queue full. Request rejected, retry later."
+
+    statistics_after = get_statistics()
+    command_pool = statistics_after.get(p.ATTRIB_COMMAND_POOL)
+    assert command_pool.get(p.ATTRIB_HIGH_WATER_MARK) == capacity
+    interactive = statistics_after.get(p.ATTRIB_COMMAND_QUEUES).get(p.ATTRIB_INTERACTIVE)
+    assert interactive.get(p.ATTRIB_REJECTED) - rejected_before >= len(busy_errors)
+    assert interactive.get(p.ATTRIB_REJECTED) - rejected_before < requests
+    assert interactive.get(p.ATTRIB_HIGH_WATER_MARK) >= capacity - 1  # A read may be in progress while flooded
+
+
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_statistics_json_pool_steady_state(mqtt_capture) -> None:
+    logger.info("Send identical read requests and verify the JSON pool serves them without heap fallbacks.")
+
+    reads = 20
+    device = config.devices[0]
+
+    def get_json_pool_statistics() -> dict:
+        mqtt_capture.messages.clear()
+        mqtt_capture.publish(config.mqtt.cmd_topic, json.dumps({p.ATTRIB_ACTION: p.ACTION_STATISTICS}))
+        response = mqtt_capture.wait_for_message(
+            lambda mqtt_message: mqtt_message.as_json().get(p.ATTRIB_ACTION) == p.ACTION_STATISTICS
+        ).as_json()
+        return response.get(p.ATTRIB_JSON_POOL)
+
+    read_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_READ,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+        }
+    )
+
+    def read() -> None:
+        mqtt_capture.messages.clear()
+        mqtt_capture.publish(config.mqtt.cmd_topic, read_request)
+        response = mqtt_capture.wait_for_message(
+            lambda mqtt_message: mqtt_message.as_json().get(p.ATTRIB_ACTION) == p.ACTION_READ
+        ).as_json()
+        assert response.get(p.ATTRIB_DEVICE).get(p.ATTRIB_PRESENCE) is True
+
+    # Warm-up read before the first snapshot
+    read()
+    json_pool_before = get_json_pool_statistics()
+
+    for _ in range(reads):
+        read()
+
+    json_pool_after = get_json_pool_statistics()
+
+    # Steady state: every document of the reads and the statistics is served by the pool
+    assert json_pool_after.get(p.ATTRIB_FALLBACKS) == json_pool_before.get(p.ATTRIB_FALLBACKS)
+    assert json_pool_after.get(p.ATTRIB_HIGH_WATER_MARK) <= json_pool_after.get(p.ATTRIB_CAPACITY)
+
+
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_statistics_subscription_steady_state(mqtt_capture) -> None:
+    family_code = config.devices[0].device_id.get_family_code()
+    logger.info(f"Subscribe to filtered adaptive presence of family {family_code} and verify a steady memory usage.")
+
+    interval_ms = 500
+
+    def get_statistics() -> dict:
+        mqtt_capture.messages.clear()
+        mqtt_capture.publish(config.mqtt.cmd_topic, json.dumps({p.ATTRIB_ACTION: p.ACTION_STATISTICS}))
+        return mqtt_capture.wait_for_message(
+            lambda mqtt_message: mqtt_message.as_json().get(p.ATTRIB_ACTION) == p.ACTION_STATISTICS
+        ).as_json()
+
+    subscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_SUBSCRIBE,
+            p.ATTRIB_FAMILY_CODE: family_code,
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+            p.ATTRIB_INTERVAL: interval_ms,
+            p.ATTRIB_ON_CHANGE: True,
+            p.ATTRIB_MAX_SILENCE: 2 * interval_ms,
+            p.ATTRIB_MIN_INTERVAL: interval_ms,
+            p.ATTRIB_MAX_INTERVAL: 2 * interval_ms,
+            p.ATTRIB_ADAPTIVE_DELTA: 0.5,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, subscribe_request)
+    mqtt_capture.wait_for_messages()
+    assert mqtt_capture.messages[0].as_json().get(p.ATTRIB_ACKNOWLEDGE) is True
+
+    # Every device of the family is tracked by the filter and the adaptation after the first read
+    time.sleep(4 * interval_ms / 1000)
+    statistics_before = get_statistics()
+
+    time.sleep(10 * interval_ms / 1000)
+    statistics_after = get_statistics()
+
+    # Steady state: The reads of the subscription allocate neither per device values nor heap backed documents
+    subscriptions_before = statistics_before.get(p.ATTRIB_SUBSCRIPTIONS)
+    subscriptions_after = statistics_after.get(p.ATTRIB_SUBSCRIPTIONS)
+    assert subscriptions_after.get(p.ATTRIB_SIZE) == subscriptions_before.get(p.ATTRIB_SIZE)
+    assert subscriptions_after.get(p.ATTRIB_MEMORY) == subscriptions_before.get(p.ATTRIB_MEMORY)
+    json_pool_before = statistics_before.get(p.ATTRIB_JSON_POOL)
+    json_pool_after = statistics_after.get(p.ATTRIB_JSON_POOL)
+    assert json_pool_after.get(p.ATTRIB_FALLBACKS) == json_pool_before.get(p.ATTRIB_FALLBACKS)
+
+    # Unsubscribe
+    unsubscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_UNSUBSCRIBE,
+            p.ATTRIB_FAMILY_CODE: family_code,
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+        }
+    )
+    mqtt_capture.messages.clear()
+    mqtt_capture.publish(config.mqtt.cmd_topic, unsubscribe_request)
+    unsubscribe_ack_msg = mqtt_capture.wait_for_message(
+        lambda mqtt_message: mqtt_message.as_json().get(p.ATTRIB_ACTION) == p.ACTION_UNSUBSCRIBE
+    ).as_json()
+    assert unsubscribe_ack_msg.get(p.ATTRIB_ACKNOWLEDGE) is True
@@ -1,8 +1,11 @@
 import json
+import time
 
+import msgpack
 import pytest
 
 from tests.env.config_model import ConfigModel
+from tests.env.device_config import DeviceConfigFixture, device_config  # noqa: F401
 from tests.env.logger import Logger
 from tests.env.mqtt_fixture import mqtt_capture  # noqa: F401
 from tests.env.mqtt_protocol import MqttProtocol as p
@@ -69,6 +72,183 @@ def test_mqtt_protocol_read_single_device_temperature(mqtt_capture, device) -> N
     ow_dd.assert_temperature_range(response_device.get(p.ATTRIB_TEMPERATURE))
 
 
+@pytest.mark.parametrize("device", config.devices)
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_read_single_device_presence_msgpack(mqtt_capture, device) -> None:
+    logger.info(f"Sending MessagePack read request for attribute 'presence' to single device {device.device_id}.")
+
+    cmd_topic_msgpack = f"{config.mqtt.cmd_topic}/msgpack"
+    status_topic_msgpack = f"{config.mqtt.status_topic}/msgpack"
+    mqtt_capture.mqtt_client.client.subscribe(status_topic_msgpack, 0)
+    time.sleep(0.2)
+
+    request = msgpack.packb(
+        {
+            p.ATTRIB_ACTION: p.ACTION_READ,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+        }
+    )
+    mqtt_capture.publish(cmd_topic_msgpack, request)
+
+    mqtt_capture.wait_for_messages()
+    time.sleep(0.2)
+
+    # The response is only published in the format of the request
+    assert len(mqtt_capture.messages) == 1
+    assert mqtt_capture.messages[0].topic == status_topic_msgpack
+    response = msgpack.unpackb(mqtt_capture.messages[0].payload)
+
+    # Verify response
+    TimeUtil.assert_timestamp(response.get(p.ATTRIB_TIME))
+    assert response.get(p.ATTRIB_ACTION) == p.ACTION_READ
+    response_device = response.get(p.ATTRIB_DEVICE)
+    assert response_device is not None
+    assert response_device.get(p.ATTRIB_DEVICE_ID) == str(device.device_id)
+    assert response_device.get(p.ATTRIB_PRESENCE) is True
+
+    mqtt_capture.mqtt_client.client.unsubscribe(status_topic_msgpack)
+
+
+@pytest.mark.mqtt_capture_data(config.mqtt)
+@pytest.mark.device_config_data(config.web)
+def test_mqtt_protocol_read_batched_responses(mqtt_capture, device_config) -> None:
+    batch_size = 3
+    batch_window_ms = 2000
+    logger.info(f"Enable response batching (size {batch_size}, window {batch_window_ms} ms) and read {batch_size}x.")
+
+    device_config.apply(
+        {
+            DeviceConfigFixture.MQTT_BATCH_SIZE_PARAM: str(batch_size),
+            DeviceConfigFixture.MQTT_BATCH_WINDOW_PARAM: str(batch_window_ms),
+        }
+    )
+
+    devices = [config.devices[index % len(config.devices)] for index in range(batch_size)]
+    for device in devices:
+        request = json.dumps(
+            {
+                p.ATTRIB_ACTION: p.ACTION_READ,
+                p.ATTRIB_DEVICE_ID: str(device.device_id),
+                p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+            }
+        )
+        mqtt_capture.publish(config.mqtt.cmd_topic, request)
+
+    # The batch is complete after batch_size responses: Published as a single array before the window ends
+    mqtt_capture.wait_for_messages(timeout=batch_window_ms / 1000)
+    time.sleep(0.5)
+    assert len(mqtt_capture.messages) == 1
+
+    batch = json.loads(mqtt_capture.messages[0].payload)
+    assert isinstance(batch, list)
+    assert len(batch) == batch_size
+    for response, device in zip(batch, devices, strict=True):
+        TimeUtil.assert_timestamp(response.get(p.ATTRIB_TIME))
+        assert response.get(p.ATTRIB_ACTION) == p.ACTION_READ
+        assert response.get(p.ATTRIB_DEVICE).get(p.ATTRIB_DEVICE_ID) == str(device.device_id)
+        assert response.get(p.ATTRIB_DEVICE).get(p.ATTRIB_PRESENCE) is True
+
+    # A single response is published at the end of the window
+    request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_READ,
+            p.ATTRIB_DEVICE_ID: str(devices[0].device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+        }
+    )
+    start = time.time()
+    mqtt_capture.publish(config.mqtt.cmd_topic, request)
+    mqtt_capture.wait_for_messages(clean_buffer=True, timeout=batch_window_ms / 1000 + 1.0)
+    assert time.time() - start >= batch_window_ms / 1000 - 0.2
+
+    batch = json.loads(mqtt_capture.messages[0].payload)
+    assert isinstance(batch, list)
+    assert len(batch) == 1
+    assert batch[0].get(p.ATTRIB_DEVICE).get(p.ATTRIB_DEVICE_ID) == str(devices[0].device_id)
+
+
+@pytest.mark.parametrize("device", config.get_by_attribute(p.ATTRIB_TEMPERATURE))
+@pytest.mark.mqtt_capture_data(config.mqtt)
+@pytest.mark.device_config_data(config.web)
+def test_mqtt_protocol_read_single_device_device_topics(mqtt_capture, device_config, device) -> None:
+    logger.info(f"Enable device topics and read attributes 'presence' and 'temperature' of device {device.device_id}.")
+
+    device_config.apply({DeviceConfigFixture.MQTT_DEV_TOPICS_PARAM: "on"})
+
+    topic = config.mqtt.status_topic.rsplit("/", 1)[0]
+    presence_topic = f"{topic}/dev/{device.device_id}/{p.ATTRIB_PRESENCE}"
+    temperature_topic = f"{topic}/dev/{device.device_id}/{p.ATTRIB_TEMPERATURE}"
+    dev_topics = [presence_topic, temperature_topic]
+
+    # Clear values retained by previous test runs
+    for dev_topic in dev_topics:
+        mqtt_capture.publish(dev_topic, "", retain=True)
+
+    mqtt_capture.mqtt_client.client.subscribe([(dev_topic, 0) for dev_topic in dev_topics])
+    time.sleep(0.2)
+
+    for attribute in (p.ATTRIB_PRESENCE, p.ATTRIB_TEMPERATURE):
+        request = json.dumps(
+            {
+                p.ATTRIB_ACTION: p.ACTION_READ,
+                p.ATTRIB_DEVICE_ID: str(device.device_id),
+                p.ATTRIB_ATTRIBUTE: attribute,
+            }
+        )
+        mqtt_capture.publish(config.mqtt.cmd_topic, request)
+
+    # Response on the status topic + plain value on the device topic per read
+    status_response = mqtt_capture.wait_for_message(
+        lambda mqtt_message: mqtt_message.topic == config.mqtt.status_topic
+        and mqtt_message.as_json().get(p.ATTRIB_DEVICE, {}).get(p.ATTRIB_TEMPERATURE) is not None
+    ).as_json()
+    presence_msg = mqtt_capture.wait_for_message(lambda mqtt_message: mqtt_message.topic == presence_topic)
+    temperature_msg = mqtt_capture.wait_for_message(lambda mqtt_message: mqtt_message.topic == temperature_topic)
+
+    assert presence_msg.payload == b"true"
+    temperature = float(temperature_msg.payload)
+    ow_dd.assert_temperature_range(temperature)
+    assert temperature == pytest.approx(status_response.get(p.ATTRIB_DEVICE).get(p.ATTRIB_TEMPERATURE))
+
+    # The values are retained: A new subscriber receives them immediately
+    mqtt_capture.mqtt_client.client.unsubscribe(dev_topics)
+    time.sleep(0.2)
+    mqtt_capture.messages.clear()
+    mqtt_capture.mqtt_client.client.subscribe([(dev_topic, 0) for dev_topic in dev_topics])
+
+    retained_presence_msg = mqtt_capture.wait_for_message(lambda mqtt_message: mqtt_message.topic == presence_topic)
+    retained_temperature_msg = mqtt_capture.wait_for_message(
+        lambda mqtt_message: mqtt_message.topic == temperature_topic
+    )
+    assert retained_presence_msg.payload == b"true"
+    assert float(retained_temperature_msg.payload) == pytest.approx(temperature)
+
+    # Results on a reply topic are private: not published on the device topics
+    reply_topic = f"{config.mqtt.status_topic}/reply/test"
+    mqtt_capture.mqtt_client.client.subscribe(reply_topic, 0)
+    time.sleep(0.2)
+    mqtt_capture.messages.clear()
+    request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_READ,
+            p.ATTRIB_REPLY_TO: reply_topic,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_TEMPERATURE,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, request)
+    mqtt_capture.wait_for_message(lambda mqtt_message: mqtt_message.topic == reply_topic)
+    time.sleep(0.5)
+    assert not [mqtt_message for mqtt_message in mqtt_capture.messages if mqtt_message.topic in dev_topics]
+    mqtt_capture.mqtt_client.client.unsubscribe(reply_topic)
+
+    # Clean up the retained values
+    mqtt_capture.mqtt_client.client.unsubscribe(dev_topics)
+    for dev_topic in dev_topics:
+        mqtt_capture.publish(dev_topic, "", retain=True)
+
+
 @pytest.mark.parametrize("device", config.get_by_attribute(p.ATTRIB_VAD))
 @pytest.mark.mqtt_capture_data(config.mqtt)
 def test_mqtt_protocol_read_single_device_vad(mqtt_capture, device) -> None:
@@ -404,3 +584,112 @@ def test_mqtt_protocol_read_family_attribute_missing(mqtt_capture, family_code)
     assert response_request is not None
     assert response_request.get(p.ATTRIB_ACTION) == p.ACTION_READ
     assert response_request.get(p.ATTRIB_FAMILY_CODE) == family_code
+
+
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_read_request_id_pipelined(mqtt_capture) -> None:
+    logger.info("Sending pipelined read requests with request ids to all devices.")
+
+    for request_id, device in enumerate(config.devices):
+        request = json.dumps(
+            {
+                p.ATTRIB_ACTION: p.ACTION_READ,
+                p.ATTRIB_ID: request_id,
+                p.ATTRIB_DEVICE_ID: str(device.device_id),
+                p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+            }
+        )
+        mqtt_capture.publish(config.mqtt.cmd_topic, request)
+
+    mqtt_capture.wait_for_messages(expected_number=len(config.devices))
+
+    # Verify responses. Match them by request id independent of the reception order.
+    responses = {msg.as_json().get(p.ATTRIB_ID): msg.as_json() for msg in mqtt_capture.messages}
+    for request_id, device in enumerate(config.devices):
+        response = responses.get(request_id)
+        assert response is not None
+        TimeUtil.assert_timestamp(response.get(p.ATTRIB_TIME))
+        assert response.get(p.ATTRIB_ACTION) == p.ACTION_READ
+        response_device = response.get(p.ATTRIB_DEVICE)
+        assert response_device is not None
+        assert response_device.get(p.ATTRIB_DEVICE_ID) == str(device.device_id)
+
+
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_read_request_id_error(mqtt_capture) -> None:
+    logger.info("Sending read request with request id and missing device ID.")
+
+    request_id = "req-missing-device-id"
+    request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_READ,
+            p.ATTRIB_ID: request_id,
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, request)
+
+    mqtt_capture.wait_for_messages()
+    response = mqtt_capture.messages[0].as_json()
+
+    # Verify response
+    TimeUtil.assert_timestamp(response.get(p.ATTRIB_TIME))
+    assert response.get(p.ATTRIB_ID) == request_id
+    error = response.get(p.ATTRIB_ERROR)
+    assert error is not None
+    assert error.get(p.ATTRIB_MESSAGE) == "Missing or invalid JSON attributes 'device_id' or 'family_code'."
+
+
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_read_reply_to(mqtt_capture) -> None:
+    logger.info("Sending read request with reply topic.")
+
+    reply_topic = f"{config.mqtt.status_topic}/reply/test"
+    mqtt_capture.mqtt_client.client.subscribe(reply_topic, 0)
+    time.sleep(0.1)
+
+    device = config.devices[0]
+    request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_READ,
+            p.ATTRIB_REPLY_TO: reply_topic,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, request)
+
+    mqtt_capture.wait_for_messages()
+    time.sleep(0.5)  # The response must not be published on the status topic in addition
+
+    # Verify response
+    assert len(mqtt_capture.messages) == 1
+    assert mqtt_capture.messages[0].topic == reply_topic
+    response = mqtt_capture.messages[0].as_json()
+    TimeUtil.assert_timestamp(response.get(p.ATTRIB_TIME))
+    assert response.get(p.ATTRIB_ACTION) == p.ACTION_READ
+    assert response.get(p.ATTRIB_DEVICE).get(p.ATTRIB_DEVICE_ID) == str(device.device_id)
+
+
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_read_reply_to_wildcard(mqtt_capture) -> None:
+    logger.info("Sending read request with invalid reply topic.")
+
+    request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_READ,
+            p.ATTRIB_REPLY_TO: f"{config.mqtt.status_topic}/#",
+            p.ATTRIB_DEVICE_ID: str(config.devices[0].device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, request)
+
+    mqtt_capture.wait_for_messages()
+    response = mqtt_capture.messages[0].as_json()
+
+    # Verify error response on the status topic
+    assert mqtt_capture.messages[0].topic == config.mqtt.status_topic
+    error = response.get(p.ATTRIB_ERROR)
+    assert error is not None
+    assert error.get(p.ATTRIB_MESSAGE) == "Invalid JSON attribute 'reply_to'."
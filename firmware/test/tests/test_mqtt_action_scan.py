@@ -183,3 +183,24 @@ def test_mqtt_protocol_scan_invalid_JSON(mqtt_capture) -> None:
     assert error is not None
     assert error.get(p.ATTRIB_MESSAGE) == "Failed to deserialize MQTT message."
     assert error.get(p.ATTRIB_REQUEST) is None
+
+
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_scan_invalid_deadline(mqtt_capture) -> None:
+    logger.info("Sending scan request with invalid deadline")
+
+    request = json.dumps({p.ATTRIB_ACTION: p.ACTION_SCAN, p.ATTRIB_DEADLINE: "soon"})
+    mqtt_capture.publish(config.mqtt.cmd_topic, request)
+
+    mqtt_capture.wait_for_messages()
+    response = mqtt_capture.messages[0].as_json()
+
+    # Verify response
+    TimeUtil.assert_timestamp(response.get(p.ATTRIB_TIME))
+    error = response.get(p.ATTRIB_ERROR)
+    assert error is not None
+    assert error.get(p.ATTRIB_MESSAGE) == "Invalid JSON attributes 'id' or 'deadline'."
+    response_request = error.get(p.ATTRIB_REQUEST)
+    assert response_request is not None
+    assert response_request.get(p.ATTRIB_ACTION) == p.ACTION_SCAN
+    assert response_request.get(p.ATTRIB_DEADLINE) == "soon"
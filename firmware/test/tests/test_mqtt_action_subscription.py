@@ -1,10 +1,15 @@
 import json
+import time
+import typing as t
+from itertools import pairwise
 
 import pytest
 
 from tests.env.config_model import ConfigModel
+from tests.env.device_config import DeviceConfigFixture, device_config  # noqa: F401
 from tests.env.logger import Logger
 from tests.env.mqtt_fixture import mqtt_capture  # noqa: F401
+from tests.env.mqtt_message import MqttMessage
 from tests.env.mqtt_protocol import MqttProtocol as p
 from tests.env.one_wire_device_def import OneWireDeviceDefinition as ow_dd
 from tests.env.time_util import TimeUtil
@@ -66,6 +71,8 @@ def test_mqtt_protocol_subscription_single_device_presence(mqtt_capture, device)
         assert response_device.get(p.ATTRIB_CHANNEL) == device.channel
         assert response_device.get(p.ATTRIB_DEVICE_ID) == str(device.device_id)
         assert response_device.get(p.ATTRIB_PRESENCE) is True
+        # Known device: no arrival / departure event
+        assert cyclic_read_msg.get(p.ATTRIB_EVENT) is None
 
     # Unsubscribe
     unsubscribe_request = json.dumps(
@@ -91,6 +98,452 @@ def test_mqtt_protocol_subscription_single_device_presence(mqtt_capture, device)
     assert response_device.get(p.ATTRIB_DEVICE_ID) == str(device.device_id)
 
 
+@pytest.mark.parametrize("device", config.devices)
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_subscription_single_device_presence_on_change(mqtt_capture, device) -> None:
+    logger.info(f"Subscribe to changes of attribute 'presence' of device {device.device_id}.")
+
+    interval_ms = 500
+    max_silence_ms = 3000
+
+    subscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_SUBSCRIBE,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+            p.ATTRIB_INTERVAL: interval_ms,
+            p.ATTRIB_ON_CHANGE: True,
+            p.ATTRIB_MAX_SILENCE: max_silence_ms,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, subscribe_request)
+
+    # Subscribe ack + immediate read. Unchanged presence is not published until max_silence is exceeded.
+    mqtt_capture.wait_for_messages(expected_number=2)
+    time.sleep(4 * interval_ms / 1000)
+    assert len(mqtt_capture.messages) == 2
+
+    first_read_msg = mqtt_capture.messages[1].as_json()
+    assert first_read_msg.get(p.ATTRIB_ACTION) == p.ACTION_READ
+    assert first_read_msg.get(p.ATTRIB_DEVICE).get(p.ATTRIB_PRESENCE) is True
+
+    mqtt_capture.wait_for_messages(expected_number=3, timeout=max_silence_ms / 1000 + 2 * interval_ms / 1000)
+    silence_read_msg = mqtt_capture.messages[2].as_json()
+    assert silence_read_msg.get(p.ATTRIB_ACTION) == p.ACTION_READ
+    assert silence_read_msg.get(p.ATTRIB_DEVICE).get(p.ATTRIB_DEVICE_ID) == str(device.device_id)
+
+    # Unsubscribe
+    unsubscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_UNSUBSCRIBE,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, unsubscribe_request)
+
+    mqtt_capture.wait_for_messages(clean_buffer=True)
+    unsubscribe_ack_msg = mqtt_capture.messages[0].as_json()
+    assert unsubscribe_ack_msg.get(p.ATTRIB_ACTION) == p.ACTION_UNSUBSCRIBE
+    assert unsubscribe_ack_msg.get(p.ATTRIB_ACKNOWLEDGE) is True
+
+
+@pytest.mark.skipif(config.hotplug_device is None, reason="No hot-plug device configured in the test environment")
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_subscription_family_presence_events(mqtt_capture) -> None:
+    device = config.hotplug_device
+    family_code = device.device_id.get_family_code()
+    logger.info(f"Subscribe to attribute 'presence' of family {family_code} and unplug / plug in {device.device_id}.")
+
+    interval_ms = 1000
+    operator_timeout_sec = 60
+
+    subscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_SUBSCRIBE,
+            p.ATTRIB_FAMILY_CODE: family_code,
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+            p.ATTRIB_INTERVAL: interval_ms,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, subscribe_request)
+
+    mqtt_capture.wait_for_messages(expected_number=2)  # subscribe ack + immediate read
+    assert mqtt_capture.messages[0].as_json().get(p.ATTRIB_ACKNOWLEDGE) is True
+
+    def is_event(event: str) -> t.Callable[[MqttMessage], bool]:
+        return lambda mqtt_message: (
+            mqtt_message.as_json().get(p.ATTRIB_EVENT) == event
+            and mqtt_message.as_json().get(p.ATTRIB_DEVICE).get(p.ATTRIB_DEVICE_ID) == str(device.device_id)
+        )
+
+    # Departure: Published by the next presence search, in addition to the cyclic result
+    logger.warning(f"Operator: Unplug device {device.device_id} from channel {device.channel} now.")
+    departed_msg = mqtt_capture.wait_for_message(
+        is_event(p.VALUE_EVENT_DEPARTED), timeout=operator_timeout_sec
+    ).as_json()
+    TimeUtil.assert_timestamp(departed_msg.get(p.ATTRIB_TIME))
+    assert departed_msg.get(p.ATTRIB_ACTION) == p.ACTION_READ
+    assert departed_msg.get(p.ATTRIB_FAMILY_CODE) == family_code
+    assert departed_msg.get(p.ATTRIB_DEVICE).get(p.ATTRIB_PRESENCE) is False
+    assert departed_msg.get(p.ATTRIB_DEVICE).get(p.ATTRIB_CHANNEL) is None
+
+    # Arrival
+    logger.warning(f"Operator: Plug device {device.device_id} into channel {device.channel} again now.")
+    arrived_msg = mqtt_capture.wait_for_message(is_event(p.VALUE_EVENT_ARRIVED), timeout=operator_timeout_sec).as_json()
+    TimeUtil.assert_timestamp(arrived_msg.get(p.ATTRIB_TIME))
+    assert arrived_msg.get(p.ATTRIB_ACTION) == p.ACTION_READ
+    assert arrived_msg.get(p.ATTRIB_FAMILY_CODE) == family_code
+    assert arrived_msg.get(p.ATTRIB_DEVICE).get(p.ATTRIB_PRESENCE) is True
+    assert arrived_msg.get(p.ATTRIB_DEVICE).get(p.ATTRIB_CHANNEL) == device.channel
+
+    # Each change is published exactly once
+    events = [mqtt_message.as_json().get(p.ATTRIB_EVENT) for mqtt_message in mqtt_capture.messages]
+    assert events.count(p.VALUE_EVENT_DEPARTED) == 1
+    assert events.count(p.VALUE_EVENT_ARRIVED) == 1
+
+    # Unsubscribe
+    unsubscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_UNSUBSCRIBE,
+            p.ATTRIB_FAMILY_CODE: family_code,
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, unsubscribe_request)
+
+    mqtt_capture.wait_for_message(
+        lambda mqtt_message: mqtt_message.as_json().get(p.ATTRIB_ACTION) == p.ACTION_UNSUBSCRIBE
+    )
+
+
+@pytest.mark.skipif(not config.ethernet_unplug_test, reason="No Ethernet unplug test configured in the test env")
+@pytest.mark.mqtt_capture_data(config.mqtt)
+@pytest.mark.device_config_data(config.web)
+def test_mqtt_protocol_subscription_offline_replay(mqtt_capture, device_config) -> None:
+    device = config.devices[0]
+    logger.info(f"Subscribe to attribute 'presence' of device {device.device_id} and unplug / plug in the Ethernet.")
+
+    interval_ms = 1000
+    replay_rate = 5  # msg/s
+    operator_timeout_sec = 90  # LWT is published by the broker after 1.5 x keep alive
+
+    device_config.apply(
+        {
+            DeviceConfigFixture.MQTT_OFFLINE_BUF_PARAM: "200",
+            DeviceConfigFixture.MQTT_OFFLINE_SPILL_PARAM: None,
+            DeviceConfigFixture.MQTT_REPLAY_RATE_PARAM: str(replay_rate),
+        }
+    )
+
+    subscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_SUBSCRIBE,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+            p.ATTRIB_INTERVAL: interval_ms,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, subscribe_request)
+    mqtt_capture.wait_for_messages(expected_number=2)  # subscribe ack + immediate read
+    assert mqtt_capture.messages[0].as_json().get(p.ATTRIB_ACKNOWLEDGE) is True
+
+    def is_state(state: str) -> t.Callable[[MqttMessage], bool]:
+        return lambda mqtt_message: (
+            mqtt_message.topic == config.mqtt.status_topic
+            and isinstance(mqtt_message.as_json(), dict)
+            and mqtt_message.as_json().get(p.ATTRIB_STATE) == state
+        )
+
+    def is_result(mqtt_message: MqttMessage) -> bool:
+        return mqtt_message.as_json().get(p.ATTRIB_ACTION) == p.ACTION_READ
+
+    # Disconnect: The broker publishes the LWT once the keep alive of the device expired
+    logger.warning("Operator: Unplug the Ethernet cable of the device now.")
+    mqtt_capture.wait_for_message(is_state(p.VALUE_STATE_OFFLINE), timeout=operator_timeout_sec)
+    last_live_result = [mqtt_message for mqtt_message in mqtt_capture.messages if is_result(mqtt_message)][-1]
+    last_live_time = TimeUtil.parse_timestamp(last_live_result.as_json().get(p.ATTRIB_TIME))
+
+    # Reconnect: The results published while disconnected are replayed after the 'online' state
+    mqtt_capture.messages.clear()
+    logger.warning("Operator: Plug in the Ethernet cable of the device again now.")
+    online_msg = mqtt_capture.wait_for_message(is_state(p.VALUE_STATE_ONLINE), timeout=operator_timeout_sec)
+    online_time = TimeUtil.parse_timestamp(online_msg.as_json().get(p.ATTRIB_TIME))
+
+    def replayed_results() -> t.List[dict]:
+        results = [mqtt_message.as_json() for mqtt_message in mqtt_capture.messages if is_result(mqtt_message)]
+        return [
+            result
+            for result in results
+            if last_live_time < TimeUtil.parse_timestamp(result.get(p.ATTRIB_TIME)) < online_time
+        ]
+
+    # The device was offline for at least the keep alive: several results are stored
+    outage_sec = (online_time - last_live_time).total_seconds()
+    expected_replayed = int(outage_sec * 1000 / interval_ms) // 2
+    assert expected_replayed > 1
+    time.sleep(expected_replayed / replay_rate + 2.0)
+
+    replayed = replayed_results()
+    assert len(replayed) >= expected_replayed
+    # Oldest first, each result keeps its original time
+    replayed_times = [TimeUtil.parse_timestamp(result.get(p.ATTRIB_TIME)) for result in replayed]
+    assert replayed_times == sorted(replayed_times)
+    for result in replayed:
+        assert result.get(p.ATTRIB_DEVICE).get(p.ATTRIB_DEVICE_ID) == str(device.device_id)
+
+    # Live results are not delayed by the replay
+    results = [mqtt_message.as_json() for mqtt_message in mqtt_capture.messages if is_result(mqtt_message)]
+    live_results = [result for result in results if TimeUtil.parse_timestamp(result.get(p.ATTRIB_TIME)) > online_time]
+    assert len(live_results) > 0
+
+    # Unsubscribe
+    unsubscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_UNSUBSCRIBE,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, unsubscribe_request)
+
+    mqtt_capture.wait_for_message(
+        lambda mqtt_message: mqtt_message.as_json().get(p.ATTRIB_ACTION) == p.ACTION_UNSUBSCRIBE
+    )
+
+
+@pytest.mark.parametrize("device", config.devices)
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_subscription_single_device_invalid_deadband_type(mqtt_capture, device) -> None:
+    logger.info(f"Subscribe with invalid deadband type to device {device.device_id}.")
+
+    subscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_SUBSCRIBE,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+            p.ATTRIB_INTERVAL: 1000,
+            p.ATTRIB_DEADBAND: 0.5,
+            p.ATTRIB_DEADBAND_TYPE: "INVALID",
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, subscribe_request)
+
+    mqtt_capture.wait_for_messages()
+
+    # Verify error response
+    error_response_msg = mqtt_capture.messages[0].as_json()
+
+    TimeUtil.assert_timestamp(error_response_msg.get(p.ATTRIB_TIME))
+    error = error_response_msg.get(p.ATTRIB_ERROR)
+    assert error is not None
+    assert error.get(p.ATTRIB_MESSAGE) == (
+        "Invalid JSON attributes 'on_change', 'deadband', 'deadband_type' or 'max_silence'."
+    )
+    error_request = error.get(p.ATTRIB_REQUEST)
+    assert error_request is not None
+    assert error_request.get(p.ATTRIB_ACTION) == p.ACTION_SUBSCRIBE
+    assert error_request.get(p.ATTRIB_DEADBAND_TYPE) == "INVALID"
+
+
+@pytest.mark.parametrize("device", config.devices)
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_subscription_single_device_presence_window(mqtt_capture, device) -> None:
+    logger.info(f"Subscribe to aggregated attribute 'presence' of device {device.device_id}.")
+
+    sample_interval_ms = 500
+    publish_interval_ms = 3000
+
+    subscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_SUBSCRIBE,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+            p.ATTRIB_SAMPLE_INTERVAL: sample_interval_ms,
+            p.ATTRIB_PUBLISH_INTERVAL: publish_interval_ms,
+            p.ATTRIB_AGGREGATES: [p.ATTRIB_MEAN, p.ATTRIB_COUNT],
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, subscribe_request)
+
+    # Subscribe ack only. The reads are aggregated until the end of the window.
+    mqtt_capture.wait_for_messages()
+    assert mqtt_capture.messages[0].as_json().get(p.ATTRIB_ACKNOWLEDGE) is True
+
+    # The first window may be shortened by the alignment. Wait for the first full window.
+    mqtt_capture.wait_for_messages(expected_number=3, timeout=2 * publish_interval_ms / 1000 + 1)
+    window_msg = mqtt_capture.messages[2].as_json()
+    TimeUtil.assert_timestamp(window_msg.get(p.ATTRIB_TIME))
+    assert window_msg.get(p.ATTRIB_ACTION) == p.ACTION_READ
+    assert window_msg.get(p.ATTRIB_WINDOW) == publish_interval_ms
+    json_device = window_msg.get(p.ATTRIB_DEVICE)
+    assert json_device.get(p.ATTRIB_DEVICE_ID) == str(device.device_id)
+    aggregates = json_device.get(p.ATTRIB_PRESENCE)
+    assert set(aggregates.keys()) == {p.ATTRIB_MEAN, p.ATTRIB_COUNT}
+    assert aggregates.get(p.ATTRIB_MEAN) == pytest.approx(1.0)
+    assert publish_interval_ms / sample_interval_ms - 1 <= aggregates.get(p.ATTRIB_COUNT)
+    assert aggregates.get(p.ATTRIB_COUNT) <= publish_interval_ms / sample_interval_ms + 1
+
+    # Unsubscribe
+    unsubscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_UNSUBSCRIBE,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, unsubscribe_request)
+
+    mqtt_capture.wait_for_messages(clean_buffer=True)
+    unsubscribe_ack_msg = mqtt_capture.messages[0].as_json()
+    assert unsubscribe_ack_msg.get(p.ATTRIB_ACTION) == p.ACTION_UNSUBSCRIBE
+    assert unsubscribe_ack_msg.get(p.ATTRIB_ACKNOWLEDGE) is True
+
+
+@pytest.mark.parametrize("device", config.devices[:1])
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_subscription_single_device_aggregate_with_filter(mqtt_capture, device) -> None:
+    logger.info(f"Subscribe with aggregation and change filter to device {device.device_id}.")
+
+    subscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_SUBSCRIBE,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+            p.ATTRIB_SAMPLE_INTERVAL: 1000,
+            p.ATTRIB_PUBLISH_INTERVAL: 10000,
+            p.ATTRIB_DEADBAND: 0.5,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, subscribe_request)
+
+    mqtt_capture.wait_for_messages()
+    time.sleep(1.5)  # No subscription: no cyclic read follows the error
+
+    # Verify error response
+    assert len(mqtt_capture.messages) == 1
+    error_response_msg = mqtt_capture.messages[0].as_json()
+    TimeUtil.assert_timestamp(error_response_msg.get(p.ATTRIB_TIME))
+    error = error_response_msg.get(p.ATTRIB_ERROR)
+    assert error is not None
+    assert error.get(p.ATTRIB_MESSAGE) == "Filter ('on_change', 'deadband') and aggregation cannot be combined."
+
+
+@pytest.mark.parametrize("device", config.devices)
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_subscription_single_device_invalid_aggregate(mqtt_capture, device) -> None:
+    logger.info(f"Subscribe with invalid aggregate to device {device.device_id}.")
+
+    subscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_SUBSCRIBE,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+            p.ATTRIB_SAMPLE_INTERVAL: 1000,
+            p.ATTRIB_PUBLISH_INTERVAL: 10000,
+            p.ATTRIB_AGGREGATES: ["INVALID"],
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, subscribe_request)
+
+    mqtt_capture.wait_for_messages()
+
+    # Verify error response
+    error_response_msg = mqtt_capture.messages[0].as_json()
+
+    TimeUtil.assert_timestamp(error_response_msg.get(p.ATTRIB_TIME))
+    error = error_response_msg.get(p.ATTRIB_ERROR)
+    assert error is not None
+    assert error.get(p.ATTRIB_MESSAGE) == "Invalid JSON attributes 'publish_interval' or 'aggregates'."
+    error_request = error.get(p.ATTRIB_REQUEST)
+    assert error_request is not None
+    assert error_request.get(p.ATTRIB_AGGREGATES) == ["INVALID"]
+
+
+@pytest.mark.parametrize("device", config.devices)
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_subscription_single_device_invalid_adaptive_interval(mqtt_capture, device) -> None:
+    logger.info(f"Subscribe with min_interval > max_interval to device {device.device_id}.")
+
+    subscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_SUBSCRIBE,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+            p.ATTRIB_INTERVAL: 1000,
+            p.ATTRIB_MIN_INTERVAL: 5000,
+            p.ATTRIB_MAX_INTERVAL: 1000,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, subscribe_request)
+
+    mqtt_capture.wait_for_messages()
+
+    # Verify error response
+    error_response_msg = mqtt_capture.messages[0].as_json()
+
+    TimeUtil.assert_timestamp(error_response_msg.get(p.ATTRIB_TIME))
+    error = error_response_msg.get(p.ATTRIB_ERROR)
+    assert error is not None
+    assert error.get(p.ATTRIB_MESSAGE) == "Invalid JSON attributes 'min_interval', 'max_interval' or 'adaptive_delta'."
+    error_request = error.get(p.ATTRIB_REQUEST)
+    assert error_request is not None
+    assert error_request.get(p.ATTRIB_MIN_INTERVAL) == 5000
+
+
+@pytest.mark.parametrize("device", config.devices)
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_subscription_single_device_adaptive_interval_grows(mqtt_capture, device) -> None:
+    logger.info(f"Subscribe with adaptive interval to the flat attribute 'presence' of device {device.device_id}.")
+
+    min_interval_ms = 500
+    max_interval_ms = 2000
+
+    subscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_SUBSCRIBE,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+            p.ATTRIB_INTERVAL: min_interval_ms,
+            p.ATTRIB_MIN_INTERVAL: min_interval_ms,
+            p.ATTRIB_MAX_INTERVAL: max_interval_ms,
+            p.ATTRIB_ADAPTIVE_DELTA: 0.5,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, subscribe_request)
+
+    # Flat values double the interval after every read: 500 -> 1000 -> 2000 ms, then it stays at max_interval
+    expected_reads = 6
+    mqtt_capture.wait_for_messages(
+        expected_number=expected_reads + 1, timeout=(expected_reads + 1) * max_interval_ms / 1000
+    )
+    assert mqtt_capture.messages[0].as_json().get(p.ATTRIB_ACKNOWLEDGE) is True
+
+    read_msgs = [mqtt_message.as_json() for mqtt_message in mqtt_capture.messages[1 : expected_reads + 1]]
+    read_times = [TimeUtil.parse_timestamp(read_msg.get(p.ATTRIB_TIME)) for read_msg in read_msgs]
+    gaps_ms = [(later - earlier).total_seconds() * 1000 for earlier, later in pairwise(read_times)]
+    logger.info(f"Gaps between the reads: {gaps_ms} ms")
+
+    assert gaps_ms[0] < max_interval_ms - 250
+    for gap_ms in gaps_ms[-2:]:
+        assert gap_ms == pytest.approx(max_interval_ms, abs=250)
+
+    # Unsubscribe
+    unsubscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_UNSUBSCRIBE,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, unsubscribe_request)
+
+    mqtt_capture.wait_for_messages(clean_buffer=True)
+    unsubscribe_ack_msg = mqtt_capture.messages[0].as_json()
+    assert unsubscribe_ack_msg.get(p.ATTRIB_ACTION) == p.ACTION_UNSUBSCRIBE
+    assert unsubscribe_ack_msg.get(p.ATTRIB_ACKNOWLEDGE) is True
+
+
 @pytest.mark.parametrize("device", config.get_by_attribute(p.ATTRIB_TEMPERATURE))
 @pytest.mark.mqtt_capture_data(config.mqtt)
 def test_mqtt_protocol_subscription_single_device_temperature(mqtt_capture, device) -> None:
@@ -164,6 +617,63 @@ def test_mqtt_protocol_subscription_single_device_temperature(mqtt_capture, devi
     assert response_device.get(p.ATTRIB_DEVICE_ID) == str(device.device_id)
 
 
+@pytest.mark.parametrize("device", config.get_by_attribute(p.ATTRIB_TEMPERATURE))
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_subscription_single_device_temperature_interval_grid(mqtt_capture, device) -> None:
+    logger.info(f"Subscribe to attribute 'temperature' of device {device.device_id} and check the times of the reads.")
+
+    interval_ms = 2000
+    tolerance_ms = 150
+
+    subscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_SUBSCRIBE,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_TEMPERATURE,
+            p.ATTRIB_INTERVAL: interval_ms,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, subscribe_request)
+
+    expected_cyclic_reads = 4
+    expected_total_messages = expected_cyclic_reads + 2  # +2: subscribe ack + immediate read
+    mqtt_capture.wait_for_messages(
+        expected_number=expected_total_messages,
+        timeout=(expected_cyclic_reads + 1) * interval_ms / 1000 + 1.0,  # +1.0 for temp. sampling time
+    )
+    assert len(mqtt_capture.messages) == expected_total_messages
+    assert mqtt_capture.messages[0].as_json().get(p.ATTRIB_ACKNOWLEDGE) is True
+
+    # The conversion is started ahead of the tick, the result is read at the tick: The cyclic results are published
+    # on the interval grid, not one conversion time (up to 750 ms) late or early.
+    cyclic_read_msgs = [mqtt_message.as_json() for mqtt_message in mqtt_capture.messages[-expected_cyclic_reads:]]
+    for cyclic_read_msg in cyclic_read_msgs:
+        assert cyclic_read_msg.get(p.ATTRIB_ACTION) == p.ACTION_READ
+        ow_dd.assert_temperature_range(cyclic_read_msg.get(p.ATTRIB_DEVICE).get(p.ATTRIB_TEMPERATURE))
+
+    read_times = [TimeUtil.parse_timestamp(cyclic_read_msg.get(p.ATTRIB_TIME)) for cyclic_read_msg in cyclic_read_msgs]
+    offsets_ms = [(read_time - read_times[0]).total_seconds() * 1000 for read_time in read_times]
+    logger.info(f"Times of the reads relative to the first cyclic read: {offsets_ms} ms")
+
+    for index, offset_ms in enumerate(offsets_ms):
+        assert offset_ms == pytest.approx(index * interval_ms, abs=tolerance_ms)
+
+    # Unsubscribe
+    unsubscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_UNSUBSCRIBE,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_TEMPERATURE,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, unsubscribe_request)
+
+    mqtt_capture.wait_for_messages(clean_buffer=True)
+    unsubscribe_ack_msg = mqtt_capture.messages[0].as_json()
+    assert unsubscribe_ack_msg.get(p.ATTRIB_ACTION) == p.ACTION_UNSUBSCRIBE
+    assert unsubscribe_ack_msg.get(p.ATTRIB_ACKNOWLEDGE) is True
+
+
 @pytest.mark.parametrize("device", config.devices)
 @pytest.mark.mqtt_capture_data(config.mqtt)
 def test_mqtt_protocol_subscription_single_device_already_subscribed(mqtt_capture, device) -> None:
@@ -502,3 +1012,208 @@ def test_mqtt_protocol_subscription_family_invalid_attribute(mqtt_capture, famil
     assert error_request.get(p.ATTRIB_ATTRIBUTE) == unknown_attribute
     assert error_request.get(p.ATTRIB_FAMILY_CODE) == family_code
     assert error_request.get(p.ATTRIB_INTERVAL) == interval
+
+
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_subscription_all_devices_temperature(mqtt_capture) -> None:
+    logger.info("Subscribe / Unsubscribe to attribute 'temperature' of all devices.")
+
+    interval_ms = 3000
+    expected_devices = config.get_by_attribute(p.ATTRIB_TEMPERATURE)
+
+    subscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_SUBSCRIBE,
+            p.ATTRIB_DEVICE_ID: p.ATTRIB_WILDCARD,
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_TEMPERATURE,
+            p.ATTRIB_INTERVAL: interval_ms,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, subscribe_request)
+
+    # Subscribe ack + one merged read of all families
+    mqtt_capture.wait_for_messages(expected_number=2, timeout=interval_ms / 1000)
+    assert len(mqtt_capture.messages) == 2
+
+    subscribe_ack_msg = mqtt_capture.messages[0].as_json()
+    assert subscribe_ack_msg.get(p.ATTRIB_ACTION) == p.ACTION_SUBSCRIBE
+    assert subscribe_ack_msg.get(p.ATTRIB_ACKNOWLEDGE) is True
+    assert subscribe_ack_msg.get(p.ATTRIB_DEVICE).get(p.ATTRIB_DEVICE_ID) == p.ATTRIB_WILDCARD
+
+    read_msg = mqtt_capture.messages[1].as_json()
+    TimeUtil.assert_timestamp(read_msg.get(p.ATTRIB_TIME))
+    assert read_msg.get(p.ATTRIB_ACTION) == p.ACTION_READ
+    response_devices = read_msg.get(p.ATTRIB_DEVICES)
+    assert response_devices is not None
+    assert len(response_devices) == len(expected_devices)
+    for expected_device in expected_devices:
+        match = next((d for d in response_devices if d[p.ATTRIB_DEVICE_ID] == str(expected_device.device_id)), None)
+        assert match is not None
+        assert match.get(p.ATTRIB_CHANNEL) == expected_device.channel
+        assert isinstance(match.get(p.ATTRIB_TEMPERATURE), float)
+
+    # Unsubscribe
+    unsubscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_UNSUBSCRIBE,
+            p.ATTRIB_DEVICE_ID: p.ATTRIB_WILDCARD,
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_TEMPERATURE,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, unsubscribe_request)
+
+    mqtt_capture.wait_for_messages(clean_buffer=True)
+    unsubscribe_ack_msg = mqtt_capture.messages[0].as_json()
+    assert unsubscribe_ack_msg.get(p.ATTRIB_ACTION) == p.ACTION_UNSUBSCRIBE
+    assert unsubscribe_ack_msg.get(p.ATTRIB_ACKNOWLEDGE) is True
+
+
+@pytest.mark.parametrize("device", config.devices[:1])
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_subscription_single_device_fragmented_request(mqtt_capture, device) -> None:
+    logger.info(f"Subscribe to attribute 'presence' of device {device.device_id} by a request exceeding a TCP segment.")
+
+    interval_ms = 1000
+    padding_length = 3 * 1024  # > TCP segment (MSS ~1460 bytes): delivered in fragments
+
+    subscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_SUBSCRIBE,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+            p.ATTRIB_INTERVAL: interval_ms,
+            "padding": "x" * padding_length,  # Unknown attributes are ignored
+        }
+    )
+    assert len(subscribe_request) > padding_length
+    mqtt_capture.publish(config.mqtt.cmd_topic, subscribe_request)
+
+    mqtt_capture.wait_for_messages(expected_number=2)  # subscribe ack + immediate read
+
+    subscribe_ack_msg = mqtt_capture.messages[0].as_json()
+    TimeUtil.assert_timestamp(subscribe_ack_msg.get(p.ATTRIB_TIME))
+    assert subscribe_ack_msg.get(p.ATTRIB_ACTION) == p.ACTION_SUBSCRIBE
+    assert subscribe_ack_msg.get(p.ATTRIB_ACKNOWLEDGE) is True
+    assert subscribe_ack_msg.get(p.ATTRIB_DEVICE).get(p.ATTRIB_DEVICE_ID) == str(device.device_id)
+
+    immediate_read_msg = mqtt_capture.messages[1].as_json()
+    assert immediate_read_msg.get(p.ATTRIB_ACTION) == p.ACTION_READ
+    assert immediate_read_msg.get(p.ATTRIB_DEVICE).get(p.ATTRIB_PRESENCE) is True
+
+    # Unsubscribe
+    unsubscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_UNSUBSCRIBE,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, unsubscribe_request)
+
+    unsubscribe_ack_msg = mqtt_capture.wait_for_message(
+        lambda mqtt_message: mqtt_message.as_json().get(p.ATTRIB_ACTION) == p.ACTION_UNSUBSCRIBE
+    ).as_json()
+    assert unsubscribe_ack_msg.get(p.ATTRIB_ACKNOWLEDGE) is True
+
+
+@pytest.mark.parametrize("device", config.devices[:1])
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_subscription_single_device_oversized_request(mqtt_capture, device) -> None:
+    logger.info(f"Subscribe to attribute 'presence' of device {device.device_id} by a request exceeding 8 KB.")
+
+    interval_ms = 1000
+    max_payload_size = 8 * 1024  # Max. size of a received message. Larger messages are discarded silently.
+
+    subscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_SUBSCRIBE,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+            p.ATTRIB_INTERVAL: interval_ms,
+            "padding": "x" * max_payload_size,
+        }
+    )
+    assert len(subscribe_request) > max_payload_size
+    mqtt_capture.publish(config.mqtt.cmd_topic, subscribe_request)
+
+    # Discarded: Neither an ack nor an error response, no subscription
+    time.sleep(3.0)
+    assert len(mqtt_capture.messages) == 0
+
+    # The next request is processed as usual
+    read_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_READ,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, read_request)
+
+    mqtt_capture.wait_for_messages()
+    read_response = mqtt_capture.messages[0].as_json()
+    assert read_response.get(p.ATTRIB_ACTION) == p.ACTION_READ
+    assert read_response.get(p.ATTRIB_DEVICE).get(p.ATTRIB_PRESENCE) is True
+
+    # Only the single read response: the discarded subscribe created no subscription
+    time.sleep(2 * interval_ms / 1000)
+    assert len(mqtt_capture.messages) == 1
+
+
+@pytest.mark.parametrize("device", config.devices[:1])
+@pytest.mark.mqtt_capture_data(config.mqtt)
+def test_mqtt_protocol_subscription_single_device_reply_to_conflict(mqtt_capture, device) -> None:
+    logger.info(f"Subscribe to attribute 'presence' of device {device.device_id} from two reply topics.")
+
+    interval_ms = 5000
+    reply_topic_first = f"{config.mqtt.status_topic}/reply/first"
+    reply_topic_second = f"{config.mqtt.status_topic}/reply/second"
+    mqtt_capture.mqtt_client.client.subscribe([(reply_topic_first, 0), (reply_topic_second, 0)])
+    time.sleep(0.1)
+
+    def subscribe_request(reply_topic: str) -> str:
+        return json.dumps(
+            {
+                p.ATTRIB_ACTION: p.ACTION_SUBSCRIBE,
+                p.ATTRIB_REPLY_TO: reply_topic,
+                p.ATTRIB_DEVICE_ID: str(device.device_id),
+                p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+                p.ATTRIB_INTERVAL: interval_ms,
+            }
+        )
+
+    mqtt_capture.publish(config.mqtt.cmd_topic, subscribe_request(reply_topic_first))
+    subscribe_ack_msg = mqtt_capture.wait_for_message(
+        lambda mqtt_message: mqtt_message.as_json().get(p.ATTRIB_ACTION) == p.ACTION_SUBSCRIBE
+    )
+    assert subscribe_ack_msg.topic == reply_topic_first
+    assert subscribe_ack_msg.as_json().get(p.ATTRIB_ACKNOWLEDGE) is True
+
+    # The second requester must not take over the subscription
+    mqtt_capture.messages.clear()
+    mqtt_capture.publish(config.mqtt.cmd_topic, subscribe_request(reply_topic_second))
+    error_msg = mqtt_capture.wait_for_message(
+        lambda mqtt_message: mqtt_message.as_json().get(p.ATTRIB_ERROR) is not None
+    )
+    assert error_msg.topic == reply_topic_second
+    assert (
+        error_msg.as_json().get(p.ATTRIB_ERROR).get(p.ATTRIB_MESSAGE)
+        == "Already subscribed with a different reply topic. Unsubscribe first."
+    )
+
+    # Unsubscribe
+    unsubscribe_request = json.dumps(
+        {
+            p.ATTRIB_ACTION: p.ACTION_UNSUBSCRIBE,
+            p.ATTRIB_REPLY_TO: reply_topic_first,
+            p.ATTRIB_DEVICE_ID: str(device.device_id),
+            p.ATTRIB_ATTRIBUTE: p.ATTRIB_PRESENCE,
+        }
+    )
+    mqtt_capture.publish(config.mqtt.cmd_topic, unsubscribe_request)
+
+    unsubscribe_ack_msg = mqtt_capture.wait_for_message(
+        lambda mqtt_message: mqtt_message.as_json().get(p.ATTRIB_ACTION) == p.ACTION_UNSUBSCRIBE
+    )
+    assert unsubscribe_ack_msg.topic == reply_topic_first
+    assert unsubscribe_ack_msg.as_json().get(p.ATTRIB_ACKNOWLEDGE) is True